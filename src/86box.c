@@ -143,6 +143,7 @@ int video_fps = RENDER_FPS; /* (O) render speed in fps */
 #endif
 int settings_only     = 0; /* (O) show only the settings dialog */
 int confirm_exit_cmdl = 1; /* (O) do not ask for confirmation on quit if set to 0 */
+int unthrottled       = 0; /* (O) run as fast as the host allows */
 #ifdef _WIN32
 uint64_t unique_id   = 0;
 uint64_t source_hwnd = 0;
@@ -203,6 +204,25 @@ int      cpu_use_dynarec                        = 0;              /* (C) cpu use
 int      cpu                                    = 0;              /* (C) cpu type */
 int      fpu_type                               = 0;              /* (C) fpu type */
 int      fpu_softfloat                          = 0;              /* (C) fpu uses softfloat */
+int      dynarec_blocks                         = 0;              /* (C) dynarec code block pool size,
+                                                                         0 = default */
+int      dynarec_mem_blocks                     = 0;              /* (C) dynarec code memory pool size,
+                                                                         0 = default */
+int      dynarec_perf_map                       = 0;              /* (C) write profiler symbols for
+                                                                         dynarec code, 1 = perf map,
+                                                                         2 = jitdump */
+int      dynarec_async_compile                  = 0;              /* (C) compile hot dynarec blocks on
+                                                                         a background thread */
+int      mem_huge_pages                         = 0;              /* (C) back guest RAM with huge pages,
+                                                                         1 = transparent, 2 = hugetlbfs */
+int      mem_merge_pages                        = 0;              /* (C) let KSM merge identical guest
+                                                                         RAM pages across instances */
+int      rom_share                              = 0;              /* (C) map ROM images from their files
+                                                                         so instances share them */
+int      cpu_idle_skip                          = 1;              /* (C) skip ahead to the next timer
+                                                                         event when the guest is idle */
+int      pace_slice_ms                          = 10;             /* (C) emulated time run per slice,
+                                                                         in milliseconds */
 int      time_sync                              = 0;              /* (C) enable time sync */
 int      confirm_reset                          = 1;              /* (C) enable reset confirmation */
 int      confirm_exit                           = 1;              /* (C) enable exit confirmation */
@@ -633,6 +653,7 @@ pc_show_usage(char *s)
 #endif
             "-T or --testmode\t\t- test mode: execute the test mode entry\n"
             "\t\t\t\t   point on init/hard reset\n"
+            "-U or --unthrottled\t\t- run as fast as possible, without sound\n"
             "-V or --vmname name\t\t- overrides the name of the running VM\n"
             "-W or --nohook\t\t- disables keyboard hook\n"
             "\t\t\t\t   (compatibility-only outside Windows)\n"
@@ -810,6 +831,8 @@ usage:
 #endif
         } else if (!strcasecmp(argv[c], "--testmode") || !strcasecmp(argv[c], "-T")) {
             test_mode = 1;
+        } else if (!strcasecmp(argv[c], "--unthrottled") || !strcasecmp(argv[c], "-U")) {
+            unthrottled = 1;
         } else if (!strcasecmp(argv[c], "--noconfirm") || !strcasecmp(argv[c], "-N")) {
             confirm_exit_cmdl = 0;
         } else if (!strcasecmp(argv[c], "--missing") || !strcasecmp(argv[c], "-M")) {
@@ -1699,9 +1722,11 @@ pc_run(void)
     /* Update the guest-CPU independent timer for devices with independent clock speed */
     rivatimer_update_all();
 
+    mem_dtlb_attach();
+
     /* Run a block of code. */
     startblit();
-    cpu_exec((int32_t) cpu_s->rspeed / 100);
+    cpu_exec((int32_t) (((uint64_t) cpu_s->rspeed * pace_slice_ms) / 1000));
     ack_pause();
 #ifdef USE_GDBSTUB /* avoid a KBC FIFO overflow when CPU emulation is stalled */
     if (gdbstub_step == GDBSTUB_EXEC) {
@@ -1714,9 +1739,10 @@ pc_run(void)
     joystick_process();
     endblit();
 
-    /* Done with this frame, update statistics. */
-    framecount++;
-    if (++framecountx >= 100) {
+    /* Done with this frame, update statistics in emulated milliseconds. */
+    framecount += pace_slice_ms;
+    framecountx += pace_slice_ms;
+    if (framecountx >= 1000) {
         framecountx = 0;
         frames      = 0;
     }
@@ -1742,10 +1768,17 @@ pc_run(void)
 void
 pc_onesec(void)
 {
-    fps        = framecount;
+    /* Emulated time run in the last second, as a percentage. */
+    fps        = framecount / 10;
     framecount = 0;
 
     title_update = 1;
+
+    cpu_idle_onesec();
+
+#if defined(USE_DYNAREC) && defined(USE_NEW_DYNAREC)
+    codegen_stats_onesec();
+#endif
 }
 
 void
@@ -1925,6 +1925,33 @@ acpi_reg_read_common(int size, uint16_t addr, void *priv)
             break;
     }
 
+    /* Reading P_LVL2 or P_LVL3, after PCNTRL, enters C2 or C3 until an
+       interrupt, masked or not, so skip ahead like a HLT. The offset is
+       taken within the vendor's whole register block, so that the other
+       registers it aliases to with the 0x3f mask do not count. */
+    if ((size == 1) && !pic.int_pending) {
+        uint8_t reg;
+
+        switch (dev->vendor) {
+            case VEN_ALI:
+            case VEN_INTEL:
+                reg = addr & 0x3f;
+                break;
+            case VEN_VIA:
+                reg = addr & 0xff;
+                break;
+            case VEN_VIA_596B:
+                reg = addr & 0x7f;
+                break;
+            default:
+                reg = 0x00;
+                break;
+        }
+
+        if ((reg == 0x14) || (reg == 0x15))
+            cycles -= cpu_idle(1);
+    }
+
     return ret;
 }
 
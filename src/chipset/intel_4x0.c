@@ -254,6 +254,9 @@ i4x0_write(int func, int addr, uint8_t val, void *priv)
     if (func > 0)
         return;
 
+    /* PAM and SMRAM changes are recalculated together. */
+    mem_mapping_batch_begin();
+
     if (func == 0)
         switch (addr) {
             case 0x04: /*Command register*/
@@ -1534,6 +1537,8 @@ i4x0_write(int func, int addr, uint8_t val, void *priv)
             default:
                 break;
         }
+
+    mem_mapping_batch_commit();
 }
 
 static uint8_t
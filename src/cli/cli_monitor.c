@@ -17,6 +17,7 @@
  *          Copyright 2021-2025 RichardG.
  */
 #include <errno.h>
+#include <inttypes.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -29,6 +30,7 @@
 #    include <unistd.h>
 #endif
 #include <86box/86box.h>
+#include "cpu.h"
 #include <86box/cartridge.h>
 #include <86box/scsi_device.h>
 #include <86box/cdrom.h>
@@ -36,7 +38,9 @@
 #include <86box/config.h>
 #include <86box/device.h>
 #include <86box/timer.h>
+#include <86box/pace.h>
 #include <86box/fdd.h>
+#include <86box/mem.h>
 #include <86box/mo.h>
 #include <86box/plat.h>
 #include <86box/plat_dir.h>
@@ -45,6 +49,9 @@
 #include <86box/version.h>
 #include <86box/video.h>
 #include <86box/zip.h>
+#if defined(USE_DYNAREC) && defined(USE_NEW_DYNAREC)
+#    include "codegen_public.h"
+#endif
 
 #define MONITOR_CMD_EXIT      0x01
 #define MONITOR_CMD_UNBOUNDED 0x02
@@ -507,6 +514,300 @@ cli_monitor_screenshot(int argc, char **argv, const void *priv)
     thread_destroy_event(screenshot_event);
 }
 
+#if defined(USE_DYNAREC) && defined(USE_NEW_DYNAREC)
+static void
+cli_monitor_dynstats(int argc, char **argv, const void *priv)
+{
+    /* Print statistics if no action was provided. */
+    if (argc < 1) {
+        codegen_stats_print(CLI_RENDER_OUTPUT, 16);
+        return;
+    }
+
+    /* Parse numeric argument for actions which take one. */
+    int value = (argc >= 2) ? atoi(argv[2]) : 0;
+
+    if (!stricmp(argv[1], "on") || !stricmp(argv[1], "off")) {
+        codegen_stats_enable(!stricmp(argv[1], "on"));
+        fprintf(CLI_RENDER_OUTPUT, "Dynarec statistics collection %s.\n", codegen_stats_enabled ? "enabled" : "disabled");
+    } else if (!stricmp(argv[1], "reset")) {
+        codegen_stats_reset();
+        fprintf(CLI_RENDER_OUTPUT, "Dynarec statistics reset.\n");
+    } else if (!stricmp(argv[1], "log")) {
+        if (value < 0)
+            value = 0;
+        codegen_stats_log_interval = value;
+        if (value) {
+            /* Logging implies collection. */
+            codegen_stats_enable(1);
+            fprintf(CLI_RENDER_OUTPUT, "Logging dynarec statistics every %d seconds.\n", value);
+        } else {
+            fprintf(CLI_RENDER_OUTPUT, "Periodic dynarec statistics logging disabled.\n");
+        }
+    } else if (!stricmp(argv[1], "top")) {
+        codegen_stats_print(CLI_RENDER_OUTPUT, (argc >= 2) ? value : 16);
+    } else {
+        fprintf(CLI_RENDER_OUTPUT, "Unknown action: %s\n", argv[1]);
+    }
+}
+#endif
+
+static void
+cli_monitor_tlbstats(int argc, char **argv, const void *priv)
+{
+    static uint64_t dtlb_base = 0;
+
+    if (argc >= 1) {
+        if (!stricmp(argv[1], "reset")) {
+            memset(&tlb_stats, 0, sizeof(tlb_stats));
+            if (!mem_dtlb_read(&dtlb_base))
+                dtlb_base = 0;
+            fprintf(CLI_RENDER_OUTPUT, "TLB statistics reset.\n");
+        } else {
+            fprintf(CLI_RENDER_OUTPUT, "Unknown action: %s\n", argv[1]);
+        }
+        return;
+    }
+
+    uint64_t fills = tlb_stats.read_fills + tlb_stats.write_fills;
+
+    fprintf(CLI_RENDER_OUTPUT, "TLB: %d sets of %d ways\n", TLB_SETS, TLB_WAYS);
+#ifdef USE_TLB_STATS
+    uint64_t lookups = tlb_stats.read_lookups + tlb_stats.write_lookups;
+    int      counted = 1;
+
+#    if defined(USE_DYNAREC) && !(defined(USE_NEW_DYNAREC) && (defined __amd64__ || defined _M_X64 || defined __aarch64__ || defined _M_ARM64))
+    /* This recompiler does its lookups inline, without counting them. */
+    counted = !cpu_use_dynarec;
+#    endif
+    fprintf(CLI_RENDER_OUTPUT, "Lookups:         %" PRIu64 " (%" PRIu64 " read, %" PRIu64 " write)\n", lookups, tlb_stats.read_lookups, tlb_stats.write_lookups);
+    if (!counted)
+        fprintf(CLI_RENDER_OUTPUT, "Miss rate:       n/a (recompiled code does not count lookups)\n");
+    else if (lookups)
+        fprintf(CLI_RENDER_OUTPUT, "Miss rate:       %.3f%% (%.3f%% read, %.3f%% write)\n", (100.0 * fills) / lookups,
+                tlb_stats.read_lookups ? ((100.0 * tlb_stats.read_fills) / tlb_stats.read_lookups) : 0.0,
+                tlb_stats.write_lookups ? ((100.0 * tlb_stats.write_fills) / tlb_stats.write_lookups) : 0.0);
+    else
+        fprintf(CLI_RENDER_OUTPUT, "Miss rate:       n/a (no lookups)\n");
+#else
+    fprintf(CLI_RENDER_OUTPUT, "Lookups:         not counted (build with TLBSTATS for a miss rate)\n");
+#endif
+    fprintf(CLI_RENDER_OUTPUT, "Page walks:      %" PRIu64 "\n", tlb_stats.walks);
+    fprintf(CLI_RENDER_OUTPUT, "Fills:           %" PRIu64 " (%" PRIu64 " read, %" PRIu64 " write)\n", fills, tlb_stats.read_fills, tlb_stats.write_fills);
+    fprintf(CLI_RENDER_OUTPUT, "Evictions:       %" PRIu64 " (%.1f%% of fills)\n", tlb_stats.evictions, fills ? ((100.0 * tlb_stats.evictions) / fills) : 0.0);
+    fprintf(CLI_RENDER_OUTPUT, "Full flushes:    %" PRIu64 "\n", tlb_stats.flushes);
+    fprintf(CLI_RENDER_OUTPUT, "CR3 flushes:     %" PRIu64 " (%" PRIu64 " global entries kept)\n", tlb_stats.cr3_flushes, tlb_stats.global_kept);
+    fprintf(CLI_RENDER_OUTPUT, "INVLPGs:         %" PRIu64 "\n", tlb_stats.invlpgs);
+    fprintf(CLI_RENDER_OUTPUT, "SMM switches:    %" PRIu64 "\n", tlb_stats.smm_switches);
+
+    uint64_t dtlb_misses;
+    if (mem_dtlb_read(&dtlb_misses))
+        fprintf(CLI_RENDER_OUTPUT, "Host dTLB misses: %" PRIu64 " (emulation thread)\n", dtlb_misses - dtlb_base);
+    else
+        fprintf(CLI_RENDER_OUTPUT, "Host dTLB misses: not available\n");
+}
+
+static void
+cli_monitor_mapstats(int argc, char **argv, const void *priv)
+{
+    if (argc >= 1) {
+        if (!stricmp(argv[1], "reset")) {
+            memset(&mem_mapping_stats, 0, sizeof(mem_mapping_stats));
+            fprintf(CLI_RENDER_OUTPUT, "Memory mapping statistics reset.\n");
+        } else {
+            fprintf(CLI_RENDER_OUTPUT, "Unknown action: %s\n", argv[1]);
+        }
+        return;
+    }
+
+    uint64_t recalcs = mem_mapping_stats.recalcs;
+
+    fprintf(CLI_RENDER_OUTPUT, "Recalculations:  %" PRIu64 " (%" PRIu64 " more merged into %" PRIu64 " batches)\n",
+            recalcs, mem_mapping_stats.deferred, mem_mapping_stats.batches);
+    fprintf(CLI_RENDER_OUTPUT, "Granules:        %" PRIu64 " (%.1f per recalculation)\n",
+            mem_mapping_stats.granules, recalcs ? ((double) mem_mapping_stats.granules / recalcs) : 0.0);
+    fprintf(CLI_RENDER_OUTPUT, "Mappings walked: %" PRIu64 " (%.1f per recalculation)\n",
+            mem_mapping_stats.maps_visited, recalcs ? ((double) mem_mapping_stats.maps_visited / recalcs) : 0.0);
+    fprintf(CLI_RENDER_OUTPUT, "Time:            %.3f ms (%.2f us per recalculation)\n",
+            mem_mapping_stats.ns / 1000000.0, recalcs ? ((mem_mapping_stats.ns / 1000.0) / recalcs) : 0.0);
+    fprintf(CLI_RENDER_OUTPUT, "Bank switches:   %" PRIu64 " (without recalculation)\n", mem_mapping_stats.switches);
+}
+
+static void
+cli_monitor_meminfo(int argc, char **argv, const void *priv)
+{
+    uint64_t rss;
+    uint64_t resident;
+    uint64_t merged;
+    uint64_t guest = (uint64_t) mem_size << 10;
+
+    mem_host_usage(&rss, &resident, &merged);
+
+    fprintf(CLI_RENDER_OUTPUT, "Guest RAM:          %" PRIu64 " KB\n", guest >> 10);
+    if (!rss) {
+        fprintf(CLI_RENDER_OUTPUT, "Host memory usage: not available\n");
+        return;
+    }
+    fprintf(CLI_RENDER_OUTPUT, "Guest RAM resident: %" PRIu64 " KB (%.1f%%)\n",
+            resident >> 10, guest ? ((100.0 * resident) / guest) : 0.0);
+    fprintf(CLI_RENDER_OUTPUT, "Guest RAM merged:   %" PRIu64 " KB%s\n",
+            merged >> 10, mem_merge_pages ? "" : " (merging disabled)");
+    fprintf(CLI_RENDER_OUTPUT, "Process resident:   %" PRIu64 " KB\n", rss >> 10);
+}
+
+static void
+cli_monitor_idlestats(int argc, char **argv, const void *priv)
+{
+    if (argc >= 1) {
+        if (!stricmp(argv[1], "reset")) {
+            cpu_idle_stats.hlt     = 0;
+            cpu_idle_stats.acpi    = 0;
+            cpu_idle_stats.skipped = 0;
+            fprintf(CLI_RENDER_OUTPUT, "Idle statistics reset.\n");
+        } else {
+            fprintf(CLI_RENDER_OUTPUT, "Unknown action: %s\n", argv[1]);
+        }
+        return;
+    }
+
+    fprintf(CLI_RENDER_OUTPUT, "Idle skipping:   %s\n", cpu_idle_skip ? "enabled" : "disabled");
+    fprintf(CLI_RENDER_OUTPUT, "Skips:           %" PRIu64 " HLT, %" PRIu64 " ACPI C2/C3\n",
+            cpu_idle_stats.hlt, cpu_idle_stats.acpi);
+    fprintf(CLI_RENDER_OUTPUT, "Guest skipped:   %.3f s (%.1f%% of the last second)\n",
+            cpu_s ? ((double) cpu_idle_stats.skipped / cpu_s->rspeed) : 0.0, cpu_idle_stats.idle_pct / 10.0);
+    fprintf(CLI_RENDER_OUTPUT, "Host CPU use:    %.1f%% of a core over the last second\n", cpu_idle_stats.host_pct / 10.0);
+}
+
+static void
+cli_monitor_timerbench(int argc, char **argv, const void *priv)
+{
+    uint32_t timers_num = 64;
+    uint32_t fires      = 1000000;
+    uint64_t arms;
+    uint64_t ns;
+
+    if (argc >= 1)
+        timers_num = strtoul(argv[1], NULL, 10);
+    if (argc >= 2)
+        fires = strtoul(argv[2], NULL, 10);
+    if (!timers_num || !fires) {
+        fprintf(CLI_RENDER_OUTPUT, "Invalid timer or event count.\n");
+        return;
+    }
+
+    /* Keep the emulation out of the timer code while the benchmark runs. */
+    startblit();
+    ns = timer_bench(timers_num, fires, &arms);
+    endblit();
+
+    fprintf(CLI_RENDER_OUTPUT, "%" PRIu32 " timers: %" PRIu32 " fired, %" PRIu64 " armed in %.3f ms\n",
+            timers_num, fires, arms, ns / 1000000.0);
+    if (ns)
+        fprintf(CLI_RENDER_OUTPUT, "%.0f fires/s, %.0f arms/s\n", (fires * 1000000000.0) / ns, (arms * 1000000000.0) / ns);
+}
+
+static void
+cli_monitor_timerprof(int argc, char **argv, const void *priv)
+{
+    FILE *fp;
+
+    /* Print the profile if no action was provided. The table can grow while
+       the emulation runs, so hold it off while printing. */
+    if (argc < 1) {
+        startblit();
+        timer_prof_print(CLI_RENDER_OUTPUT, 16, 0);
+        endblit();
+        return;
+    }
+
+    if (!stricmp(argv[1], "on") || !stricmp(argv[1], "off")) {
+        timer_prof_enable(!stricmp(argv[1], "on"));
+        fprintf(CLI_RENDER_OUTPUT, "Timer profiling %s.\n", timer_prof_enabled ? "enabled" : "disabled");
+    } else if (!stricmp(argv[1], "reset")) {
+        startblit();
+        timer_prof_reset();
+        endblit();
+        fprintf(CLI_RENDER_OUTPUT, "Timer profile reset.\n");
+    } else if (!stricmp(argv[1], "top")) {
+        startblit();
+        timer_prof_print(CLI_RENDER_OUTPUT, (argc >= 2) ? atoi(argv[2]) : 16, 0);
+        endblit();
+    } else if (!stricmp(argv[1], "csv")) {
+        if (argc < 2) {
+            fprintf(CLI_RENDER_OUTPUT, "No file name specified.\n");
+            return;
+        }
+        fp = plat_fopen(argv[2], "w");
+        if (fp == NULL) {
+            fprintf(CLI_RENDER_OUTPUT, "Unable to open %s: %s\n", argv[2], strerror(errno));
+            return;
+        }
+        startblit();
+        timer_prof_print(fp, 0, 1);
+        endblit();
+        fclose(fp);
+        fprintf(CLI_RENDER_OUTPUT, "Timer profile written to %s.\n", argv[2]);
+    } else {
+        fprintf(CLI_RENDER_OUTPUT, "Unknown action: %s\n", argv[1]);
+    }
+}
+
+static void
+cli_monitor_unthrottle(int argc, char **argv, const void *priv)
+{
+    if (argc >= 1) {
+        if (!stricmp(argv[1], "on") || !stricmp(argv[1], "off")) {
+            unthrottled = !stricmp(argv[1], "on");
+        } else {
+            fprintf(CLI_RENDER_OUTPUT, "Unknown action: %s\n", argv[1]);
+            return;
+        }
+    }
+
+    fprintf(CLI_RENDER_OUTPUT, "Emulation %s.\n", unthrottled ? "unthrottled, sound output dropped" : "paced to real time");
+}
+
+static void
+cli_monitor_pace(int argc, char **argv, const void *priv)
+{
+    pace_stats_t stats;
+    int          slice;
+
+    if (argc >= 1) {
+        if (!stricmp(argv[1], "reset")) {
+            pace_clear_stats();
+            fprintf(CLI_RENDER_OUTPUT, "Pacing statistics reset.\n");
+        } else if (!stricmp(argv[1], "slice")) {
+            slice = (argc >= 2) ? atoi(argv[2]) : 0;
+            if ((slice < PACE_SLICE_MIN) || (slice > PACE_SLICE_MAX)) {
+                fprintf(CLI_RENDER_OUTPUT, "Slice length must be %d to %d ms.\n", PACE_SLICE_MIN, PACE_SLICE_MAX);
+                return;
+            }
+            startblit();
+            pace_slice_ms = slice;
+            endblit();
+            pace_clear_stats();
+            fprintf(CLI_RENDER_OUTPUT, "Slice length set to %d ms.\n", pace_slice_ms);
+        } else {
+            fprintf(CLI_RENDER_OUTPUT, "Unknown action: %s\n", argv[1]);
+        }
+        return;
+    }
+
+    pace_get_stats(&stats);
+    fprintf(CLI_RENDER_OUTPUT, "Slice length:    %d ms%s\n", pace_slice_ms, unthrottled ? " (unthrottled)" : "");
+    fprintf(CLI_RENDER_OUTPUT, "Slices:          %" PRIu64 ", %" PRIu64 " overran (%.2f%%)\n",
+            stats.slices, stats.overruns, stats.slices ? ((100.0 * stats.overruns) / stats.slices) : 0.0);
+    fprintf(CLI_RENDER_OUTPUT, "Slice run time:  %.3f ms average, %.3f ms max\n",
+            stats.slices ? (stats.run_ns / 1000000.0 / stats.slices) : 0.0, stats.run_max_ns / 1000000.0);
+    fprintf(CLI_RENDER_OUTPUT, "Overrun by:      %.3f ms average, %.3f ms max\n",
+            stats.overruns ? (stats.late_ns / 1000000.0 / stats.overruns) : 0.0, stats.late_max_ns / 1000000.0);
+    fprintf(CLI_RENDER_OUTPUT, "Wakeup latency:  %.3f ms average, %.3f ms max\n",
+            stats.slices ? (stats.wake_ns / 1000000.0 / stats.slices) : 0.0, stats.wake_max_ns / 1000000.0);
+    fprintf(CLI_RENDER_OUTPUT, "Slept:           %.3f s\n", stats.sleep_ns / 1000000000.0);
+    fprintf(CLI_RENDER_OUTPUT, "Time dropped:    %.3f s\n", stats.dropped_ns / 1000000000.0);
+}
+
 static void
 cli_monitor_exit(int argc, char **argv, const void *priv)
 {
@@ -646,6 +947,60 @@ static const struct {
      .helptext = "Take a screenshot.",
      .category = MONITOR_CATEGORY_EMULATOR,
      .handler  = cli_monitor_screenshot },
+#if defined(USE_DYNAREC) && defined(USE_NEW_DYNAREC)
+    { .name     = "dynstats",
+     .helptext = "Show dynamic recompiler statistics, or perform [action]:\non/off: enable or disable collection.\nreset: clear all counters.\nlog <seconds>: log statistics every <seconds>, 0 to disable.\ntop <count>: show statistics with the <count> most common interpreter fallbacks.",
+     .args     = (const char *[]) { "action", "value" },
+     .args_max = 2,
+     .category = MONITOR_CATEGORY_EMULATOR,
+     .handler  = cli_monitor_dynstats },
+#endif
+    { .name     = "tlbstats",
+     .helptext = "Show software TLB statistics, or perform [action]:\nreset: clear all counters.",
+     .args     = (const char *[]) { "action" },
+     .args_max = 1,
+     .category = MONITOR_CATEGORY_EMULATOR,
+     .handler  = cli_monitor_tlbstats },
+    { .name     = "mapstats",
+     .helptext = "Show memory mapping recalculation statistics, or perform [action]:\nreset: clear all counters.",
+     .args     = (const char *[]) { "action" },
+     .args_max = 1,
+     .category = MONITOR_CATEGORY_EMULATOR,
+     .handler  = cli_monitor_mapstats },
+    { .name     = "meminfo",
+     .helptext = "Show host memory used by this instance.",
+     .category = MONITOR_CATEGORY_EMULATOR,
+     .handler  = cli_monitor_meminfo },
+    { .name     = "idlestats",
+     .helptext = "Show guest idle skipping and host CPU use, or perform [action]:\nreset: clear all counters.",
+     .args     = (const char *[]) { "action" },
+     .args_max = 1,
+     .category = MONITOR_CATEGORY_EMULATOR,
+     .handler  = cli_monitor_idlestats },
+    { .name     = "timerbench",
+     .helptext = "Measure timer arm and fire throughput with [timers] timers (default 64) until [events] have fired (default 1000000).",
+     .args     = (const char *[]) { "timers", "events" },
+     .args_max = 2,
+     .category = MONITOR_CATEGORY_EMULATOR,
+     .handler  = cli_monitor_timerbench },
+    { .name     = "unthrottle",
+     .helptext = "Show or set [on/off] whether the emulation runs as fast as possible, decoupled from real time.",
+     .args     = (const char *[]) { "on/off" },
+     .args_max = 1,
+     .category = MONITOR_CATEGORY_EMULATOR,
+     .handler  = cli_monitor_unthrottle },
+    { .name     = "timerprof",
+     .helptext = "Show host time spent in each timer callback, or perform [action]:\non/off: enable or disable collection.\nreset: clear the profile.\ntop <count>: show the <count> most expensive callbacks.\ncsv <file>: write the whole profile to <file> as CSV.",
+     .args     = (const char *[]) { "action", "value" },
+     .args_max = 2,
+     .category = MONITOR_CATEGORY_EMULATOR,
+     .handler  = cli_monitor_timerprof },
+    { .name     = "pace",
+     .helptext = "Show real time pacing statistics, or perform [action]:\nreset: clear the statistics.\nslice <ms>: run <ms> (1 to 10) emulated milliseconds per slice; shorter slices lower input and sound latency at some throughput cost.",
+     .args     = (const char *[]) { "action", "value" },
+     .args_max = 2,
+     .category = MONITOR_CATEGORY_EMULATOR,
+     .handler  = cli_monitor_pace },
     { .name     = "exit",
      .helptext = "Exit " EMU_NAME ".",
      .flags    = MONITOR_CMD_EXIT,
@@ -18,8 +18,7 @@
 #include "codegen_ir.h"
 #include "codegen_ops.h"
 #include "codegen_ops_helpers.h"
-
-#define MAX_INSTRUCTION_COUNT 50
+#include "codegen_stats.h"
 
 static struct {
     uint32_t pc;
@@ -82,6 +81,11 @@ static int      last_op_ssegs;
 static x86seg  *last_op_ea_seg;
 static uint32_t last_op_32;
 
+/*Guest PC after the last generated instruction, if it is a compile time
+  constant*/
+static int      exit_pc_known;
+static uint32_t exit_pc;
+
 void
 codegen_generate_reset(void)
 {
@@ -89,6 +93,14 @@ codegen_generate_reset(void)
     last_op_ea_seg = NULL;
     last_op_32     = -1;
     has_ea         = 0;
+    exit_pc_known  = 0;
+}
+
+void
+codegen_generate_exit(ir_data_t *ir)
+{
+    if (exit_pc_known)
+        uop_JMP_CHAIN(ir, exit_pc);
 }
 
 void
@@ -401,8 +413,9 @@ codegen_generate_call(uint8_t opcode, OpFn op, uint32_t fetchdat, uint32_t new_p
 #ifdef DEBUG_EXTRA
     uint8_t last_prefix = 0;
 #endif
-    op_ea_seg = &cpu_state.seg_ds;
-    op_ssegs  = 0;
+    op_ea_seg     = &cpu_state.seg_ds;
+    op_ssegs      = 0;
+    exit_pc_known = 0;
 
     codegen_timing_start();
 
@@ -685,6 +698,8 @@ generate_call:
         if (new_pc) {
             if (new_pc != -1)
                 uop_MOV_IMM(ir, IREG_pc, new_pc);
+            exit_pc_known = (new_pc != -1);
+            exit_pc       = new_pc;
 
             codegen_endpc = (cs + cpu_state.pc) + 8;
 
@@ -703,6 +718,22 @@ codegen_skip:
         recomp_op_table = recomp_opcodes;
     }
 
+    if (codegen_stats_enabled) {
+        /*Histogram key is the table selecting prefix or escape byte, plus
+          the opcode (or ModR/M byte for FPU escapes)*/
+        uint16_t key = opcode;
+
+        if (pc_off)
+            key |= 0xd800 | (op87 & 0x0700);
+        else if ((op_table == x86_dynarec_opcodes_0f) || (op_table == x86_dynarec_opcodes_3DNOW))
+            key |= 0x0f00;
+        else if (op_table == x86_dynarec_opcodes_REPNE)
+            key |= 0xf200;
+        else if (op_table == x86_dynarec_opcodes_REPE)
+            key |= 0xf300;
+        codegen_stats.fallback[key]++;
+    }
+
     if (in_lock && ((opcode == 0x90) || (opcode == 0xec)))
         /* This is always ILLEGAL. */
         op = x86_dynarec_opcodes_3DNOW[0xff];
@@ -57,10 +57,59 @@ typedef struct codeblock_t {
     /*First mem_block_t used by this block. Any subsequent mem_block_ts
       will be in the list starting at head_mem_block->next.*/
     struct mem_block_t *head_mem_block;
+
+    /*Entry point used by other blocks jumping directly into this one, or NULL
+      if this block can not be a chaining target.*/
+    uint8_t *chain_entry;
+    /*Chaining links leaving this block, and links from other blocks into this
+      one.*/
+    struct codeblock_link_t *link_out, *link_in;
 } codeblock_t;
 
+/*Direct block chaining :
+
+  When a block exits to a constant guest PC (a taken or not-taken branch, or
+  falling off the end of the block), the exit goes through a patchable jump.
+  Initially this jump leads to a stub that records the link in
+  codegen_chain_exit and returns to the dispatcher. Once the dispatcher has
+  found a valid, compiled block for that PC, it patches the jump to go straight
+  to that block's chain_entry, skipping the dispatcher on subsequent exits.
+
+  The chain entry calls codegen_chain_check(), which rechecks everything the
+  dispatcher would (pending interrupts and resets, timers via
+  codegen_chain_limit, CS, CPU status and the dirty mask) and bails out to the
+  dispatcher if any of it fails. Links are only made between blocks on the
+  same linear and physical page, so a valid source block implies the mapping
+  for the target; any MMU flush sets codegen_chain_limit to stop chaining
+  until the next dispatch.
+
+  Links are torn down whenever either end is invalidated or deleted.*/
+typedef struct codeblock_link_t {
+    /*Owning (source) block and linked target block, BLOCK_INVALID if the link
+      is not currently patched.*/
+    uint16_t src, dest;
+    /*Guest PC (excluding CS base) this exit jumps to*/
+    uint32_t pc;
+    /*Patchable jump, and its original (unlinked) destination*/
+    uint8_t *patch;
+    uint8_t *unlinked;
+
+    /*Next link leaving the source block, or next free link*/
+    struct codeblock_link_t *src_next;
+    /*Previous and next links entering the target block*/
+    struct codeblock_link_t *dest_prev, *dest_next;
+} codeblock_link_t;
+
 extern codeblock_t *codeblock;
 
+/*Number of entries in codeblock. Taken from the dynarec_blocks setting at
+  startup, or BLOCK_SIZE_DEFAULT. Block numbers are 16-bit, with 0 reserved
+  as BLOCK_INVALID, so this is limited to BLOCK_SIZE_MAX.*/
+extern int codegen_block_count;
+
+#define BLOCK_SIZE_MIN 0x400
+#define BLOCK_SIZE_MAX 0x10000
+
 extern uint16_t *codeblock_hash;
 
 extern uint8_t *block_write_data;
@@ -81,11 +130,22 @@ extern uint8_t *block_write_data;
 #define CODEBLOCK_IN_DIRTY_LIST 0x40
 /*Code block is not inlining immediate parameters, parameters must be fetched from memory*/
 #define CODEBLOCK_NO_IMMEDIATES 0x80
+/*Code block has been executed since the eviction clock last passed it*/
+#define CODEBLOCK_REFERENCED 0x100
+/*Code block has been translated and is waiting for the background compiler. It
+  is interpreted until then*/
+#define CODEBLOCK_COMPILE_PENDING 0x200
+/*Background compilation of this code block ran out of memory, reserve more
+  next time*/
+#define CODEBLOCK_COMPILE_LARGE 0x400
 
 #define BLOCK_PC_INVALID        0xffffffff
 
 #define BLOCK_INVALID           0
 
+/*Maximum number of guest instructions in a recompiled block*/
+#define MAX_INSTRUCTION_COUNT 50
+
 static inline int
 get_block_nr(codeblock_t *block)
 {
@@ -309,12 +369,41 @@ extern void codegen_check_seg_write(codeblock_t *block, struct ir_data_t *ir, x8
 extern void codegen_check_regs(void);
 
 extern int codegen_purge_purgable_list(void);
-/*Delete a random code block to free memory. This is obviously quite expensive, and
-  will only be called when the allocator is out of memory*/
-extern void codegen_delete_random_block(int required_mem_block);
+/*Evict a code block to free memory. Blocks are picked by a clock sweep, where
+  blocks that have run since the last sweep get a second chance, so hot blocks
+  survive pressure on the block or allocator pools. This is still quite
+  expensive, and will only be called when a pool is exhausted*/
+extern void codegen_evict_block(int required_mem_block);
+
+/*Allocate a chaining link for an exit from block to pc. Returns -1 if no links
+  are available, in which case the exit must not be patchable. Links are only
+  allocated and freed by the CPU thread*/
+extern int codegen_block_link_alloc(codeblock_t *block, uint32_t pc);
+/*Set the patchable jump and its unlinked destination for a link*/
+extern void codegen_block_link_set_site(int link_nr, uint8_t *patch, uint8_t *unlinked);
+/*Patch link to jump directly to block, if the link is still valid and block
+  is a suitable target*/
+extern void codegen_block_link(int link_nr, codeblock_t *block);
+/*Remove all links into and out of block*/
+extern void codegen_block_unlink(codeblock_t *block);
+/*Called from a chain entry point. Returns non-zero if the block must not be
+  entered directly*/
+extern int  codegen_chain_check(int block_nr);
+extern void codegen_chain_set_limit(void);
+
+/*Link taken by the most recent block exit, -1 if none*/
+extern int codegen_chain_exit;
+/*Chaining stops once cycles drops to or below this value*/
+extern int32_t codegen_chain_limit;
 
 extern int      cpu_block_end;
 extern uint32_t codegen_endpc;
+/*Set by a branch being followed as a trace during recompilation, to the
+  linear address translation continues at. BLOCK_PC_INVALID otherwise*/
+extern uint32_t codegen_trace_dest;
+/*Count the trace side exit recorded in cpu_state.trace_exit_data by the last
+  block, if any*/
+extern void codegen_trace_count_exit(void);
 
 extern int cpu_reps;
 extern int cpu_notreps;
@@ -373,6 +462,9 @@ extern int codegen_reg_loaded[8];
 extern int codegen_in_recompile;
 
 void codegen_generate_reset(void);
+/*Generate the exit at the end of a block, chaining to the next block if the
+  final guest PC is known*/
+void codegen_generate_exit(struct ir_data_t *ir);
 
 int  codegen_get_instruction_uop(codeblock_t *block, uint32_t pc, int *first_instruction, int *TOP);
 void codegen_set_loop_start(struct ir_data_t *ir, int first_instruction);
@@ -18,6 +18,7 @@
 
 #include "codegen.h"
 #include "codegen_allocator.h"
+#include "codegen_perf.h"
 
 typedef struct mem_block_t {
     uint32_t offset; /*Offset into mem_block_alloc*/
@@ -25,21 +26,35 @@ typedef struct mem_block_t {
     uint16_t code_block;
 } mem_block_t;
 
-static mem_block_t mem_blocks[MEM_BLOCK_NR];
-static uint32_t    mem_block_free_list;
-static uint8_t    *mem_block_alloc = NULL;
+static mem_block_t *mem_blocks;
+static uint32_t     mem_block_free_list;
+static uint8_t     *mem_block_alloc = NULL;
+
+/*Blocks reserved for the background compiler, which must not touch the free
+  list. The last block of the reserve is never handed out in a list; once
+  reached it is reused for all further allocations and the code discarded*/
+static __thread uint32_t mem_block_reserve;
+static __thread int      mem_block_reserve_overflow;
 
 int codegen_allocator_usage = 0;
+int codegen_mem_block_count = MEM_BLOCK_NR_DEFAULT;
 
 void
 codegen_allocator_init(void)
 {
-    mem_block_alloc = plat_mmap(MEM_BLOCK_NR * MEM_BLOCK_SIZE, 1);
+    codegen_mem_block_count = dynarec_mem_blocks ? dynarec_mem_blocks : MEM_BLOCK_NR_DEFAULT;
+    if (codegen_mem_block_count < MEM_BLOCK_NR_MIN)
+        codegen_mem_block_count = MEM_BLOCK_NR_MIN;
+    else if (codegen_mem_block_count > MEM_BLOCK_NR_MAX)
+        codegen_mem_block_count = MEM_BLOCK_NR_MAX;
+
+    mem_blocks      = malloc(codegen_mem_block_count * sizeof(mem_block_t));
+    mem_block_alloc = plat_mmap((size_t) codegen_mem_block_count * MEM_BLOCK_SIZE, 1);
 
-    for (uint32_t c = 0; c < MEM_BLOCK_NR; c++) {
+    for (uint32_t c = 0; c < (uint32_t) codegen_mem_block_count; c++) {
         mem_blocks[c].offset     = c * MEM_BLOCK_SIZE;
         mem_blocks[c].code_block = BLOCK_INVALID;
-        if (c < MEM_BLOCK_NR - 1)
+        if (c < (uint32_t) codegen_mem_block_count - 1)
             mem_blocks[c].next = c + 2;
         else
             mem_blocks[c].next = 0;
@@ -53,15 +68,28 @@ codegen_allocator_allocate(mem_block_t *parent, int code_block)
     mem_block_t *block;
     uint32_t     block_nr;
 
-    while (!mem_block_free_list) {
-        /*Pick a random memory block and free the owning code block*/
-        block_nr = rand() & MEM_BLOCK_MASK;
-        block    = &mem_blocks[block_nr];
-
-        if (block->code_block && block->code_block != code_block)
-            codegen_delete_block(&codeblock[block->code_block]);
+    if (mem_block_reserve) {
+        block_nr = mem_block_reserve;
+        block    = &mem_blocks[block_nr - 1];
+        if (!block->next) {
+            mem_block_reserve_overflow = 1;
+            return block;
+        }
+        mem_block_reserve = block->next;
+
+        if (parent) {
+            block->next  = parent->next;
+            parent->next = block_nr;
+        } else
+            block->next = 0;
+        return block;
     }
 
+    /*Evict code blocks that have not run recently until memory is available. The
+      block being compiled (code_block) is block_current, so is never picked*/
+    while (!mem_block_free_list)
+        codegen_evict_block(1);
+
     /*Remove from free list*/
     block_nr            = mem_block_free_list;
     block               = &mem_blocks[block_nr - 1];
@@ -78,6 +106,47 @@ codegen_allocator_allocate(mem_block_t *parent, int code_block)
     codegen_allocator_usage++;
     return block;
 }
+
+uint32_t
+codegen_allocator_reserve(int nr, int code_block)
+{
+    uint32_t reserve = 0;
+
+    while (nr--) {
+        mem_block_t *block = codegen_allocator_allocate(NULL, code_block);
+
+        block->next = reserve;
+        reserve     = (block - mem_blocks) + 1;
+    }
+
+    return reserve;
+}
+
+void
+codegen_allocator_release(uint32_t reserve)
+{
+    if (reserve)
+        codegen_allocator_free(&mem_blocks[reserve - 1]);
+}
+
+void
+codegen_allocator_set_reserve(uint32_t reserve)
+{
+    mem_block_reserve          = reserve;
+    mem_block_reserve_overflow = 0;
+}
+
+uint32_t
+codegen_allocator_take_reserve(int *overflow)
+{
+    uint32_t reserve = mem_block_reserve;
+
+    *overflow                  = mem_block_reserve_overflow;
+    mem_block_reserve          = 0;
+    mem_block_reserve_overflow = 0;
+    return reserve;
+}
+
 void
 codegen_allocator_free(mem_block_t *block)
 {
@@ -87,6 +156,9 @@ codegen_allocator_free(mem_block_t *block)
         int next_block_nr = block->next;
         codegen_allocator_usage--;
 
+        if (codegen_perf_mode)
+            codegen_perf_retire(block_nr - 1);
+
         block->next         = mem_block_free_list;
         block->code_block   = BLOCK_INVALID;
         mem_block_free_list = block_nr;
@@ -122,3 +194,17 @@ codegen_allocator_clean_blocks(UNUSED(struct mem_block_t *block))
     }
 #endif
 }
+
+void
+codegen_allocator_perf_load(mem_block_t *block, codeblock_t *code_block)
+{
+    while (1) {
+        uint32_t block_nr = block - mem_blocks;
+
+        codegen_perf_load(block_nr, &mem_block_alloc[block->offset], MEM_BLOCK_SIZE, code_block);
+        if (block->next)
+            block = &mem_blocks[block->next - 1];
+        else
+            break;
+    }
+}
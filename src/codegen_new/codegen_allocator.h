@@ -12,14 +12,27 @@
 
   Due to the chaining, the total memory size is limited by the range of a jump
   instruction. ARMv7 is restricted to +/- 32 MB, ARMv8 to +/- 128 MB, x86 to
-  +/- 2GB. As a result, total memory size is limited to 32 MB on ARMv7*/
+  +/- 2GB. As a result, total memory size is limited to 32 MB on ARMv7 and
+  128 MB on ARMv8. 32-bit x86 hosts are instead limited by address space, so
+  are capped at 240 MB.
+
+  The number of blocks can be set with the dynarec_mem_blocks setting, up to
+  MEM_BLOCK_NR_MAX*/
 #if defined __ARM_EABI__ || defined _ARM_ || defined _M_ARM
-#    define MEM_BLOCK_NR 32768
+#    define MEM_BLOCK_NR_DEFAULT 32768
+#    define MEM_BLOCK_NR_MAX     32768
+#elif defined __aarch64__ || defined _M_ARM64
+#    define MEM_BLOCK_NR_DEFAULT 131072
+#    define MEM_BLOCK_NR_MAX     131072
+#elif defined __i386__ || defined _M_IX86
+#    define MEM_BLOCK_NR_DEFAULT 131072
+#    define MEM_BLOCK_NR_MAX     262144
 #else
-#    define MEM_BLOCK_NR 131072
+#    define MEM_BLOCK_NR_DEFAULT 131072
+#    define MEM_BLOCK_NR_MAX     2097152
 #endif
+#define MEM_BLOCK_NR_MIN 4096
 
-#define MEM_BLOCK_MASK (MEM_BLOCK_NR - 1)
 #define MEM_BLOCK_SIZE 0x3c0
 
 void codegen_allocator_init(void);
@@ -27,13 +40,30 @@ void codegen_allocator_init(void);
   If parent is non-NULL, then the new block will be added to the list in
   parent->next*/
 struct mem_block_t *codegen_allocator_allocate(struct mem_block_t *parent, int code_block);
+/*Allocate a list of nr blocks for code_block, to be used by
+  codegen_allocator_allocate() on the background compiler thread. The list is
+  referenced by block number, 0 being an empty list*/
+uint32_t codegen_allocator_reserve(int nr, int code_block);
+/*Free blocks in a reserved list that were not used*/
+void codegen_allocator_release(uint32_t reserve);
+/*Make codegen_allocator_allocate() on this thread take blocks from reserve
+  instead of the free list*/
+void codegen_allocator_set_reserve(uint32_t reserve);
+/*Stop using the reserve. Returns the unused part of it, and sets overflow if
+  the reserve ran out and the code generated since is unusable*/
+uint32_t codegen_allocator_take_reserve(int *overflow);
 /*Free a mem_block_t, and any subsequent blocks in the list at block->next*/
 void codegen_allocator_free(struct mem_block_t *block);
 /*Get a pointer to the backing memory associated with block*/
 uint8_t *codeblock_allocator_get_ptr(struct mem_block_t *block);
 /*Cache clean memory block list*/
 void codegen_allocator_clean_blocks(struct mem_block_t *block);
+/*Report memory block list as holding code for code_block to the profiler
+  symbol output*/
+void codegen_allocator_perf_load(struct mem_block_t *block, struct codeblock_t *code_block);
 
 extern int codegen_allocator_usage;
+/*Number of mem_block_ts available*/
+extern int codegen_mem_block_count;
 
 #endif
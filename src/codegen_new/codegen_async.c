@@ -0,0 +1,247 @@
+#if defined(__APPLE__) && defined(__aarch64__)
+#    include <pthread.h>
+#endif
+#include <stdint.h>
+#include <stdlib.h>
+#include <86box/86box.h>
+#include "cpu.h"
+#include <86box/mem.h>
+#include <86box/plat_unused.h>
+#include <86box/thread.h>
+
+#include "codegen.h"
+#include "codegen_allocator.h"
+#include "codegen_async.h"
+#include "codegen_ir.h"
+#include "codegen_perf.h"
+#include "codegen_reg.h"
+#include "codegen_stats.h"
+
+#define ASYNC_JOBS 8
+
+/*Estimated generated code per uOP, used to size the memory reserved for a job.
+  Blocks that overflow the first estimate are retried with the large one*/
+#define ASYNC_BYTES_PER_UOP       32
+#define ASYNC_BYTES_PER_UOP_LARGE 256
+
+enum {
+    JOB_QUEUED = 0,
+    JOB_RUNNING,
+    JOB_DONE
+};
+
+typedef struct async_job_t {
+    int                  state;
+    int                  cancelled;
+    int                  overflow;
+    int                  block_nr;
+    uint32_t             reserve;
+    ir_data_t           *ir;
+    codegen_reg_state_t *reg_state;
+} async_job_t;
+
+int          codegen_async_enabled = 0;
+volatile int codegen_async_done    = 0;
+
+/*Jobs form a ring. Those from job_tail to job_run have been taken by the
+  compiler thread, those from job_run to job_head are waiting for it. Jobs
+  are only freed by the CPU thread, in order, once done*/
+static async_job_t jobs[ASYNC_JOBS];
+static uint32_t    job_head;
+static uint32_t    job_run;
+static uint32_t    job_tail;
+
+static mutex_t *job_mutex;
+static event_t *wake_event;
+static event_t *done_event;
+
+static void
+async_compile(async_job_t *job)
+{
+    codeblock_t *block = &codeblock[job->block_nr];
+
+    codegen_reg_state = job->reg_state;
+    codegen_allocator_set_reserve(job->reserve);
+    codegen_ir_compile(job->ir, block);
+    job->reserve = codegen_allocator_take_reserve(&job->overflow);
+}
+
+static void
+codegen_async_thread(UNUSED(void *param))
+{
+#if defined(__APPLE__) && defined(__aarch64__)
+    if (__builtin_available(macOS 11.0, *)) {
+        pthread_jit_write_protect_np(0);
+    }
+#endif
+
+    while (1) {
+        thread_wait_event(wake_event, -1);
+        thread_reset_event(wake_event);
+
+        thread_wait_mutex(job_mutex);
+        while (job_run != job_head) {
+            async_job_t *job = &jobs[job_run % ASYNC_JOBS];
+
+            job_run++;
+            if (!job->cancelled) {
+                job->state = JOB_RUNNING;
+                thread_release_mutex(job_mutex);
+
+                async_compile(job);
+
+                thread_wait_mutex(job_mutex);
+            }
+            job->state         = JOB_DONE;
+            codegen_async_done = 1;
+            thread_set_event(done_event);
+        }
+        thread_release_mutex(job_mutex);
+    }
+}
+
+/*Wait for job to finish. Must be called with job_mutex held*/
+static void
+async_wait(async_job_t *job)
+{
+    while (job->state != JOB_DONE) {
+        thread_reset_event(done_event);
+        thread_release_mutex(job_mutex);
+        thread_wait_event(done_event, -1);
+        thread_wait_mutex(job_mutex);
+    }
+}
+
+static void
+async_install(async_job_t *job)
+{
+    codeblock_t *block = &codeblock[job->block_nr];
+
+    if (!job->cancelled) {
+        block->flags &= ~CODEBLOCK_COMPILE_PENDING;
+
+        if (job->overflow) {
+            /*The generated code is incomplete. Discard it, and let the block
+              be translated again*/
+            codegen_block_unlink(block);
+            codegen_allocator_free(block->head_mem_block);
+            block->head_mem_block = NULL;
+            block->flags |= CODEBLOCK_COMPILE_LARGE;
+        } else {
+            codegen_allocator_clean_blocks(block->head_mem_block);
+            block->flags |= CODEBLOCK_WAS_RECOMPILED;
+
+            if (codegen_stats_enabled)
+                codegen_stats_block_compiled(block);
+            if (codegen_perf_mode)
+                codegen_allocator_perf_load(block->head_mem_block, block);
+        }
+    }
+
+    codegen_allocator_release(job->reserve);
+    job->reserve = 0;
+}
+
+void
+codegen_async_init(void)
+{
+    codegen_async_enabled = dynarec_async_compile;
+    if (!codegen_async_enabled)
+        return;
+
+    for (int c = 0; c < ASYNC_JOBS; c++) {
+        jobs[c].ir        = malloc(sizeof(ir_data_t));
+        jobs[c].reg_state = malloc(sizeof(codegen_reg_state_t));
+        if (!jobs[c].ir || !jobs[c].reg_state)
+            fatal("codegen_async_init: out of memory\n");
+    }
+    job_head = job_run = job_tail = 0;
+
+    job_mutex  = thread_create_mutex();
+    wake_event = thread_create_event();
+    done_event = thread_create_event();
+    thread_create(codegen_async_thread, NULL);
+
+    pclog("Dynarec: compiling blocks on a background thread\n");
+}
+
+void
+codegen_async_queue(struct ir_data_t *ir, codeblock_t *block)
+{
+    int                  bytes_per_uop = (block->flags & CODEBLOCK_COMPILE_LARGE) ? ASYNC_BYTES_PER_UOP_LARGE : ASYNC_BYTES_PER_UOP;
+    async_job_t         *job;
+    ir_data_t           *free_ir;
+    codegen_reg_state_t *free_reg_state;
+
+    /*Wait for the oldest job if the ring is full*/
+    while ((job_head - job_tail) >= ASYNC_JOBS) {
+        thread_wait_mutex(job_mutex);
+        async_wait(&jobs[job_tail % ASYNC_JOBS]);
+        thread_release_mutex(job_mutex);
+        codegen_async_poll();
+    }
+
+    job            = &jobs[job_head % ASYNC_JOBS];
+    job->block_nr  = get_block_nr(block);
+    job->cancelled = 0;
+    job->overflow  = 0;
+    /*The last reserved block is the overflow block, and is never used for
+      real code*/
+    job->reserve = codegen_allocator_reserve(((ir->wr_pos * bytes_per_uop) / MEM_BLOCK_SIZE) + 2, job->block_nr);
+
+    /*Swap buffers with the job, rather than copying*/
+    free_ir           = job->ir;
+    free_reg_state    = job->reg_state;
+    job->ir           = ir;
+    job->reg_state    = codegen_reg_state;
+    codegen_reg_state = free_reg_state;
+    codegen_ir_set_buffer(free_ir);
+
+    block->flags = (block->flags & ~CODEBLOCK_WAS_RECOMPILED) | CODEBLOCK_COMPILE_PENDING;
+
+    thread_wait_mutex(job_mutex);
+    job->state = JOB_QUEUED;
+    job_head++;
+    thread_release_mutex(job_mutex);
+    thread_set_event(wake_event);
+}
+
+void
+codegen_async_poll(void)
+{
+    codegen_async_done = 0;
+
+    thread_wait_mutex(job_mutex);
+    while ((job_tail != job_head) && (jobs[job_tail % ASYNC_JOBS].state == JOB_DONE)) {
+        async_job_t *job = &jobs[job_tail % ASYNC_JOBS];
+
+        thread_release_mutex(job_mutex);
+        async_install(job);
+        thread_wait_mutex(job_mutex);
+        job_tail++;
+    }
+    thread_release_mutex(job_mutex);
+}
+
+void
+codegen_async_cancel(codeblock_t *block)
+{
+    int block_nr = get_block_nr(block);
+
+    thread_wait_mutex(job_mutex);
+    for (uint32_t c = job_tail; c != job_head; c++) {
+        async_job_t *job = &jobs[c % ASYNC_JOBS];
+
+        if ((job->block_nr == block_nr) && !job->cancelled) {
+            /*A queued job will be skipped, but one being compiled is still
+              using the block's memory*/
+            job->cancelled = 1;
+            if (job->state == JOB_RUNNING)
+                async_wait(job);
+            break;
+        }
+    }
+    thread_release_mutex(job_mutex);
+
+    block->flags &= ~CODEBLOCK_COMPILE_PENDING;
+}
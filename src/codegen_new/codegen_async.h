@@ -0,0 +1,41 @@
+#ifndef _CODEGEN_ASYNC_H_
+#define _CODEGEN_ASYNC_H_
+
+/*Background compilation, enabled by the dynarec_async_compile setting.
+
+  Blocks are still translated to IR on the CPU thread, as the two-pass design
+  interleaves translation with interpreting the block. Optimisation, register
+  allocation and code generation are then queued to a compiler thread, and the
+  block is interpreted while marked CODEBLOCK_COMPILE_PENDING. Finished blocks
+  are installed by the CPU thread in codegen_async_poll().
+
+  The compiler thread writes the pending block's code memory, chain_entry and
+  the patch sites of its chaining links, and reads its flags. It does not touch
+  any shared list: links are allocated from the free list by the CPU thread
+  during translation (see uop_JMP_CHAIN), and the code memory is reserved by
+  the CPU thread in codegen_async_queue().
+
+  The CPU thread leaves a pending block's flags and links alone until the job
+  is finished. Anything that frees or modifies a pending block (invalidation,
+  deletion, reset) cancels the job first, waiting for it if it is being
+  compiled. Eviction skips pending blocks, and the other flag updates
+  (CODEBLOCK_REFERENCED, CODEBLOCK_WAS_RECOMPILED, CODEBLOCK_STATIC_TOP) only
+  apply to blocks that have already been installed.
+
+  When enabled, all compilation happens on the compiler thread, so code
+  generation state does not need to be per-thread.*/
+
+extern int          codegen_async_enabled;
+/*Set by the compiler thread when a job has finished*/
+extern volatile int codegen_async_done;
+
+extern void codegen_async_init(void);
+/*Queue block, translated into ir, for compilation. Takes ownership of ir and
+  the current register state, and gives the CPU thread fresh ones*/
+extern void codegen_async_queue(struct ir_data_t *ir, codeblock_t *block);
+/*Install finished blocks. Called by the CPU thread between blocks*/
+extern void codegen_async_poll(void);
+/*Cancel compilation of a pending block, and clear CODEBLOCK_COMPILE_PENDING*/
+extern void codegen_async_cancel(codeblock_t *block);
+
+#endif
@@ -16,6 +16,10 @@
 void codegen_backend_init(void);
 void codegen_backend_prologue(codeblock_t *block);
 void codegen_backend_epilogue(codeblock_t *block);
+#ifdef CODEGEN_BACKEND_HAS_CHAINING
+/*Retarget the patchable jump at patch to dest*/
+void codegen_backend_patch_jump(uint8_t *patch, void *dest);
+#endif
 
 struct ir_data_t;
 struct uop_t;
@@ -22,6 +22,9 @@
 #        include <sys/mman.h>
 #        include <unistd.h>
 #    endif
+#    if defined(__APPLE__) && defined(__aarch64__)
+#        include <pthread.h>
+#    endif
 #    if defined WIN32 || defined _WIN32 || defined _WIN32
 #        include <windows.h>
 #    endif
@@ -41,6 +44,20 @@ void *codegen_mem_store_quad;
 void *codegen_mem_store_single;
 void *codegen_mem_store_double;
 
+void *codegen_mem_load_byte_fast;
+void *codegen_mem_load_word_fast;
+void *codegen_mem_load_long_fast;
+void *codegen_mem_load_quad_fast;
+void *codegen_mem_load_single_fast;
+void *codegen_mem_load_double_fast;
+
+void *codegen_mem_store_byte_fast;
+void *codegen_mem_store_word_fast;
+void *codegen_mem_store_long_fast;
+void *codegen_mem_store_quad_fast;
+void *codegen_mem_store_single_fast;
+void *codegen_mem_store_double_fast;
+
 void *codegen_fp_round;
 void *codegen_fp_round_quad;
 
@@ -71,14 +88,33 @@ host_reg_def_t codegen_host_fp_reg_list[CODEGEN_HOST_FP_REGS] = {
     { REG_V15, 0}
 };
 
+#    ifdef USE_TLB_STATS
+/*Count a TLB lookup, corrupting addr_reg and temp_reg. The full routines
+  count on entry, the fast ones only on a hit, as a miss goes on to call the
+  full routine*/
+static void
+build_count_lookup(codeblock_t *block, uint64_t *counter, int addr_reg, int temp_reg)
+{
+    host_arm64_MOVX_IMM(block, addr_reg, (uint64_t) counter);
+    host_arm64_LDR_IMM_X(block, temp_reg, addr_reg, 0);
+    host_arm64_ADDX_IMM(block, temp_reg, temp_reg, 1);
+    host_arm64_STR_IMM_Q(block, temp_reg, addr_reg, 0);
+}
+#        define MEM_ROUTINE_SIZE (80 + 28)
+#    else
+#        define MEM_ROUTINE_SIZE 80
+#    endif
+
 static void
-build_load_routine(codeblock_t *block, int size, int is_float)
+build_load_routine(codeblock_t *block, int size, int is_float, int fast)
 {
     uint32_t *branch_offset;
     uint32_t *misaligned_offset;
 
     /*In - W0 = address
-      Out - W0 = data, W1 = abrt*/
+      Out - W0 = data, W1 = abrt
+      The fast variant only uses the lookup table, and returns W1 = 1 with
+      W0 = address if the access needs the slow path*/
     /*MOV W1, W0, LSR #12
       MOV X2, #readlookup2
       LDR X1, [X2, X1, LSL #3]
@@ -93,7 +129,11 @@ build_load_routine(codeblock_t *block, int size, int is_float)
       LDP X29, X30, [SP, #-16]
       RET
     */
-    codegen_alloc(block, 80);
+    codegen_alloc(block, MEM_ROUTINE_SIZE);
+#    ifdef USE_TLB_STATS
+    if (!fast)
+        build_count_lookup(block, &tlb_stats.read_lookups, REG_X2, REG_X1);
+#    endif
     host_arm64_MOV_REG_LSR(block, REG_W1, REG_W0, 12);
     host_arm64_MOVX_IMM(block, REG_X2, (uint64_t) readlookup2);
     host_arm64_LDRX_REG_LSL3(block, REG_X1, REG_X2, REG_X1);
@@ -113,12 +153,21 @@ build_load_routine(codeblock_t *block, int size, int is_float)
         host_arm64_LDR_REG_F32(block, REG_V_TEMP, REG_W1, REG_W0);
     else if (size == 8)
         host_arm64_LDR_REG_F64(block, REG_V_TEMP, REG_W1, REG_W0);
+#    ifdef USE_TLB_STATS
+    if (fast)
+        build_count_lookup(block, &tlb_stats.read_lookups, REG_X2, REG_X1);
+#    endif
     host_arm64_MOVZ_IMM(block, REG_W1, 0);
     host_arm64_RET(block, REG_X30);
 
     host_arm64_branch_set_offset(branch_offset, &block_write_data[block_pos]);
     if (size != 1)
         host_arm64_branch_set_offset(misaligned_offset, &block_write_data[block_pos]);
+    if (fast) {
+        host_arm64_MOVZ_IMM(block, REG_W1, 1);
+        host_arm64_RET(block, REG_X30);
+        return;
+    }
     host_arm64_STP_PREIDX_X(block, REG_X29, REG_X30, REG_XSP, -16);
     if (size == 1)
         host_arm64_call(block, (void *) readmembl);
@@ -140,13 +189,15 @@ build_load_routine(codeblock_t *block, int size, int is_float)
 }
 
 static void
-build_store_routine(codeblock_t *block, int size, int is_float)
+build_store_routine(codeblock_t *block, int size, int is_float, int fast)
 {
     uint32_t *branch_offset;
     uint32_t *misaligned_offset;
 
     /*In - R0 = address, R1 = data
-      Out - R1 = abrt*/
+      Out - R1 = abrt
+      The fast variant only uses the lookup table, and returns R1 = 1 with
+      R0 = address and R2 = data if the access needs the slow path*/
     /*MOV W2, W0, LSR #12
       MOV X3, #writelookup2
       LDR X2, [X3, X2, LSL #3]
@@ -161,7 +212,11 @@ build_store_routine(codeblock_t *block, int size, int is_float)
       LDP X29, X30, [SP, #-16]
       RET
     */
-    codegen_alloc(block, 80);
+    codegen_alloc(block, MEM_ROUTINE_SIZE);
+#    ifdef USE_TLB_STATS
+    if (!fast)
+        build_count_lookup(block, &tlb_stats.write_lookups, REG_X3, REG_X2);
+#    endif
     host_arm64_MOV_REG_LSR(block, REG_W2, REG_W0, 12);
     host_arm64_MOVX_IMM(block, REG_X3, (uint64_t) writelookup2);
     host_arm64_LDRX_REG_LSL3(block, REG_X2, REG_X3, REG_X2);
@@ -181,12 +236,22 @@ build_store_routine(codeblock_t *block, int size, int is_float)
         host_arm64_STR_REG_F32(block, REG_V_TEMP, REG_X2, REG_X0);
     else if (size == 8)
         host_arm64_STR_REG_F64(block, REG_V_TEMP, REG_X2, REG_X0);
+#    ifdef USE_TLB_STATS
+    if (fast)
+        build_count_lookup(block, &tlb_stats.write_lookups, REG_X3, REG_X2);
+#    endif
     host_arm64_MOVZ_IMM(block, REG_X1, 0);
     host_arm64_RET(block, REG_X30);
 
     host_arm64_branch_set_offset(branch_offset, &block_write_data[block_pos]);
     if (size != 1)
         host_arm64_branch_set_offset(misaligned_offset, &block_write_data[block_pos]);
+    if (fast) {
+        host_arm64_MOVX_REG(block, REG_X2, REG_X1, 0);
+        host_arm64_MOVZ_IMM(block, REG_X1, 1);
+        host_arm64_RET(block, REG_X30);
+        return;
+    }
     host_arm64_STP_PREIDX_X(block, REG_X29, REG_X30, REG_XSP, -16);
     if (size == 4 && is_float)
         host_arm64_FMOV_W_S(block, REG_W1, REG_V_TEMP);
@@ -211,30 +276,56 @@ static void
 build_loadstore_routines(codeblock_t *block)
 {
     codegen_mem_load_byte = &block_write_data[block_pos];
-    build_load_routine(block, 1, 0);
+    build_load_routine(block, 1, 0, 0);
     codegen_mem_load_word = &block_write_data[block_pos];
-    build_load_routine(block, 2, 0);
+    build_load_routine(block, 2, 0, 0);
     codegen_mem_load_long = &block_write_data[block_pos];
-    build_load_routine(block, 4, 0);
+    build_load_routine(block, 4, 0, 0);
     codegen_mem_load_quad = &block_write_data[block_pos];
-    build_load_routine(block, 8, 0);
+    build_load_routine(block, 8, 0, 0);
     codegen_mem_load_single = &block_write_data[block_pos];
-    build_load_routine(block, 4, 1);
+    build_load_routine(block, 4, 1, 0);
     codegen_mem_load_double = &block_write_data[block_pos];
-    build_load_routine(block, 8, 1);
+    build_load_routine(block, 8, 1, 0);
 
     codegen_mem_store_byte = &block_write_data[block_pos];
-    build_store_routine(block, 1, 0);
+    build_store_routine(block, 1, 0, 0);
     codegen_mem_store_word = &block_write_data[block_pos];
-    build_store_routine(block, 2, 0);
+    build_store_routine(block, 2, 0, 0);
     codegen_mem_store_long = &block_write_data[block_pos];
-    build_store_routine(block, 4, 0);
+    build_store_routine(block, 4, 0, 0);
     codegen_mem_store_quad = &block_write_data[block_pos];
-    build_store_routine(block, 8, 0);
+    build_store_routine(block, 8, 0, 0);
     codegen_mem_store_single = &block_write_data[block_pos];
-    build_store_routine(block, 4, 1);
+    build_store_routine(block, 4, 1, 0);
     codegen_mem_store_double = &block_write_data[block_pos];
-    build_store_routine(block, 8, 1);
+    build_store_routine(block, 8, 1, 0);
+
+    codegen_mem_load_byte_fast = &block_write_data[block_pos];
+    build_load_routine(block, 1, 0, 1);
+    codegen_mem_load_word_fast = &block_write_data[block_pos];
+    build_load_routine(block, 2, 0, 1);
+    codegen_mem_load_long_fast = &block_write_data[block_pos];
+    build_load_routine(block, 4, 0, 1);
+    codegen_mem_load_quad_fast = &block_write_data[block_pos];
+    build_load_routine(block, 8, 0, 1);
+    codegen_mem_load_single_fast = &block_write_data[block_pos];
+    build_load_routine(block, 4, 1, 1);
+    codegen_mem_load_double_fast = &block_write_data[block_pos];
+    build_load_routine(block, 8, 1, 1);
+
+    codegen_mem_store_byte_fast = &block_write_data[block_pos];
+    build_store_routine(block, 1, 0, 1);
+    codegen_mem_store_word_fast = &block_write_data[block_pos];
+    build_store_routine(block, 2, 0, 1);
+    codegen_mem_store_long_fast = &block_write_data[block_pos];
+    build_store_routine(block, 4, 0, 1);
+    codegen_mem_store_quad_fast = &block_write_data[block_pos];
+    build_store_routine(block, 8, 0, 1);
+    codegen_mem_store_single_fast = &block_write_data[block_pos];
+    build_store_routine(block, 4, 1, 1);
+    codegen_mem_store_double_fast = &block_write_data[block_pos];
+    build_store_routine(block, 8, 1, 1);
 }
 
 static void
@@ -285,13 +376,13 @@ codegen_backend_init(void)
 {
     codeblock_t *block;
 
-    codeblock      = malloc(BLOCK_SIZE * sizeof(codeblock_t));
+    codeblock      = malloc(codegen_block_count * sizeof(codeblock_t));
     codeblock_hash = malloc(HASH_SIZE * sizeof(codeblock_t *));
 
-    memset(codeblock, 0, BLOCK_SIZE * sizeof(codeblock_t));
+    memset(codeblock, 0, codegen_block_count * sizeof(codeblock_t));
     memset(codeblock_hash, 0, HASH_SIZE * sizeof(codeblock_t *));
 
-    for (int c = 0; c < BLOCK_SIZE; c++) {
+    for (int c = 0; c < codegen_block_count; c++) {
         codeblock[c].pc = BLOCK_PC_INVALID;
     }
 
@@ -356,6 +447,20 @@ codegen_backend_prologue(codeblock_t *block)
 
     host_arm64_MOVX_IMM(block, REG_CPUSTATE, (uint64_t) &cpu_state);
 
+    /*Chain entry point. Other blocks branch here with the stack frame and
+      REG_CPUSTATE already set up, skipping the register saves above*/
+    block->chain_entry = NULL;
+    if (!block->page_mask2) {
+        uint32_t *skip_offset = host_arm64_B_(block);
+
+        block->chain_entry = &block_write_data[block_pos];
+        host_arm64_mov_imm(block, REG_ARG0, get_block_nr(block));
+        host_arm64_call(block, (void *) codegen_chain_check);
+        host_arm64_CBNZ(block, REG_X0, (uintptr_t) codegen_exit_rout);
+
+        host_arm64_branch_set_offset(skip_offset, &block_write_data[block_pos]);
+    }
+
     if (block->flags & CODEBLOCK_HAS_FPU) {
         host_arm64_LDR_IMM_W(block, REG_TEMP, REG_CPUSTATE, (uintptr_t) &cpu_state.TOP - (uintptr_t) &cpu_state);
         host_arm64_SUB_IMM(block, REG_TEMP, REG_TEMP, block->TOP);
@@ -363,6 +468,32 @@ codegen_backend_prologue(codeblock_t *block)
     }
 }
 
+void
+codegen_backend_patch_jump(uint8_t *patch, void *dest)
+{
+#    if defined(__APPLE__) && defined(__aarch64__)
+    /*Code memory is already writable while recompiling*/
+    if (!codegen_in_recompile) {
+        if (__builtin_available(macOS 11.0, *)) {
+            pthread_jit_write_protect_np(0);
+        }
+    }
+#    endif
+    host_arm64_branch_patch((uint32_t *) patch, dest);
+#    if defined(__APPLE__) && defined(__aarch64__)
+    if (!codegen_in_recompile) {
+        if (__builtin_available(macOS 11.0, *)) {
+            pthread_jit_write_protect_np(1);
+        }
+    }
+#    endif
+#    ifndef _MSC_VER
+    __clear_cache(patch, patch + 4);
+#    else
+    FlushInstructionCache(GetCurrentProcess(), patch, 4);
+#    endif
+}
+
 void
 codegen_backend_epilogue(codeblock_t *block)
 {
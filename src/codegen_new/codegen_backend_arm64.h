@@ -1,8 +1,7 @@
 #include "codegen_backend_arm64_defs.h"
 
-#define BLOCK_SIZE  0x4000
-#define BLOCK_MASK  0x3fff
-#define BLOCK_START 0
+#define BLOCK_SIZE_DEFAULT 0x4000
+#define BLOCK_START        0
 
 #define HASH_SIZE   0x20000
 #define HASH_MASK   0x1ffff
@@ -11,6 +10,9 @@
 
 #define BLOCK_MAX   0x3c0
 
+#define CODEGEN_BACKEND_HAS_CHAINING
+#define CODEGEN_BACKEND_HAS_EXIT_WRITEBACK
+
 void host_arm64_BLR(codeblock_t *block, int addr_reg);
 void host_arm64_CBNZ(codeblock_t *block, int reg, uintptr_t dest);
 void host_arm64_MOVK_IMM(codeblock_t *block, int reg, uint32_t imm_data);
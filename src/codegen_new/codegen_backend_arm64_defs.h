@@ -128,6 +128,21 @@ extern void *codegen_mem_store_quad;
 extern void *codegen_mem_store_single;
 extern void *codegen_mem_store_double;
 
+/*Lookup table only variants of the above, see codegen_mem_call()*/
+extern void *codegen_mem_load_byte_fast;
+extern void *codegen_mem_load_word_fast;
+extern void *codegen_mem_load_long_fast;
+extern void *codegen_mem_load_quad_fast;
+extern void *codegen_mem_load_single_fast;
+extern void *codegen_mem_load_double_fast;
+
+extern void *codegen_mem_store_byte_fast;
+extern void *codegen_mem_store_word_fast;
+extern void *codegen_mem_store_long_fast;
+extern void *codegen_mem_store_quad_fast;
+extern void *codegen_mem_store_single_fast;
+extern void *codegen_mem_store_double_fast;
+
 extern void *codegen_fp_round;
 extern void *codegen_fp_round_quad;
 
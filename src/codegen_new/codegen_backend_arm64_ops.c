@@ -459,6 +459,13 @@ host_arm64_BLR(codeblock_t *block, int addr_reg)
     codegen_addlong(block, OPCODE_BLR | Rn(addr_reg));
 }
 
+uint32_t *
+host_arm64_B_(codeblock_t *block)
+{
+    codegen_alloc(block, 4);
+    codegen_addlong(block, OPCODE_B);
+    return (uint32_t *) &block_write_data[block_pos - 4];
+}
 uint32_t *
 host_arm64_BCC_(codeblock_t *block)
 {
@@ -579,6 +586,16 @@ host_arm64_branch_set_offset(uint32_t *opcode, void *dest)
     *opcode |= OFFSET26(offset);
 }
 
+void
+host_arm64_branch_patch(uint32_t *opcode, void *dest)
+{
+    int offset = (uintptr_t) dest - (uintptr_t) opcode;
+
+    if (!offset_is_26bit(offset))
+        fatal("host_arm64_branch_patch - offset out of range %x\n", offset);
+    *opcode = OPCODE_B | OFFSET26(offset);
+}
+
 void
 host_arm64_BR(codeblock_t *block, int addr_reg)
 {
@@ -28,6 +28,7 @@ void host_arm64_BLR(codeblock_t *block, int addr_reg);
 
 void host_arm64_BEQ(codeblock_t *block, void *dest);
 
+uint32_t *host_arm64_B_(codeblock_t *block);
 uint32_t *host_arm64_BCC_(codeblock_t *block);
 uint32_t *host_arm64_BCS_(codeblock_t *block);
 uint32_t *host_arm64_BEQ_(codeblock_t *block);
@@ -44,6 +45,8 @@ uint32_t *host_arm64_BVC_(codeblock_t *block);
 uint32_t *host_arm64_BVS_(codeblock_t *block);
 
 void host_arm64_branch_set_offset(uint32_t *opcode, void *dest);
+/*Replace the branch at opcode with an unconditional branch to dest*/
+void host_arm64_branch_patch(uint32_t *opcode, void *dest);
 
 void host_arm64_BR(codeblock_t *block, int addr_reg);
 
@@ -812,6 +812,25 @@ codegen_JMP(codeblock_t *block, uop_t *uop)
 
     return 0;
 }
+static int
+codegen_JMP_CHAIN(codeblock_t *block, uop_t *uop)
+{
+    int link_nr = (int) uop->imm_data;
+
+    if (link_nr != -1) {
+        /*Patchable branch, initially to the unlinked exit immediately after it*/
+        uint32_t *patch = host_arm64_B_(block);
+
+        host_arm64_branch_set_offset(patch, &block_write_data[block_pos]);
+        codegen_block_link_set_site(link_nr, (uint8_t *) patch, &block_write_data[block_pos]);
+        host_arm64_MOVX_IMM(block, REG_TEMP, (uint64_t) (uintptr_t) &codegen_chain_exit);
+        host_arm64_mov_imm(block, REG_TEMP2, link_nr);
+        host_arm64_STR_IMM_W(block, REG_TEMP2, REG_TEMP, 0);
+    }
+    host_arm64_B(block, codegen_exit_rout);
+
+    return 0;
+}
 
 static int
 codegen_LOAD_FUNC_ARG0(codeblock_t *block, uop_t *uop)
@@ -891,6 +910,41 @@ codegen_LOAD_SEG(codeblock_t *block, uop_t *uop)
     return 0;
 }
 
+/*Call a memory access routine, and exit the block if it aborted.
+
+  Dirty registers are kept in host registers across the access, so are not yet
+  in cpu_state. This is only valid while the access goes through the lookup
+  tables; the memory handlers called on the slow path may read the emulated
+  registers from cpu_state. So if anything is dirty the lookup only routine is
+  called first, and on a miss the registers are written back before the full
+  routine is run. The writeback only uses REG_TEMP and REG_TEMP2, so the
+  address in X0 and the store data in X2 survive it.
+
+  Memory handlers must never modify the emulated registers in cpu_state, as
+  the block would continue with the stale copies held in host registers.*/
+static void
+codegen_mem_call(codeblock_t *block, uop_t *uop, void *rout, void *fast_rout)
+{
+    if (codegen_reg_exit_dirty(uop->dest_reg_a)) {
+        uint32_t *branch_ptr;
+
+        host_arm64_call(block, fast_rout);
+        host_arm64_CMPX_IMM(block, REG_X1, 0);
+        branch_ptr = host_arm64_BEQ_(block);
+
+        codegen_reg_writeback_exit(block, uop->dest_reg_a);
+        if (ir_reg_is_invalid(uop->dest_reg_a))
+            host_arm64_MOVX_REG(block, REG_X1, REG_X2, 0);
+        host_arm64_call(block, rout);
+        host_arm64_CBNZ(block, REG_X1, (uintptr_t) codegen_exit_rout);
+
+        host_arm64_branch_set_offset(branch_ptr, &block_write_data[block_pos]);
+    } else {
+        host_arm64_call(block, rout);
+        host_arm64_CBNZ(block, REG_X1, (uintptr_t) codegen_exit_rout);
+    }
+}
+
 static int
 codegen_MEM_LOAD_ABS(codeblock_t *block, uop_t *uop)
 {
@@ -900,14 +954,13 @@ codegen_MEM_LOAD_ABS(codeblock_t *block, uop_t *uop)
 
     host_arm64_ADD_IMM(block, REG_X0, seg_reg, uop->imm_data);
     if (REG_IS_B(dest_size) || REG_IS_BH(dest_size)) {
-        host_arm64_call(block, codegen_mem_load_byte);
+        codegen_mem_call(block, uop, codegen_mem_load_byte, codegen_mem_load_byte_fast);
     } else if (REG_IS_W(dest_size)) {
-        host_arm64_call(block, codegen_mem_load_word);
+        codegen_mem_call(block, uop, codegen_mem_load_word, codegen_mem_load_word_fast);
     } else if (REG_IS_L(dest_size)) {
-        host_arm64_call(block, codegen_mem_load_long);
+        codegen_mem_call(block, uop, codegen_mem_load_long, codegen_mem_load_long_fast);
     } else
         fatal("MEM_LOAD_ABS - %02x\n", uop->dest_reg_a_real);
-    host_arm64_CBNZ(block, REG_X1, (uintptr_t) codegen_exit_rout);
     if (REG_IS_B(dest_size)) {
         host_arm64_BFI(block, dest_reg, REG_X0, 0, 8);
     } else if (REG_IS_BH(dest_size)) {
@@ -934,16 +987,15 @@ codegen_MEM_LOAD_REG(codeblock_t *block, uop_t *uop)
     if (uop->is_a16)
         host_arm64_AND_IMM(block, REG_X0, REG_X0, 0xffff);
     if (REG_IS_B(dest_size) || REG_IS_BH(dest_size)) {
-        host_arm64_call(block, codegen_mem_load_byte);
+        codegen_mem_call(block, uop, codegen_mem_load_byte, codegen_mem_load_byte_fast);
     } else if (REG_IS_W(dest_size)) {
-        host_arm64_call(block, codegen_mem_load_word);
+        codegen_mem_call(block, uop, codegen_mem_load_word, codegen_mem_load_word_fast);
     } else if (REG_IS_L(dest_size)) {
-        host_arm64_call(block, codegen_mem_load_long);
+        codegen_mem_call(block, uop, codegen_mem_load_long, codegen_mem_load_long_fast);
     } else if (REG_IS_Q(dest_size)) {
-        host_arm64_call(block, codegen_mem_load_quad);
+        codegen_mem_call(block, uop, codegen_mem_load_quad, codegen_mem_load_quad_fast);
     } else
         fatal("MEM_LOAD_REG - %02x\n", uop->dest_reg_a_real);
-    host_arm64_CBNZ(block, REG_X1, (uintptr_t) codegen_exit_rout);
     if (REG_IS_B(dest_size)) {
         host_arm64_BFI(block, dest_reg, REG_X0, 0, 8);
     } else if (REG_IS_BH(dest_size)) {
@@ -972,8 +1024,7 @@ codegen_MEM_LOAD_DOUBLE(codeblock_t *block, uop_t *uop)
     host_arm64_ADD_REG(block, REG_X0, seg_reg, addr_reg, 0);
     if (uop->imm_data)
         host_arm64_ADD_IMM(block, REG_X0, REG_X0, uop->imm_data);
-    host_arm64_call(block, codegen_mem_load_double);
-    host_arm64_CBNZ(block, REG_X1, (uintptr_t) codegen_exit_rout);
+    codegen_mem_call(block, uop, codegen_mem_load_double, codegen_mem_load_double_fast);
     host_arm64_FMOV_D_D(block, dest_reg, REG_V_TEMP);
 
     return 0;
@@ -992,8 +1043,7 @@ codegen_MEM_LOAD_SINGLE(codeblock_t *block, uop_t *uop)
     host_arm64_ADD_REG(block, REG_X0, seg_reg, addr_reg, 0);
     if (uop->imm_data)
         host_arm64_ADD_IMM(block, REG_X0, REG_X0, uop->imm_data);
-    host_arm64_call(block, codegen_mem_load_single);
-    host_arm64_CBNZ(block, REG_X1, (uintptr_t) codegen_exit_rout);
+    codegen_mem_call(block, uop, codegen_mem_load_single, codegen_mem_load_single_fast);
     host_arm64_FCVT_D_S(block, dest_reg, REG_V_TEMP);
 
     return 0;
@@ -1009,19 +1059,18 @@ codegen_MEM_STORE_ABS(codeblock_t *block, uop_t *uop)
     host_arm64_ADD_IMM(block, REG_W0, seg_reg, uop->imm_data);
     if (REG_IS_B(src_size)) {
         host_arm64_AND_IMM(block, REG_W1, src_reg, 0xff);
-        host_arm64_call(block, codegen_mem_store_byte);
+        codegen_mem_call(block, uop, codegen_mem_store_byte, codegen_mem_store_byte_fast);
     } else if (REG_IS_BH(src_size)) {
         host_arm64_UBFX(block, REG_W1, src_reg, 8, 8);
-        host_arm64_call(block, codegen_mem_store_byte);
+        codegen_mem_call(block, uop, codegen_mem_store_byte, codegen_mem_store_byte_fast);
     } else if (REG_IS_W(src_size)) {
         host_arm64_AND_IMM(block, REG_W1, src_reg, 0xffff);
-        host_arm64_call(block, codegen_mem_store_word);
+        codegen_mem_call(block, uop, codegen_mem_store_word, codegen_mem_store_word_fast);
     } else if (REG_IS_L(src_size)) {
         host_arm64_MOV_REG(block, REG_W1, src_reg, 0);
-        host_arm64_call(block, codegen_mem_store_long);
+        codegen_mem_call(block, uop, codegen_mem_store_long, codegen_mem_store_long_fast);
     } else
         fatal("MEM_STORE_ABS - %02x\n", uop->dest_reg_a_real);
-    host_arm64_CBNZ(block, REG_X1, (uintptr_t) codegen_exit_rout);
 
     return 0;
 }
@@ -1038,22 +1087,21 @@ codegen_MEM_STORE_REG(codeblock_t *block, uop_t *uop)
         host_arm64_ADD_IMM(block, REG_X0, REG_X0, uop->imm_data);
     if (REG_IS_B(src_size)) {
         host_arm64_AND_IMM(block, REG_W1, src_reg, 0xff);
-        host_arm64_call(block, codegen_mem_store_byte);
+        codegen_mem_call(block, uop, codegen_mem_store_byte, codegen_mem_store_byte_fast);
     } else if (REG_IS_BH(src_size)) {
         host_arm64_UBFX(block, REG_W1, src_reg, 8, 8);
-        host_arm64_call(block, codegen_mem_store_byte);
+        codegen_mem_call(block, uop, codegen_mem_store_byte, codegen_mem_store_byte_fast);
     } else if (REG_IS_W(src_size)) {
         host_arm64_AND_IMM(block, REG_W1, src_reg, 0xffff);
-        host_arm64_call(block, codegen_mem_store_word);
+        codegen_mem_call(block, uop, codegen_mem_store_word, codegen_mem_store_word_fast);
     } else if (REG_IS_L(src_size)) {
         host_arm64_MOV_REG(block, REG_W1, src_reg, 0);
-        host_arm64_call(block, codegen_mem_store_long);
+        codegen_mem_call(block, uop, codegen_mem_store_long, codegen_mem_store_long_fast);
     } else if (REG_IS_Q(src_size)) {
         host_arm64_FMOV_D_D(block, REG_V_TEMP, src_reg);
-        host_arm64_call(block, codegen_mem_store_quad);
+        codegen_mem_call(block, uop, codegen_mem_store_quad, codegen_mem_store_quad_fast);
     } else
         fatal("MEM_STORE_REG - %02x\n", uop->src_reg_c_real);
-    host_arm64_CBNZ(block, REG_X1, (uintptr_t) codegen_exit_rout);
 
     return 0;
 }
@@ -1066,8 +1114,7 @@ codegen_MEM_STORE_IMM_8(codeblock_t *block, uop_t *uop)
 
     host_arm64_ADD_REG(block, REG_W0, seg_reg, addr_reg, 0);
     host_arm64_mov_imm(block, REG_W1, uop->imm_data);
-    host_arm64_call(block, codegen_mem_store_byte);
-    host_arm64_CBNZ(block, REG_X1, (uintptr_t) codegen_exit_rout);
+    codegen_mem_call(block, uop, codegen_mem_store_byte, codegen_mem_store_byte_fast);
 
     return 0;
 }
@@ -1079,8 +1126,7 @@ codegen_MEM_STORE_IMM_16(codeblock_t *block, uop_t *uop)
 
     host_arm64_ADD_REG(block, REG_W0, seg_reg, addr_reg, 0);
     host_arm64_mov_imm(block, REG_W1, uop->imm_data);
-    host_arm64_call(block, codegen_mem_store_word);
-    host_arm64_CBNZ(block, REG_X1, (uintptr_t) codegen_exit_rout);
+    codegen_mem_call(block, uop, codegen_mem_store_word, codegen_mem_store_word_fast);
 
     return 0;
 }
@@ -1092,8 +1138,7 @@ codegen_MEM_STORE_IMM_32(codeblock_t *block, uop_t *uop)
 
     host_arm64_ADD_REG(block, REG_W0, seg_reg, addr_reg, 0);
     host_arm64_mov_imm(block, REG_W1, uop->imm_data);
-    host_arm64_call(block, codegen_mem_store_long);
-    host_arm64_CBNZ(block, REG_X1, (uintptr_t) codegen_exit_rout);
+    codegen_mem_call(block, uop, codegen_mem_store_long, codegen_mem_store_long_fast);
 
     return 0;
 }
@@ -1113,8 +1158,7 @@ codegen_MEM_STORE_SINGLE(codeblock_t *block, uop_t *uop)
     if (uop->imm_data)
         host_arm64_ADD_IMM(block, REG_X0, REG_X0, uop->imm_data);
     host_arm64_FCVT_S_D(block, REG_V_TEMP, src_reg);
-    host_arm64_call(block, codegen_mem_store_single);
-    host_arm64_CBNZ(block, REG_X1, (uintptr_t) codegen_exit_rout);
+    codegen_mem_call(block, uop, codegen_mem_store_single, codegen_mem_store_single_fast);
 
     return 0;
 }
@@ -1133,8 +1177,7 @@ codegen_MEM_STORE_DOUBLE(codeblock_t *block, uop_t *uop)
     if (uop->imm_data)
         host_arm64_ADD_IMM(block, REG_X0, REG_X0, uop->imm_data);
     host_arm64_FMOV_D_D(block, REG_V_TEMP, src_reg);
-    host_arm64_call(block, codegen_mem_store_double);
-    host_arm64_CBNZ(block, REG_X1, (uintptr_t) codegen_exit_rout);
+    codegen_mem_call(block, uop, codegen_mem_store_double, codegen_mem_store_double_fast);
 
     return 0;
 }
@@ -2922,6 +2965,9 @@ const uOpFn uop_handlers[UOP_MAX] = {
     [UOP_JMP &
         UOP_MASK]
     = codegen_JMP,
+    [UOP_JMP_CHAIN &
+        UOP_MASK]
+    = codegen_JMP_CHAIN,
 
     [UOP_LOAD_SEG &
         UOP_MASK]
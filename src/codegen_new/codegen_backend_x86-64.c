@@ -24,6 +24,11 @@
 #    if defined WIN32 || defined _WIN32 || defined _WIN32
 #        include <windows.h>
 #    endif
+#    ifdef _MSC_VER
+#        include <intrin.h>
+#    else
+#        include <cpuid.h>
+#    endif
 #    include <string.h>
 
 void *codegen_mem_load_byte;
@@ -40,9 +45,25 @@ void *codegen_mem_store_quad;
 void *codegen_mem_store_single;
 void *codegen_mem_store_double;
 
+void *codegen_mem_load_byte_fast;
+void *codegen_mem_load_word_fast;
+void *codegen_mem_load_long_fast;
+void *codegen_mem_load_quad_fast;
+void *codegen_mem_load_single_fast;
+void *codegen_mem_load_double_fast;
+
+void *codegen_mem_store_byte_fast;
+void *codegen_mem_store_word_fast;
+void *codegen_mem_store_long_fast;
+void *codegen_mem_store_quad_fast;
+void *codegen_mem_store_single_fast;
+void *codegen_mem_store_double_fast;
+
 void *codegen_gpf_rout;
 void *codegen_exit_rout;
 
+int host_x86_features;
+
 host_reg_def_t codegen_host_reg_list[CODEGEN_HOST_REGS] = {
   /*Note: while EAX and EDX are normally volatile registers under x86
   calling conventions, the recompiler will explicitly save and restore
@@ -69,14 +90,27 @@ host_reg_def_t codegen_host_fp_reg_list[CODEGEN_HOST_FP_REGS] = {
     { REG_XMM5, HOST_REG_FLAG_VOLATILE}
 };
 
+#    ifdef USE_TLB_STATS
+/*Count a TLB lookup, corrupting RDI. The full routines count on entry, the
+  fast ones only on a hit, as a miss goes on to call the full routine*/
+static void
+build_count_lookup(codeblock_t *block, uint64_t *counter)
+{
+    host_x86_MOV64_REG_IMM(block, REG_RDI, (uint64_t) (uintptr_t) counter);
+    host_x86_ADD64_BASE_OFFSET_IMM(block, REG_RDI, 0, 1);
+}
+#    endif
+
 static void
-build_load_routine(codeblock_t *block, int size, int is_float)
+build_load_routine(codeblock_t *block, int size, int is_float, int fast)
 {
     uint8_t *branch_offset;
     uint8_t *misaligned_offset = NULL;
 
     /*In - ESI = address
-      Out - ECX = data, ESI = abrt*/
+      Out - ECX = data, ESI = abrt
+      The fast variant only uses the lookup table, and returns ESI = 1 with
+      ECX = address if the access needs the slow path*/
     /*MOV ECX, ESI
       SHR ESI, 12
       MOV RSI, [readlookup2+ESI*4]
@@ -95,6 +129,10 @@ build_load_routine(codeblock_t *block, int size, int is_float)
       MOVZX ECX, AL
       RET
     */
+#    ifdef USE_TLB_STATS
+    if (!fast)
+        build_count_lookup(block, &tlb_stats.read_lookups);
+#    endif
     host_x86_MOV32_REG_REG(block, REG_ECX, REG_ESI);
     host_x86_SHR32_IMM(block, REG_ESI, 12);
     host_x86_MOV64_REG_IMM(block, REG_RDI, (uint64_t) (uintptr_t) readlookup2);
@@ -117,12 +155,21 @@ build_load_routine(codeblock_t *block, int size, int is_float)
         host_x86_MOVQ_XREG_BASE_INDEX(block, REG_XMM_TEMP, REG_RSI, REG_RCX);
     else
         fatal("build_load_routine: size=%i\n", size);
+#    ifdef USE_TLB_STATS
+    if (fast)
+        build_count_lookup(block, &tlb_stats.read_lookups);
+#    endif
     host_x86_XOR32_REG_REG(block, REG_ESI, REG_ESI);
     host_x86_RET(block);
 
     *branch_offset = (uint8_t) ((uintptr_t) &block_write_data[block_pos] - (uintptr_t) branch_offset) - 1;
     if (size != 1)
         *misaligned_offset = (uint8_t) ((uintptr_t) &block_write_data[block_pos] - (uintptr_t) misaligned_offset) - 1;
+    if (fast) {
+        host_x86_MOV32_REG_IMM(block, REG_ESI, 1);
+        host_x86_RET(block);
+        return;
+    }
     host_x86_PUSH(block, REG_RAX);
     host_x86_PUSH(block, REG_RDX);
 #    if _WIN64
@@ -158,14 +205,17 @@ build_load_routine(codeblock_t *block, int size, int is_float)
 }
 
 static void
-build_store_routine(codeblock_t *block, int size, int is_float)
+build_store_routine(codeblock_t *block, int size, int is_float, int fast)
 {
     uint8_t *branch_offset;
     uint8_t *misaligned_offset = NULL;
 
     /*In - ECX = data, ESI = address
       Out - ESI = abrt
-      Corrupts EDI*/
+      Corrupts EDI
+      The fast variant only uses the lookup table, and returns ESI = 1 with
+      EDI = address and ECX still holding the data if the access needs the
+      slow path*/
     /*MOV EDI, ESI
       SHR ESI, 12
       MOV ESI, [writelookup2+ESI*4]
@@ -184,6 +234,10 @@ build_store_routine(codeblock_t *block, int size, int is_float)
       MOVZX ECX, AL
       RET
     */
+#    ifdef USE_TLB_STATS
+    if (!fast)
+        build_count_lookup(block, &tlb_stats.write_lookups);
+#    endif
     host_x86_MOV32_REG_REG(block, REG_EDI, REG_ESI);
     host_x86_SHR32_IMM(block, REG_ESI, 12);
     host_x86_MOV64_REG_IMM(block, REG_R8, (uint64_t) (uintptr_t) writelookup2);
@@ -206,12 +260,21 @@ build_store_routine(codeblock_t *block, int size, int is_float)
         host_x86_MOVQ_BASE_INDEX_XREG(block, REG_RSI, REG_RDI, REG_XMM_TEMP);
     else
         fatal("build_store_routine: size=%i\n", size);
+#    ifdef USE_TLB_STATS
+    if (fast)
+        build_count_lookup(block, &tlb_stats.write_lookups);
+#    endif
     host_x86_XOR32_REG_REG(block, REG_ESI, REG_ESI);
     host_x86_RET(block);
 
     *branch_offset = (uint8_t) ((uintptr_t) &block_write_data[block_pos] - (uintptr_t) branch_offset) - 1;
     if (size != 1)
         *misaligned_offset = (uint8_t) ((uintptr_t) &block_write_data[block_pos] - (uintptr_t) misaligned_offset) - 1;
+    if (fast) {
+        host_x86_MOV32_REG_IMM(block, REG_ESI, 1);
+        host_x86_RET(block);
+        return;
+    }
     host_x86_PUSH(block, REG_RAX);
     host_x86_PUSH(block, REG_RDX);
 #    if _WIN64
@@ -256,30 +319,108 @@ static void
 build_loadstore_routines(codeblock_t *block)
 {
     codegen_mem_load_byte = &codeblock[block_current].data[block_pos];
-    build_load_routine(block, 1, 0);
+    build_load_routine(block, 1, 0, 0);
     codegen_mem_load_word = &codeblock[block_current].data[block_pos];
-    build_load_routine(block, 2, 0);
+    build_load_routine(block, 2, 0, 0);
     codegen_mem_load_long = &codeblock[block_current].data[block_pos];
-    build_load_routine(block, 4, 0);
+    build_load_routine(block, 4, 0, 0);
     codegen_mem_load_quad = &codeblock[block_current].data[block_pos];
-    build_load_routine(block, 8, 0);
+    build_load_routine(block, 8, 0, 0);
     codegen_mem_load_single = &codeblock[block_current].data[block_pos];
-    build_load_routine(block, 4, 1);
+    build_load_routine(block, 4, 1, 0);
     codegen_mem_load_double = &codeblock[block_current].data[block_pos];
-    build_load_routine(block, 8, 1);
+    build_load_routine(block, 8, 1, 0);
 
     codegen_mem_store_byte = &codeblock[block_current].data[block_pos];
-    build_store_routine(block, 1, 0);
+    build_store_routine(block, 1, 0, 0);
     codegen_mem_store_word = &codeblock[block_current].data[block_pos];
-    build_store_routine(block, 2, 0);
+    build_store_routine(block, 2, 0, 0);
     codegen_mem_store_long = &codeblock[block_current].data[block_pos];
-    build_store_routine(block, 4, 0);
+    build_store_routine(block, 4, 0, 0);
     codegen_mem_store_quad = &codeblock[block_current].data[block_pos];
-    build_store_routine(block, 8, 0);
+    build_store_routine(block, 8, 0, 0);
     codegen_mem_store_single = &codeblock[block_current].data[block_pos];
-    build_store_routine(block, 4, 1);
+    build_store_routine(block, 4, 1, 0);
     codegen_mem_store_double = &codeblock[block_current].data[block_pos];
-    build_store_routine(block, 8, 1);
+    build_store_routine(block, 8, 1, 0);
+
+    codegen_mem_load_byte_fast = &codeblock[block_current].data[block_pos];
+    build_load_routine(block, 1, 0, 1);
+    codegen_mem_load_word_fast = &codeblock[block_current].data[block_pos];
+    build_load_routine(block, 2, 0, 1);
+    codegen_mem_load_long_fast = &codeblock[block_current].data[block_pos];
+    build_load_routine(block, 4, 0, 1);
+    codegen_mem_load_quad_fast = &codeblock[block_current].data[block_pos];
+    build_load_routine(block, 8, 0, 1);
+    codegen_mem_load_single_fast = &codeblock[block_current].data[block_pos];
+    build_load_routine(block, 4, 1, 1);
+    codegen_mem_load_double_fast = &codeblock[block_current].data[block_pos];
+    build_load_routine(block, 8, 1, 1);
+
+    codegen_mem_store_byte_fast = &codeblock[block_current].data[block_pos];
+    build_store_routine(block, 1, 0, 1);
+    codegen_mem_store_word_fast = &codeblock[block_current].data[block_pos];
+    build_store_routine(block, 2, 0, 1);
+    codegen_mem_store_long_fast = &codeblock[block_current].data[block_pos];
+    build_store_routine(block, 4, 0, 1);
+    codegen_mem_store_quad_fast = &codeblock[block_current].data[block_pos];
+    build_store_routine(block, 8, 0, 1);
+    codegen_mem_store_single_fast = &codeblock[block_current].data[block_pos];
+    build_store_routine(block, 4, 1, 1);
+    codegen_mem_store_double_fast = &codeblock[block_current].data[block_pos];
+    build_store_routine(block, 8, 1, 1);
+}
+
+static void
+host_x86_cpuid(uint32_t leaf, uint32_t regs[4])
+{
+#    ifdef _MSC_VER
+    __cpuidex((int *) regs, leaf, 0);
+#    else
+    __cpuid_count(leaf, 0, regs[0], regs[1], regs[2], regs[3]);
+#    endif
+}
+
+static uint64_t
+host_x86_xgetbv(void)
+{
+#    ifdef _MSC_VER
+    return _xgetbv(0);
+#    else
+    uint32_t eax;
+    uint32_t edx;
+
+    __asm__ volatile("xgetbv"
+                     : "=a"(eax), "=d"(edx)
+                     : "c"(0));
+    return ((uint64_t) edx << 32) | eax;
+#    endif
+}
+
+static void
+host_x86_probe_features(void)
+{
+    uint32_t regs[4];
+    uint32_t max_leaf;
+
+    host_x86_features = 0;
+
+    host_x86_cpuid(0, regs);
+    max_leaf = regs[0];
+
+    host_x86_cpuid(1, regs);
+    /*VEX encoded SSE instructions also need the OS to save YMM state*/
+    if ((regs[2] & (1 << 27)) && (regs[2] & (1 << 28)) && ((host_x86_xgetbv() & 6) == 6))
+        host_x86_features |= HOST_X86_FEATURE_AVX;
+
+    if (max_leaf >= 7) {
+        host_x86_cpuid(7, regs);
+        if (regs[1] & (1 << 8))
+            host_x86_features |= HOST_X86_FEATURE_BMI2;
+    }
+
+    pclog("Dynarec: host supports%s%s%s\n", (host_x86_features & HOST_X86_FEATURE_AVX) ? " AVX" : "",
+          (host_x86_features & HOST_X86_FEATURE_BMI2) ? " BMI2" : "", host_x86_features ? "" : " baseline x86-64 only");
 }
 
 void
@@ -288,13 +429,15 @@ codegen_backend_init(void)
     codeblock_t *block;
     int          c;
 
-    codeblock      = malloc(BLOCK_SIZE * sizeof(codeblock_t));
+    host_x86_probe_features();
+
+    codeblock      = malloc(codegen_block_count * sizeof(codeblock_t));
     codeblock_hash = malloc(HASH_SIZE * sizeof(codeblock_t *));
 
-    memset(codeblock, 0, BLOCK_SIZE * sizeof(codeblock_t));
+    memset(codeblock, 0, codegen_block_count * sizeof(codeblock_t));
     memset(codeblock_hash, 0, HASH_SIZE * sizeof(codeblock_t *));
 
-    for (c = 0; c < BLOCK_SIZE; c++)
+    for (c = 0; c < codegen_block_count; c++)
         codeblock[c].pc = BLOCK_PC_INVALID;
 
     block_current                           = 0;
@@ -366,6 +509,26 @@ codegen_backend_prologue(codeblock_t *block)
     host_x86_SUB64_REG_IMM(block, REG_RSP, 0x48);
 #endif
     host_x86_MOV64_REG_IMM(block, REG_RBP, ((uintptr_t) &cpu_state) + 128);
+
+    /*Chain entry point. Other blocks jump here with the stack frame and RBP
+      already set up, skipping the register saves above*/
+    block->chain_entry = NULL;
+    if (!block->page_mask2) {
+        uint8_t *skip_offset = host_x86_JMP_short(block);
+
+        block->chain_entry = &block_write_data[block_pos];
+#    if _WIN64
+        host_x86_MOV32_REG_IMM(block, REG_ECX, get_block_nr(block));
+#    else
+        host_x86_MOV32_REG_IMM(block, REG_EDI, get_block_nr(block));
+#    endif
+        host_x86_CALL(block, (void *) codegen_chain_check);
+        host_x86_TEST32_REG(block, REG_EAX, REG_EAX);
+        host_x86_JNZ(block, codegen_exit_rout);
+
+        *skip_offset = (uint8_t) ((uintptr_t) &block_write_data[block_pos] - (uintptr_t) skip_offset) - 1;
+    }
+
     if (block->flags & CODEBLOCK_HAS_FPU) {
         host_x86_MOV32_REG_ABS(block, REG_EAX, &cpu_state.TOP);
         host_x86_SUB32_REG_IMM(block, REG_EAX, block->TOP);
@@ -375,6 +538,12 @@ codegen_backend_prologue(codeblock_t *block)
         host_x86_MOV64_REG_IMM(block, REG_R12, ((uintptr_t) ram) + 2147483648ULL);
 }
 
+void
+codegen_backend_patch_jump(uint8_t *patch, void *dest)
+{
+    *(uint32_t *) patch = (uintptr_t) dest - ((uintptr_t) patch + 4);
+}
+
 void
 codegen_backend_epilogue(codeblock_t *block)
 {
@@ -1,8 +1,7 @@
 #include "codegen_backend_x86-64_defs.h"
 
-#define BLOCK_SIZE  0x4000
-#define BLOCK_MASK  0x3fff
-#define BLOCK_START 0
+#define BLOCK_SIZE_DEFAULT 0x4000
+#define BLOCK_START        0
 
 #define HASH_SIZE   0x20000
 #define HASH_MASK   0x1ffff
@@ -12,3 +11,5 @@
 #define BLOCK_MAX   0x3c0
 
 #define CODEGEN_BACKEND_HAS_MOV_IMM
+#define CODEGEN_BACKEND_HAS_CHAINING
+#define CODEGEN_BACKEND_HAS_EXIT_WRITEBACK
@@ -49,6 +49,12 @@
 #define CODEGEN_HOST_REGS    3
 #define CODEGEN_HOST_FP_REGS 7
 
+/*Optional host instruction set extensions, probed by codegen_backend_init()*/
+#define HOST_X86_FEATURE_BMI2 (1 << 0) /*SHLX/SHRX/SARX/RORX*/
+#define HOST_X86_FEATURE_AVX  (1 << 1) /*VEX encoded SSE*/
+
+extern int host_x86_features;
+
 extern void *codegen_mem_load_byte;
 extern void *codegen_mem_load_word;
 extern void *codegen_mem_load_long;
@@ -63,5 +69,20 @@ extern void *codegen_mem_store_quad;
 extern void *codegen_mem_store_single;
 extern void *codegen_mem_store_double;
 
+/*Lookup table only variants of the above, see codegen_mem_call()*/
+extern void *codegen_mem_load_byte_fast;
+extern void *codegen_mem_load_word_fast;
+extern void *codegen_mem_load_long_fast;
+extern void *codegen_mem_load_quad_fast;
+extern void *codegen_mem_load_single_fast;
+extern void *codegen_mem_load_double_fast;
+
+extern void *codegen_mem_store_byte_fast;
+extern void *codegen_mem_store_word_fast;
+extern void *codegen_mem_store_long_fast;
+extern void *codegen_mem_store_quad_fast;
+extern void *codegen_mem_store_single_fast;
+extern void *codegen_mem_store_double_fast;
+
 extern void *codegen_gpf_rout;
 extern void *codegen_exit_rout;
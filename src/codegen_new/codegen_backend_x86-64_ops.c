@@ -130,6 +130,19 @@ host_x86_ADD64_REG_IMM(codeblock_t *block, int dst_reg, uint64_t imm_data)
         fatal("ADD64_REG_IMM !is_imm8 %016" PRIx64 "\n", imm_data);
 }
 void
+host_x86_ADD64_BASE_OFFSET_IMM(codeblock_t *block, int base_reg, int offset, uint8_t imm_data)
+{
+    if ((base_reg & 8) || (base_reg == REG_RSP))
+        fatal("host_x86_ADD64_BASE_OFFSET_IMM - base_reg %i\n", base_reg);
+
+    if (offset >= -128 && offset <= 127) {
+        codegen_alloc_bytes(block, 5);
+        codegen_addbyte(block, 0x48); /*ADD QWORD PTR [base_reg + offset], imm_data*/
+        codegen_addbyte4(block, 0x83, 0x40 | RM_OP_ADD | base_reg, offset, imm_data);
+    } else
+        fatal("ADD64_BASE_OFFSET_IMM - offset %i\n", offset);
+}
+void
 host_x86_ADD8_REG_REG(codeblock_t *block, int dst_reg, int src_reg)
 {
     if ((dst_reg & 8) || (src_reg & 8))
@@ -325,6 +338,13 @@ host_x86_JZ(codeblock_t *block, void *p)
     codegen_addlong(block, (uintptr_t) p - (uintptr_t) &block_write_data[block_pos + 4]);
 }
 
+uint8_t *
+host_x86_JMP_short(codeblock_t *block)
+{
+    codegen_alloc_bytes(block, 2);
+    codegen_addbyte2(block, 0xeb, 0); /*JMP*/
+    return &block_write_data[block_pos - 1];
+}
 uint8_t *
 host_x86_JNZ_short(codeblock_t *block)
 {
@@ -347,6 +367,14 @@ host_x86_JZ_short(codeblock_t *block)
     return &block_write_data[block_pos - 1];
 }
 
+uint32_t *
+host_x86_JMP_long(codeblock_t *block)
+{
+    codegen_alloc_bytes(block, 5);
+    codegen_addbyte(block, 0xe9); /*JMP*/
+    codegen_addlong(block, 0);
+    return (uint32_t *) &block_write_data[block_pos - 4];
+}
 uint32_t *
 host_x86_JNB_long(codeblock_t *block)
 {
@@ -1421,6 +1449,15 @@ host_x86_ROR32_IMM(codeblock_t *block, int dst_reg, int shift)
     codegen_alloc_bytes(block, 3);
     codegen_addbyte3(block, 0xc1, 0xc0 | RM_OP_ROR | dst_reg, shift); /*SHR dst_reg, shift*/
 }
+void
+host_x86_RORX32_IMM(codeblock_t *block, int dst_reg, int src_reg, int shift)
+{
+    if ((dst_reg | src_reg) & 8)
+        fatal("RORX32 imm & 8\n");
+    codegen_alloc_bytes(block, 6);
+    codegen_addbyte4(block, 0xc4, 0xe3, 0x7b, 0xf0); /*RORX dst_reg, src_reg, shift*/
+    codegen_addbyte2(block, 0xc0 | src_reg | (dst_reg << 3), shift);
+}
 
 void
 host_x86_SAR8_CL(codeblock_t *block, int dst_reg)
@@ -1449,6 +1486,15 @@ host_x86_SAR32_CL(codeblock_t *block, int dst_reg)
     codegen_alloc_bytes(block, 2);
     codegen_addbyte2(block, 0xd3, 0xc0 | RM_OP_SAR | dst_reg); /*SAR dst_reg, CL*/
 }
+void
+host_x86_SARX32_REG(codeblock_t *block, int dst_reg, int src_reg, int shift_reg)
+{
+    if ((dst_reg | src_reg | shift_reg) & 8)
+        fatal("SARX32 & 8\n");
+    codegen_alloc_bytes(block, 5);
+    codegen_addbyte4(block, 0xc4, 0xe2, 0x02 | ((~shift_reg & 0xf) << 3), 0xf7); /*SARX dst_reg, src_reg, shift_reg*/
+    codegen_addbyte(block, 0xc0 | src_reg | (dst_reg << 3));
+}
 
 void
 host_x86_SAR8_IMM(codeblock_t *block, int dst_reg, int shift)
@@ -1504,6 +1550,15 @@ host_x86_SHL32_CL(codeblock_t *block, int dst_reg)
     codegen_alloc_bytes(block, 2);
     codegen_addbyte2(block, 0xd3, 0xc0 | RM_OP_SHL | dst_reg); /*SHL dst_reg, CL*/
 }
+void
+host_x86_SHLX32_REG(codeblock_t *block, int dst_reg, int src_reg, int shift_reg)
+{
+    if ((dst_reg | src_reg | shift_reg) & 8)
+        fatal("SHLX32 & 8\n");
+    codegen_alloc_bytes(block, 5);
+    codegen_addbyte4(block, 0xc4, 0xe2, 0x01 | ((~shift_reg & 0xf) << 3), 0xf7); /*SHLX dst_reg, src_reg, shift_reg*/
+    codegen_addbyte(block, 0xc0 | src_reg | (dst_reg << 3));
+}
 
 void
 host_x86_SHL8_IMM(codeblock_t *block, int dst_reg, int shift)
@@ -1560,6 +1615,15 @@ host_x86_SHR32_CL(codeblock_t *block, int dst_reg)
     codegen_alloc_bytes(block, 2);
     codegen_addbyte2(block, 0xd3, 0xc0 | RM_OP_SHR | dst_reg); /*SHR dst_reg, CL*/
 }
+void
+host_x86_SHRX32_REG(codeblock_t *block, int dst_reg, int src_reg, int shift_reg)
+{
+    if ((dst_reg | src_reg | shift_reg) & 8)
+        fatal("SHRX32 & 8\n");
+    codegen_alloc_bytes(block, 5);
+    codegen_addbyte4(block, 0xc4, 0xe2, 0x03 | ((~shift_reg & 0xf) << 3), 0xf7); /*SHRX dst_reg, src_reg, shift_reg*/
+    codegen_addbyte(block, 0xc0 | src_reg | (dst_reg << 3));
+}
 
 void
 host_x86_SHR8_IMM(codeblock_t *block, int dst_reg, int shift)
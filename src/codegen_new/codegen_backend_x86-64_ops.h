@@ -2,6 +2,7 @@ void host_x86_ADD8_REG_IMM(codeblock_t *block, int dst_reg, uint8_t imm_data);
 void host_x86_ADD16_REG_IMM(codeblock_t *block, int dst_reg, uint16_t imm_data);
 void host_x86_ADD32_REG_IMM(codeblock_t *block, int dst_reg, uint32_t imm_data);
 void host_x86_ADD64_REG_IMM(codeblock_t *block, int dst_reg, uint64_t imm_data);
+void host_x86_ADD64_BASE_OFFSET_IMM(codeblock_t *block, int base_reg, int offset, uint8_t imm_data);
 
 void host_x86_ADD8_REG_REG(codeblock_t *block, int dst_reg, int src_reg);
 void host_x86_ADD16_REG_REG(codeblock_t *block, int dst_reg, int src_reg);
@@ -30,10 +31,12 @@ void host_x86_JMP(codeblock_t *block, void *p);
 void host_x86_JNZ(codeblock_t *block, void *p);
 void host_x86_JZ(codeblock_t *block, void *p);
 
+uint8_t *host_x86_JMP_short(codeblock_t *block);
 uint8_t *host_x86_JNZ_short(codeblock_t *block);
 uint8_t *host_x86_JS_short(codeblock_t *block);
 uint8_t *host_x86_JZ_short(codeblock_t *block);
 
+uint32_t *host_x86_JMP_long(codeblock_t *block);
 uint32_t *host_x86_JNB_long(codeblock_t *block);
 uint32_t *host_x86_JNBE_long(codeblock_t *block);
 uint32_t *host_x86_JNL_long(codeblock_t *block);
@@ -149,6 +152,8 @@ void host_x86_ROR8_CL(codeblock_t *block, int dst_reg);
 void host_x86_ROR16_CL(codeblock_t *block, int dst_reg);
 void host_x86_ROR32_CL(codeblock_t *block, int dst_reg);
 
+void host_x86_RORX32_IMM(codeblock_t *block, int dst_reg, int src_reg, int shift);
+
 void host_x86_SAR8_CL(codeblock_t *block, int dst_reg);
 void host_x86_SAR16_CL(codeblock_t *block, int dst_reg);
 void host_x86_SAR32_CL(codeblock_t *block, int dst_reg);
@@ -157,6 +162,8 @@ void host_x86_SAR8_IMM(codeblock_t *block, int dst_reg, int shift);
 void host_x86_SAR16_IMM(codeblock_t *block, int dst_reg, int shift);
 void host_x86_SAR32_IMM(codeblock_t *block, int dst_reg, int shift);
 
+void host_x86_SARX32_REG(codeblock_t *block, int dst_reg, int src_reg, int shift_reg);
+
 void host_x86_SHL8_CL(codeblock_t *block, int dst_reg);
 void host_x86_SHL16_CL(codeblock_t *block, int dst_reg);
 void host_x86_SHL32_CL(codeblock_t *block, int dst_reg);
@@ -165,6 +172,8 @@ void host_x86_SHL8_IMM(codeblock_t *block, int dst_reg, int shift);
 void host_x86_SHL16_IMM(codeblock_t *block, int dst_reg, int shift);
 void host_x86_SHL32_IMM(codeblock_t *block, int dst_reg, int shift);
 
+void host_x86_SHLX32_REG(codeblock_t *block, int dst_reg, int src_reg, int shift_reg);
+
 void host_x86_SHR8_CL(codeblock_t *block, int dst_reg);
 void host_x86_SHR16_CL(codeblock_t *block, int dst_reg);
 void host_x86_SHR32_CL(codeblock_t *block, int dst_reg);
@@ -173,6 +182,8 @@ void host_x86_SHR8_IMM(codeblock_t *block, int dst_reg, int shift);
 void host_x86_SHR16_IMM(codeblock_t *block, int dst_reg, int shift);
 void host_x86_SHR32_IMM(codeblock_t *block, int dst_reg, int shift);
 
+void host_x86_SHRX32_REG(codeblock_t *block, int dst_reg, int src_reg, int shift_reg);
+
 void host_x86_SUB8_REG_IMM(codeblock_t *block, int dst_reg, uint8_t imm_data);
 void host_x86_SUB16_REG_IMM(codeblock_t *block, int dst_reg, uint16_t imm_data);
 void host_x86_SUB32_REG_IMM(codeblock_t *block, int dst_reg, uint32_t imm_data);
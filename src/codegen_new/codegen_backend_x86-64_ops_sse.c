@@ -676,4 +676,27 @@ host_x86_UNPCKLPS_XREG_XREG(codeblock_t *block, int dst_reg, int src_reg)
     codegen_addbyte3(block, 0x0f, 0x14, 0xc0 | src_reg | (dst_reg << 3));
 }
 
+/*AVX forms, using the two byte VEX prefix. These take a separate first source,
+  so avoid copying it into the destination. Only usable when host_x86_features
+  includes HOST_X86_FEATURE_AVX*/
+void
+host_x86_VDIVSD_XREG_XREG_XREG(codeblock_t *block, int dst_reg, int src_reg_a, int src_reg_b)
+{
+    codegen_alloc_bytes(block, 4);
+    codegen_addbyte4(block, 0xc5, 0x83 | ((~src_reg_a & 0xf) << 3), 0x5e, 0xc0 | src_reg_b | (dst_reg << 3)); /*VDIVSD dst_reg, src_reg_a, src_reg_b*/
+}
+
+void
+host_x86_VSUBPS_XREG_XREG_XREG(codeblock_t *block, int dst_reg, int src_reg_a, int src_reg_b)
+{
+    codegen_alloc_bytes(block, 4);
+    codegen_addbyte4(block, 0xc5, 0x80 | ((~src_reg_a & 0xf) << 3), 0x5c, 0xc0 | src_reg_b | (dst_reg << 3)); /*VSUBPS dst_reg, src_reg_a, src_reg_b*/
+}
+void
+host_x86_VSUBSD_XREG_XREG_XREG(codeblock_t *block, int dst_reg, int src_reg_a, int src_reg_b)
+{
+    codegen_alloc_bytes(block, 4);
+    codegen_addbyte4(block, 0xc5, 0x83 | ((~src_reg_a & 0xf) << 3), 0x5c, 0xc0 | src_reg_b | (dst_reg << 3)); /*VSUBSD dst_reg, src_reg_a, src_reg_b*/
+}
+
 #endif
@@ -112,3 +112,8 @@ void host_x86_SUBPS_XREG_XREG(codeblock_t *block, int dst_reg, int src_reg);
 void host_x86_SUBSD_XREG_XREG(codeblock_t *block, int dst_reg, int src_reg);
 
 void host_x86_UNPCKLPS_XREG_XREG(codeblock_t *block, int dst_reg, int src_reg);
+
+void host_x86_VDIVSD_XREG_XREG_XREG(codeblock_t *block, int dst_reg, int src_reg_a, int src_reg_b);
+
+void host_x86_VSUBPS_XREG_XREG_XREG(codeblock_t *block, int dst_reg, int src_reg_a, int src_reg_b);
+void host_x86_VSUBSD_XREG_XREG_XREG(codeblock_t *block, int dst_reg, int src_reg_a, int src_reg_b);
@@ -630,7 +630,10 @@ codegen_FCHS(codeblock_t *block, uop_t *uop)
     int dest_size  = IREG_GET_SIZE(uop->dest_reg_a_real);
     int src_size_a = IREG_GET_SIZE(uop->src_reg_a_real);
 
-    if (REG_IS_D(dest_size) && REG_IS_D(src_size_a)) {
+    if (REG_IS_D(dest_size) && REG_IS_D(src_size_a) && (host_x86_features & HOST_X86_FEATURE_AVX)) {
+        host_x86_PXOR_XREG_XREG(block, REG_XMM_TEMP, REG_XMM_TEMP);
+        host_x86_VSUBSD_XREG_XREG_XREG(block, dest_reg, REG_XMM_TEMP, src_reg_a);
+    } else if (REG_IS_D(dest_size) && REG_IS_D(src_size_a)) {
         host_x86_MOVQ_XREG_XREG(block, REG_XMM_TEMP, src_reg_a);
         host_x86_PXOR_XREG_XREG(block, dest_reg, dest_reg);
         host_x86_SUBSD_XREG_XREG(block, dest_reg, REG_XMM_TEMP);
@@ -745,6 +748,8 @@ codegen_FDIV(codeblock_t *block, uop_t *uop)
 
     if (REG_IS_D(dest_size) && REG_IS_D(src_size_a) && REG_IS_D(src_size_b) && dest_reg == src_reg_a) {
         host_x86_DIVSD_XREG_XREG(block, dest_reg, src_reg_b);
+    } else if (REG_IS_D(dest_size) && REG_IS_D(src_size_a) && REG_IS_D(src_size_b) && (host_x86_features & HOST_X86_FEATURE_AVX)) {
+        host_x86_VDIVSD_XREG_XREG_XREG(block, dest_reg, src_reg_a, src_reg_b);
     } else if (REG_IS_D(dest_size) && REG_IS_D(src_size_a) && REG_IS_D(src_size_b)) {
         host_x86_MOVQ_XREG_XREG(block, REG_XMM_TEMP, src_reg_a);
         host_x86_DIVSD_XREG_XREG(block, REG_XMM_TEMP, src_reg_b);
@@ -787,6 +792,8 @@ codegen_FSUB(codeblock_t *block, uop_t *uop)
 
     if (REG_IS_D(dest_size) && REG_IS_D(src_size_a) && REG_IS_D(src_size_b) && dest_reg == src_reg_a) {
         host_x86_SUBSD_XREG_XREG(block, dest_reg, src_reg_b);
+    } else if (REG_IS_D(dest_size) && REG_IS_D(src_size_a) && REG_IS_D(src_size_b) && (host_x86_features & HOST_X86_FEATURE_AVX)) {
+        host_x86_VSUBSD_XREG_XREG_XREG(block, dest_reg, src_reg_a, src_reg_b);
     } else if (REG_IS_D(dest_size) && REG_IS_D(src_size_a) && REG_IS_D(src_size_b)) {
         host_x86_MOVQ_XREG_XREG(block, REG_XMM_TEMP, src_reg_a);
         host_x86_SUBSD_XREG_XREG(block, REG_XMM_TEMP, src_reg_b);
@@ -851,6 +858,24 @@ codegen_JMP(codeblock_t *block, uop_t *uop)
 
     return 0;
 }
+static int
+codegen_JMP_CHAIN(codeblock_t *block, uop_t *uop)
+{
+    int link_nr = (int) uop->imm_data;
+
+    if (link_nr != -1) {
+        /*Patchable jump, initially to the unlinked exit immediately after it*/
+        uint32_t *patch = host_x86_JMP_long(block);
+
+        codegen_set_jump_dest(block, patch);
+        codegen_block_link_set_site(link_nr, (uint8_t *) patch, &block_write_data[block_pos]);
+        host_x86_MOV64_REG_IMM(block, REG_RCX, (uintptr_t) &codegen_chain_exit);
+        host_x86_MOV32_BASE_OFFSET_IMM(block, REG_RCX, 0, link_nr);
+    }
+    host_x86_JMP(block, codegen_exit_rout);
+
+    return 0;
+}
 
 static int
 codegen_LOAD_FUNC_ARG0(codeblock_t *block, uop_t *uop)
@@ -957,6 +982,47 @@ codegen_LOAD_SEG(codeblock_t *block, uop_t *uop)
     return 0;
 }
 
+/*Call a memory access routine, and exit the block if it aborted.
+
+  Dirty registers are kept in host registers across the access, so are not yet
+  in cpu_state. This is only valid while the access goes through the lookup
+  tables; the memory handlers called on the slow path (MMIO, page faults, SMM
+  etc) may read the emulated registers from cpu_state. So if anything is dirty
+  the lookup only routine is called first, and on a miss the registers are
+  written back before the full routine is run.
+
+  Memory handlers must never modify the emulated registers in cpu_state, as
+  the block would continue with the stale copies held in host registers.*/
+static void
+codegen_mem_call(codeblock_t *block, uop_t *uop, void *rout, void *fast_rout)
+{
+    if (codegen_reg_exit_dirty(uop->dest_reg_a)) {
+        uint32_t *branch_offset;
+
+        host_x86_CALL(block, fast_rout);
+        host_x86_TEST32_REG(block, REG_ESI, REG_ESI);
+        branch_offset = host_x86_JZ_long(block);
+
+        /*ECX holds the load address or the store data, and is corrupted when
+          writing back FPU stack registers. EDI holds the store address*/
+        host_x86_MOV32_REG_REG(block, REG_ESI, REG_ECX);
+        codegen_reg_writeback_exit(block, uop->dest_reg_a);
+        if (ir_reg_is_invalid(uop->dest_reg_a)) {
+            host_x86_MOV32_REG_REG(block, REG_ECX, REG_ESI);
+            host_x86_MOV32_REG_REG(block, REG_ESI, REG_EDI);
+        }
+        host_x86_CALL(block, rout);
+        host_x86_TEST32_REG(block, REG_ESI, REG_ESI);
+        host_x86_JNZ(block, codegen_exit_rout);
+
+        *branch_offset = (uint32_t) ((uintptr_t) &block_write_data[block_pos] - (uintptr_t) branch_offset) - 4;
+    } else {
+        host_x86_CALL(block, rout);
+        host_x86_TEST32_REG(block, REG_ESI, REG_ESI);
+        host_x86_JNZ(block, codegen_exit_rout);
+    }
+}
+
 static int
 codegen_MEM_LOAD_ABS(codeblock_t *block, uop_t *uop)
 {
@@ -966,18 +1032,16 @@ codegen_MEM_LOAD_ABS(codeblock_t *block, uop_t *uop)
 
     host_x86_LEA_REG_IMM(block, REG_ESI, seg_reg, uop->imm_data);
     if (REG_IS_B(dest_size)) {
-        host_x86_CALL(block, codegen_mem_load_byte);
+        codegen_mem_call(block, uop, codegen_mem_load_byte, codegen_mem_load_byte_fast);
     } else if (REG_IS_W(dest_size)) {
-        host_x86_CALL(block, codegen_mem_load_word);
+        codegen_mem_call(block, uop, codegen_mem_load_word, codegen_mem_load_word_fast);
     } else if (REG_IS_L(dest_size)) {
-        host_x86_CALL(block, codegen_mem_load_long);
+        codegen_mem_call(block, uop, codegen_mem_load_long, codegen_mem_load_long_fast);
     }
 #    ifdef RECOMPILER_DEBUG
     else
         fatal("MEM_LOAD_ABS - %02x\n", uop->dest_reg_a_real);
 #    endif
-    host_x86_TEST32_REG(block, REG_ESI, REG_ESI);
-    host_x86_JNZ(block, codegen_exit_rout);
     if (REG_IS_B(dest_size)) {
         host_x86_MOV8_REG_REG(block, dest_reg, REG_ECX);
     } else if (REG_IS_W(dest_size)) {
@@ -1004,20 +1068,18 @@ codegen_MEM_LOAD_REG(codeblock_t *block, uop_t *uop)
         }
     }
     if (REG_IS_B(dest_size)) {
-        host_x86_CALL(block, codegen_mem_load_byte);
+        codegen_mem_call(block, uop, codegen_mem_load_byte, codegen_mem_load_byte_fast);
     } else if (REG_IS_W(dest_size)) {
-        host_x86_CALL(block, codegen_mem_load_word);
+        codegen_mem_call(block, uop, codegen_mem_load_word, codegen_mem_load_word_fast);
     } else if (REG_IS_L(dest_size)) {
-        host_x86_CALL(block, codegen_mem_load_long);
+        codegen_mem_call(block, uop, codegen_mem_load_long, codegen_mem_load_long_fast);
     } else if (REG_IS_Q(dest_size)) {
-        host_x86_CALL(block, codegen_mem_load_quad);
+        codegen_mem_call(block, uop, codegen_mem_load_quad, codegen_mem_load_quad_fast);
     }
 #    ifdef RECOMPILER_DEBUG
     else
         fatal("MEM_LOAD_REG - %02x\n", uop->dest_reg_a_real);
 #    endif
-    host_x86_TEST32_REG(block, REG_ESI, REG_ESI);
-    host_x86_JNZ(block, codegen_exit_rout);
     if (REG_IS_B(dest_size)) {
         host_x86_MOV8_REG_REG(block, dest_reg, REG_ECX);
     } else if (REG_IS_W(dest_size)) {
@@ -1045,9 +1107,7 @@ codegen_MEM_LOAD_SINGLE(codeblock_t *block, uop_t *uop)
     host_x86_LEA_REG_REG(block, REG_ESI, seg_reg, addr_reg);
     if (uop->imm_data)
         host_x86_ADD32_REG_IMM(block, REG_ESI, uop->imm_data);
-    host_x86_CALL(block, codegen_mem_load_single);
-    host_x86_TEST32_REG(block, REG_ESI, REG_ESI);
-    host_x86_JNZ(block, codegen_exit_rout);
+    codegen_mem_call(block, uop, codegen_mem_load_single, codegen_mem_load_single_fast);
     host_x86_MOVQ_XREG_XREG(block, dest_reg, REG_XMM_TEMP);
 
     return 0;
@@ -1067,9 +1127,7 @@ codegen_MEM_LOAD_DOUBLE(codeblock_t *block, uop_t *uop)
     host_x86_LEA_REG_REG(block, REG_ESI, seg_reg, addr_reg);
     if (uop->imm_data)
         host_x86_ADD32_REG_IMM(block, REG_ESI, uop->imm_data);
-    host_x86_CALL(block, codegen_mem_load_double);
-    host_x86_TEST32_REG(block, REG_ESI, REG_ESI);
-    host_x86_JNZ(block, codegen_exit_rout);
+    codegen_mem_call(block, uop, codegen_mem_load_double, codegen_mem_load_double_fast);
     host_x86_MOVQ_XREG_XREG(block, dest_reg, REG_XMM_TEMP);
 
     return 0;
@@ -1085,20 +1143,18 @@ codegen_MEM_STORE_ABS(codeblock_t *block, uop_t *uop)
     host_x86_LEA_REG_IMM(block, REG_ESI, seg_reg, uop->imm_data);
     if (REG_IS_B(src_size)) {
         host_x86_MOV8_REG_REG(block, REG_ECX, src_reg);
-        host_x86_CALL(block, codegen_mem_store_byte);
+        codegen_mem_call(block, uop, codegen_mem_store_byte, codegen_mem_store_byte_fast);
     } else if (REG_IS_W(src_size)) {
         host_x86_MOV16_REG_REG(block, REG_ECX, src_reg);
-        host_x86_CALL(block, codegen_mem_store_word);
+        codegen_mem_call(block, uop, codegen_mem_store_word, codegen_mem_store_word_fast);
     } else if (REG_IS_L(src_size)) {
         host_x86_MOV32_REG_REG(block, REG_ECX, src_reg);
-        host_x86_CALL(block, codegen_mem_store_long);
+        codegen_mem_call(block, uop, codegen_mem_store_long, codegen_mem_store_long_fast);
     }
 #    ifdef RECOMPILER_DEBUG
     else
         fatal("MEM_STORE_ABS - %02x\n", uop->src_reg_b_real);
 #    endif
-    host_x86_TEST32_REG(block, REG_ESI, REG_ESI);
-    host_x86_JNZ(block, codegen_exit_rout);
 
     return 0;
 }
@@ -1111,9 +1167,7 @@ codegen_MEM_STORE_IMM_8(codeblock_t *block, uop_t *uop)
 
     host_x86_LEA_REG_REG(block, REG_ESI, seg_reg, addr_reg);
     host_x86_MOV8_REG_IMM(block, REG_ECX, uop->imm_data);
-    host_x86_CALL(block, codegen_mem_store_byte);
-    host_x86_TEST32_REG(block, REG_ESI, REG_ESI);
-    host_x86_JNZ(block, codegen_exit_rout);
+    codegen_mem_call(block, uop, codegen_mem_store_byte, codegen_mem_store_byte_fast);
 
     return 0;
 }
@@ -1125,9 +1179,7 @@ codegen_MEM_STORE_IMM_16(codeblock_t *block, uop_t *uop)
 
     host_x86_LEA_REG_REG(block, REG_ESI, seg_reg, addr_reg);
     host_x86_MOV16_REG_IMM(block, REG_ECX, uop->imm_data);
-    host_x86_CALL(block, codegen_mem_store_word);
-    host_x86_TEST32_REG(block, REG_ESI, REG_ESI);
-    host_x86_JNZ(block, codegen_exit_rout);
+    codegen_mem_call(block, uop, codegen_mem_store_word, codegen_mem_store_word_fast);
 
     return 0;
 }
@@ -1139,9 +1191,7 @@ codegen_MEM_STORE_IMM_32(codeblock_t *block, uop_t *uop)
 
     host_x86_LEA_REG_REG(block, REG_ESI, seg_reg, addr_reg);
     host_x86_MOV32_REG_IMM(block, REG_ECX, uop->imm_data);
-    host_x86_CALL(block, codegen_mem_store_long);
-    host_x86_TEST32_REG(block, REG_ESI, REG_ESI);
-    host_x86_JNZ(block, codegen_exit_rout);
+    codegen_mem_call(block, uop, codegen_mem_store_long, codegen_mem_store_long_fast);
 
     return 0;
 }
@@ -1159,23 +1209,21 @@ codegen_MEM_STORE_REG(codeblock_t *block, uop_t *uop)
         host_x86_ADD32_REG_IMM(block, REG_ESI, uop->imm_data);
     if (REG_IS_B(src_size)) {
         host_x86_MOV8_REG_REG(block, REG_ECX, src_reg);
-        host_x86_CALL(block, codegen_mem_store_byte);
+        codegen_mem_call(block, uop, codegen_mem_store_byte, codegen_mem_store_byte_fast);
     } else if (REG_IS_W(src_size)) {
         host_x86_MOV16_REG_REG(block, REG_ECX, src_reg);
-        host_x86_CALL(block, codegen_mem_store_word);
+        codegen_mem_call(block, uop, codegen_mem_store_word, codegen_mem_store_word_fast);
     } else if (REG_IS_L(src_size)) {
         host_x86_MOV32_REG_REG(block, REG_ECX, src_reg);
-        host_x86_CALL(block, codegen_mem_store_long);
+        codegen_mem_call(block, uop, codegen_mem_store_long, codegen_mem_store_long_fast);
     } else if (REG_IS_Q(src_size)) {
         host_x86_MOVQ_XREG_XREG(block, REG_XMM_TEMP, src_reg);
-        host_x86_CALL(block, codegen_mem_store_quad);
+        codegen_mem_call(block, uop, codegen_mem_store_quad, codegen_mem_store_quad_fast);
     }
 #    ifdef RECOMPILER_DEBUG
     else
         fatal("MEM_STORE_REG - %02x\n", uop->src_reg_b_real);
 #    endif
-    host_x86_TEST32_REG(block, REG_ESI, REG_ESI);
-    host_x86_JNZ(block, codegen_exit_rout);
 
     return 0;
 }
@@ -1196,9 +1244,7 @@ codegen_MEM_STORE_SINGLE(codeblock_t *block, uop_t *uop)
     if (uop->imm_data)
         host_x86_ADD32_REG_IMM(block, REG_ESI, uop->imm_data);
     host_x86_CVTSD2SS_XREG_XREG(block, REG_XMM_TEMP, src_reg);
-    host_x86_CALL(block, codegen_mem_store_single);
-    host_x86_TEST32_REG(block, REG_ESI, REG_ESI);
-    host_x86_JNZ(block, codegen_exit_rout);
+    codegen_mem_call(block, uop, codegen_mem_store_single, codegen_mem_store_single_fast);
 
     return 0;
 }
@@ -1218,9 +1264,7 @@ codegen_MEM_STORE_DOUBLE(codeblock_t *block, uop_t *uop)
     if (uop->imm_data)
         host_x86_ADD32_REG_IMM(block, REG_ESI, uop->imm_data);
     host_x86_MOVQ_XREG_XREG(block, REG_XMM_TEMP, src_reg);
-    host_x86_CALL(block, codegen_mem_store_double);
-    host_x86_TEST32_REG(block, REG_ESI, REG_ESI);
-    host_x86_JNZ(block, codegen_exit_rout);
+    codegen_mem_call(block, uop, codegen_mem_store_double, codegen_mem_store_double_fast);
 
     return 0;
 }
@@ -1974,6 +2018,8 @@ codegen_PFSUB(codeblock_t *block, uop_t *uop)
 
     if (REG_IS_Q(dest_size) && REG_IS_Q(src_size_b) && uop->dest_reg_a_real == uop->src_reg_a_real) {
         host_x86_SUBPS_XREG_XREG(block, dest_reg, src_reg_b);
+    } else if (REG_IS_Q(dest_size) && REG_IS_Q(src_size_a) && REG_IS_Q(src_size_b) && (host_x86_features & HOST_X86_FEATURE_AVX)) {
+        host_x86_VSUBPS_XREG_XREG_XREG(block, dest_reg, src_reg_a, src_reg_b);
     } else if (REG_IS_Q(dest_size) && REG_IS_Q(src_size_a) && REG_IS_Q(src_size_b)) {
         host_x86_MOVQ_XREG_XREG(block, REG_XMM_TEMP, src_reg_a);
         host_x86_SUBPS_XREG_XREG(block, REG_XMM_TEMP, src_reg_b);
@@ -2451,7 +2497,9 @@ codegen_ROL_IMM(codeblock_t *block, uop_t *uop)
     int dest_size = IREG_GET_SIZE(uop->dest_reg_a_real);
     int src_size  = IREG_GET_SIZE(uop->src_reg_a_real);
 
-    if (REG_IS_L(dest_size) && REG_IS_L(src_size)) {
+    if (REG_IS_L(dest_size) && REG_IS_L(src_size) && uop->dest_reg_a_real != uop->src_reg_a_real && (host_x86_features & HOST_X86_FEATURE_BMI2)) {
+        host_x86_RORX32_IMM(block, dest_reg, src_reg, (32 - uop->imm_data) & 31);
+    } else if (REG_IS_L(dest_size) && REG_IS_L(src_size)) {
         if (uop->dest_reg_a_real != uop->src_reg_a_real)
             host_x86_MOV32_REG_REG(block, dest_reg, src_reg);
         host_x86_ROL32_IMM(block, dest_reg, uop->imm_data);
@@ -2507,7 +2555,9 @@ codegen_ROR_IMM(codeblock_t *block, uop_t *uop)
     int dest_size = IREG_GET_SIZE(uop->dest_reg_a_real);
     int src_size  = IREG_GET_SIZE(uop->src_reg_a_real);
 
-    if (REG_IS_L(dest_size) && REG_IS_L(src_size)) {
+    if (REG_IS_L(dest_size) && REG_IS_L(src_size) && uop->dest_reg_a_real != uop->src_reg_a_real && (host_x86_features & HOST_X86_FEATURE_BMI2)) {
+        host_x86_RORX32_IMM(block, dest_reg, src_reg, uop->imm_data & 31);
+    } else if (REG_IS_L(dest_size) && REG_IS_L(src_size)) {
         if (uop->dest_reg_a_real != uop->src_reg_a_real)
             host_x86_MOV32_REG_REG(block, dest_reg, src_reg);
         host_x86_ROR32_IMM(block, dest_reg, uop->imm_data);
@@ -2530,11 +2580,18 @@ codegen_ROR_IMM(codeblock_t *block, uop_t *uop)
 static int
 codegen_SAR(codeblock_t *block, uop_t *uop)
 {
-    int dest_reg  = HOST_REG_GET(uop->dest_reg_a_real);
-    int src_reg   = HOST_REG_GET(uop->src_reg_a_real);
-    int shift_reg = HOST_REG_GET(uop->src_reg_b_real);
-    int dest_size = IREG_GET_SIZE(uop->dest_reg_a_real);
-    int src_size  = IREG_GET_SIZE(uop->src_reg_a_real);
+    int dest_reg   = HOST_REG_GET(uop->dest_reg_a_real);
+    int src_reg    = HOST_REG_GET(uop->src_reg_a_real);
+    int shift_reg  = HOST_REG_GET(uop->src_reg_b_real);
+    int dest_size  = IREG_GET_SIZE(uop->dest_reg_a_real);
+    int src_size   = IREG_GET_SIZE(uop->src_reg_a_real);
+    int shift_size = IREG_GET_SIZE(uop->src_reg_b_real);
+
+    if ((host_x86_features & HOST_X86_FEATURE_BMI2) && REG_IS_L(dest_size) && REG_IS_L(src_size) && REG_IS_L(shift_size)) {
+        /*No need to go through CL or copy the source first*/
+        host_x86_SARX32_REG(block, dest_reg, src_reg, shift_reg);
+        return 0;
+    }
 
     host_x86_MOV32_REG_REG(block, REG_ECX, shift_reg);
     if (REG_IS_L(dest_size) && REG_IS_L(src_size)) {
@@ -2586,11 +2643,18 @@ codegen_SAR_IMM(codeblock_t *block, uop_t *uop)
 static int
 codegen_SHL(codeblock_t *block, uop_t *uop)
 {
-    int dest_reg  = HOST_REG_GET(uop->dest_reg_a_real);
-    int src_reg   = HOST_REG_GET(uop->src_reg_a_real);
-    int shift_reg = HOST_REG_GET(uop->src_reg_b_real);
-    int dest_size = IREG_GET_SIZE(uop->dest_reg_a_real);
-    int src_size  = IREG_GET_SIZE(uop->src_reg_a_real);
+    int dest_reg   = HOST_REG_GET(uop->dest_reg_a_real);
+    int src_reg    = HOST_REG_GET(uop->src_reg_a_real);
+    int shift_reg  = HOST_REG_GET(uop->src_reg_b_real);
+    int dest_size  = IREG_GET_SIZE(uop->dest_reg_a_real);
+    int src_size   = IREG_GET_SIZE(uop->src_reg_a_real);
+    int shift_size = IREG_GET_SIZE(uop->src_reg_b_real);
+
+    if ((host_x86_features & HOST_X86_FEATURE_BMI2) && REG_IS_L(dest_size) && REG_IS_L(src_size) && REG_IS_L(shift_size)) {
+        /*No need to go through CL or copy the source first*/
+        host_x86_SHLX32_REG(block, dest_reg, src_reg, shift_reg);
+        return 0;
+    }
 
     host_x86_MOV32_REG_REG(block, REG_ECX, shift_reg);
     if (REG_IS_L(dest_size) && REG_IS_L(src_size)) {
@@ -2642,11 +2706,18 @@ codegen_SHL_IMM(codeblock_t *block, uop_t *uop)
 static int
 codegen_SHR(codeblock_t *block, uop_t *uop)
 {
-    int dest_reg  = HOST_REG_GET(uop->dest_reg_a_real);
-    int src_reg   = HOST_REG_GET(uop->src_reg_a_real);
-    int shift_reg = HOST_REG_GET(uop->src_reg_b_real);
-    int dest_size = IREG_GET_SIZE(uop->dest_reg_a_real);
-    int src_size  = IREG_GET_SIZE(uop->src_reg_a_real);
+    int dest_reg   = HOST_REG_GET(uop->dest_reg_a_real);
+    int src_reg    = HOST_REG_GET(uop->src_reg_a_real);
+    int shift_reg  = HOST_REG_GET(uop->src_reg_b_real);
+    int dest_size  = IREG_GET_SIZE(uop->dest_reg_a_real);
+    int src_size   = IREG_GET_SIZE(uop->src_reg_a_real);
+    int shift_size = IREG_GET_SIZE(uop->src_reg_b_real);
+
+    if ((host_x86_features & HOST_X86_FEATURE_BMI2) && REG_IS_L(dest_size) && REG_IS_L(src_size) && REG_IS_L(shift_size)) {
+        /*No need to go through CL or copy the source first*/
+        host_x86_SHRX32_REG(block, dest_reg, src_reg, shift_reg);
+        return 0;
+    }
 
     host_x86_MOV32_REG_REG(block, REG_ECX, shift_reg);
     if (REG_IS_L(dest_size) && REG_IS_L(src_size)) {
@@ -2874,6 +2945,9 @@ const uOpFn uop_handlers[UOP_MAX] = {
     [UOP_JMP &
         UOP_MASK]
     = codegen_JMP,
+    [UOP_JMP_CHAIN &
+        UOP_MASK]
+    = codegen_JMP_CHAIN,
 
     [UOP_LOAD_SEG &
         UOP_MASK]
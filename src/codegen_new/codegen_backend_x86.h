@@ -1,8 +1,7 @@
 #include "codegen_backend_x86_defs.h"
 
-#define BLOCK_SIZE  0x10000
-#define BLOCK_MASK  0xffff
-#define BLOCK_START 0
+#define BLOCK_SIZE_DEFAULT 0x10000
+#define BLOCK_START        0
 
 #define HASH_SIZE   0x20000
 #define HASH_MASK   0x1ffff
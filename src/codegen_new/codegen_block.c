@@ -5,7 +5,10 @@
 #include <86box/86box.h>
 #include "cpu.h"
 #include <86box/mem.h>
+#include <86box/nmi.h>
+#include <86box/pic.h>
 #include <86box/plat_unused.h>
+#include <86box/timer.h>
 
 #include "x86.h"
 #include "x86_flags.h"
@@ -20,9 +23,12 @@
 #include "codegen.h"
 #include "codegen_accumulate.h"
 #include "codegen_allocator.h"
+#include "codegen_async.h"
 #include "codegen_backend.h"
 #include "codegen_ir.h"
+#include "codegen_perf.h"
 #include "codegen_reg.h"
+#include "codegen_stats.h"
 
 uint8_t *block_write_data = NULL;
 
@@ -40,10 +46,13 @@ uint32_t op_old_pc;
 uint32_t recomp_page = -1;
 
 int        block_current = 0;
+int        codegen_block_count = BLOCK_SIZE_DEFAULT;
+static int evict_hand;
 static int block_num;
 int        block_pos;
 
 uint32_t codegen_endpc;
+uint32_t codegen_trace_dest = BLOCK_PC_INVALID;
 
 int        codegen_block_cycles;
 static int codegen_block_ins;
@@ -61,6 +70,15 @@ static uint16_t block_free_list;
 static void     delete_block(codeblock_t *block);
 static void     delete_dirty_block(codeblock_t *block);
 
+/*Pool of chaining links. Free links are kept in a list through src_next.*/
+#define LINK_NR (codegen_block_count * 2)
+static codeblock_link_t *codeblock_links;
+static codeblock_link_t *link_free_list;
+
+int     codegen_chain_exit  = -1;
+int32_t codegen_chain_limit = INT32_MAX;
+static uint32_t chain_timer_target;
+
 /*Temporary list of code blocks that have recently been evicted. This allows for
   some historical state to be kept when a block is the target of self-modifying
   code.
@@ -204,7 +222,7 @@ block_free_list_get(void)
         }
         /*Free list is empty - free up a block*/
         if (!codegen_purge_purgable_list())
-            codegen_delete_random_block(0);
+            codegen_evict_block(0);
     }
 
     block           = &codeblock[block_free_list];
@@ -214,18 +232,208 @@ block_free_list_get(void)
     return block;
 }
 
+static void
+link_free_list_init(void)
+{
+    link_free_list = NULL;
+    for (int c = LINK_NR - 1; c >= 0; c--) {
+        codeblock_link_t *link = &codeblock_links[c];
+
+        link->src       = BLOCK_INVALID;
+        link->dest      = BLOCK_INVALID;
+        link->patch     = NULL;
+        link->unlinked  = NULL;
+        link->dest_prev = link->dest_next = NULL;
+        link->src_next  = link_free_list;
+        link_free_list  = link;
+    }
+    codegen_chain_exit = -1;
+}
+
+int
+codegen_block_link_alloc(codeblock_t *block, uint32_t pc)
+{
+    codeblock_link_t *link = link_free_list;
+
+    if (!link)
+        return -1;
+    link_free_list = link->src_next;
+
+    link->src       = get_block_nr(block);
+    link->dest      = BLOCK_INVALID;
+    link->pc        = pc;
+    link->patch     = NULL;
+    link->unlinked  = NULL;
+    link->dest_prev = link->dest_next = NULL;
+    link->src_next  = block->link_out;
+    block->link_out = link;
+
+    return link - codeblock_links;
+}
+
+void
+codegen_block_link_set_site(int link_nr, uint8_t *patch, uint8_t *unlinked)
+{
+    codeblock_links[link_nr].patch    = patch;
+    codeblock_links[link_nr].unlinked = unlinked;
+}
+
+void
+codegen_block_link(int link_nr, codeblock_t *block)
+{
+#ifdef CODEGEN_BACKEND_HAS_CHAINING
+    codeblock_link_t *link;
+    codeblock_t      *src;
+
+    if (link_nr < 0 || link_nr >= LINK_NR)
+        return;
+    link = &codeblock_links[link_nr];
+    if (link->src == BLOCK_INVALID || link->dest != BLOCK_INVALID)
+        return;
+    /*The patch site and chain entry are written by the compiler thread, so are
+      only valid once the blocks have been installed*/
+    src = &codeblock[link->src];
+    if (src->pc == BLOCK_PC_INVALID || !(src->flags & CODEBLOCK_WAS_RECOMPILED) || !link->patch)
+        return;
+
+    /*Target must be the block for CS:pc, and on the same linear and physical
+      page as the start of the source block. The source block having passed
+      validation then implies that the target mapping is also unchanged*/
+    if (block->_cs != src->_cs || block->pc != src->_cs + link->pc)
+        return;
+    if (((block->pc ^ src->pc) & ~0xfff) || ((block->phys ^ src->phys) & ~0xfff))
+        return;
+    if (block->page_mask2 || !(block->flags & CODEBLOCK_WAS_RECOMPILED) || !block->chain_entry)
+        return;
+
+    codegen_backend_patch_jump(link->patch, block->chain_entry);
+
+    link->dest      = get_block_nr(block);
+    link->dest_prev = NULL;
+    link->dest_next = block->link_in;
+    if (block->link_in)
+        block->link_in->dest_prev = link;
+    block->link_in = link;
+#else
+    (void) link_nr;
+    (void) block;
+#endif
+}
+
+void
+codegen_block_unlink(codeblock_t *block)
+{
+    codeblock_link_t *link = block->link_in;
+
+    /*Send any blocks jumping into this one back to the dispatcher*/
+    while (link) {
+        codeblock_link_t *next = link->dest_next;
+
+#ifdef CODEGEN_BACKEND_HAS_CHAINING
+        codegen_backend_patch_jump(link->patch, link->unlinked);
+#endif
+        link->dest      = BLOCK_INVALID;
+        link->dest_prev = link->dest_next = NULL;
+        link            = next;
+    }
+    block->link_in = NULL;
+
+    /*Free links leaving this block. The code containing them is about to be
+      freed or replaced, so the jumps themselves are left alone*/
+    link = block->link_out;
+    while (link) {
+        codeblock_link_t *next = link->src_next;
+
+        if (link->dest != BLOCK_INVALID) {
+            if (link->dest_prev)
+                link->dest_prev->dest_next = link->dest_next;
+            else
+                codeblock[link->dest].link_in = link->dest_next;
+            if (link->dest_next)
+                link->dest_next->dest_prev = link->dest_prev;
+        }
+        link->src       = BLOCK_INVALID;
+        link->dest      = BLOCK_INVALID;
+        link->patch     = NULL;
+        link->dest_prev = link->dest_next = NULL;
+        link->src_next  = link_free_list;
+        link_free_list  = link;
+        link            = next;
+    }
+    block->link_out = NULL;
+
+    block->chain_entry = NULL;
+}
+
+void
+codegen_chain_set_limit(void)
+{
+#ifdef USE_GDBSTUB
+    codegen_chain_limit = INT32_MAX;
+#else
+    /*The dispatcher adds the cycles used to tsc once control returns to it,
+      so stop chaining once that would take tsc past the next timer*/
+    int32_t slack = (int32_t) (timer_target - (uint32_t) tsc);
+
+    chain_timer_target = timer_target;
+    if (slack <= 0)
+        codegen_chain_limit = INT32_MAX;
+    else
+        codegen_chain_limit = (slack >= cycles) ? 0 : (cycles - slack);
+#endif
+}
+
+int
+codegen_chain_check(int block_nr)
+{
+    codeblock_t *block = &codeblock[block_nr];
+
+    /*Return to the dispatcher for timers, and for anything it would
+      otherwise handle between blocks*/
+    if (cycles <= codegen_chain_limit || timer_target != chain_timer_target)
+        return 1;
+    if (cpu_state.abrt || cpu_init || new_ne || smi_line || (nmi && nmi_enable && nmi_mask) || ((cpu_state.flags & I_FLAG) && pic.int_pending) || (cpu_state.flags & T_FLAG) || cpu_override_dynarec)
+        return 1;
+
+    /*Revalidate target block*/
+    if (block->pc == BLOCK_PC_INVALID || !(block->flags & CODEBLOCK_WAS_RECOMPILED))
+        return 1;
+    if (block->_cs != cs || block->status != cpu_cur_status)
+        return 1;
+    if (block->page_mask & *block->dirty_mask)
+        return 1;
+    if ((block->flags & CODEBLOCK_STATIC_TOP) && block->TOP != (cpu_state.TOP & 7))
+        return 1;
+
+    block->flags |= CODEBLOCK_REFERENCED;
+    return 0;
+}
+
 void
 codegen_init(void)
 {
+    codegen_block_count = dynarec_blocks ? dynarec_blocks : BLOCK_SIZE_DEFAULT;
+    if (codegen_block_count < BLOCK_SIZE_MIN)
+        codegen_block_count = BLOCK_SIZE_MIN;
+    else if (codegen_block_count > BLOCK_SIZE_MAX)
+        codegen_block_count = BLOCK_SIZE_MAX;
+    evict_hand = 0;
+
     codegen_check_regs();
     codegen_allocator_init();
+    codegen_perf_init();
 
     codegen_backend_init();
+    if (codegen_perf_mode)
+        codegen_allocator_perf_load(codeblock[0].head_mem_block, &codeblock[0]);
+    codeblock_links = malloc(LINK_NR * sizeof(codeblock_link_t));
+    link_free_list_init();
     block_free_list = 0;
-    for (uint32_t c = 0; c < BLOCK_SIZE; c++)
+    for (int c = 0; c < codegen_block_count; c++)
         block_free_list_add(&codeblock[c]);
     block_dirty_list_head = block_dirty_list_tail = 0;
     dirty_list_size                               = 0;
+    codegen_async_init();
 #ifdef DEBUG_EXTRA
     memset(instr_counts, 0, sizeof(instr_counts));
 #endif
@@ -236,7 +444,7 @@ codegen_reset(void)
 {
     int c;
 
-    for (c = 1; c < BLOCK_SIZE; c++) {
+    for (c = 1; c < codegen_block_count; c++) {
         codeblock_t *block = &codeblock[c];
 
         if (block->pc != BLOCK_PC_INVALID) {
@@ -246,12 +454,14 @@ codegen_reset(void)
         }
     }
 
-    memset(codeblock, 0, BLOCK_SIZE * sizeof(codeblock_t));
+    memset(codeblock, 0, codegen_block_count * sizeof(codeblock_t));
     memset(codeblock_hash, 0, HASH_SIZE * sizeof(uint16_t));
     mem_reset_page_blocks();
+    link_free_list_init();
+    codegen_chain_limit = INT32_MAX;
 
     block_free_list = 0;
-    for (c = 0; c < BLOCK_SIZE; c++) {
+    for (c = 0; c < codegen_block_count; c++) {
         codeblock[c].pc = BLOCK_PC_INVALID;
         block_free_list_add(&codeblock[c]);
     }
@@ -377,6 +587,9 @@ invalidate_block(codeblock_t *block)
     if (block->pc == BLOCK_PC_INVALID)
         fatal("Invalidating deleted block\n");
 #endif
+    if (block->flags & CODEBLOCK_COMPILE_PENDING)
+        codegen_async_cancel(block);
+    codegen_block_unlink(block);
     remove_from_block_list(block, old_pc);
     block_dirty_list_add(block);
     if (block->head_mem_block)
@@ -398,6 +611,9 @@ delete_block(codeblock_t *block)
 #endif
     block->pc = BLOCK_PC_INVALID;
 
+    if (block->flags & CODEBLOCK_COMPILE_PENDING)
+        codegen_async_cancel(block);
+    codegen_block_unlink(block);
     codeblock_tree_delete(block);
     if (block->flags & CODEBLOCK_IN_DIRTY_LIST)
         block_dirty_list_remove(block);
@@ -433,20 +649,29 @@ codegen_delete_block(codeblock_t *block)
 }
 
 void
-codegen_delete_random_block(int required_mem_block)
+codegen_evict_block(int required_mem_block)
 {
-    int block_nr = rand() & BLOCK_MASK;
-
+    /*Referenced blocks have their flag cleared and are passed over, so this
+      terminates within two sweeps. Blocks waiting for the background compiler
+      are left alone*/
     while (1) {
-        if (block_nr && block_nr != block_current) {
-            codeblock_t *block = &codeblock[block_nr];
-
-            if (block->pc != BLOCK_PC_INVALID && (!required_mem_block || block->head_mem_block)) {
-                delete_block(block);
-                return;
+        if (++evict_hand >= codegen_block_count)
+            evict_hand = 1;
+
+        if (evict_hand != block_current) {
+            codeblock_t *block = &codeblock[evict_hand];
+
+            if (block->pc != BLOCK_PC_INVALID && (!required_mem_block || block->head_mem_block) && !(block->flags & CODEBLOCK_COMPILE_PENDING)) {
+                if (block->flags & CODEBLOCK_REFERENCED)
+                    block->flags &= ~CODEBLOCK_REFERENCED;
+                else {
+                    if (codegen_stats_enabled)
+                        codegen_stats.blocks_evicted++;
+                    delete_block(block);
+                    return;
+                }
             }
         }
-        block_nr = (block_nr + 1) & BLOCK_MASK;
     }
 }
 
@@ -461,6 +686,8 @@ codegen_check_flush(page_t *page, UNUSED(uint64_t mask), UNUSED(uint32_t phys_ad
         uint16_t     next_block = block->next;
 
         if (*block->dirty_mask & block->page_mask) {
+            if (codegen_stats_enabled)
+                codegen_stats.blocks_flushed++;
             invalidate_block(block);
         }
 #ifndef RELEASE_BUILD
@@ -477,6 +704,8 @@ codegen_check_flush(page_t *page, UNUSED(uint64_t mask), UNUSED(uint32_t phys_ad
         uint16_t     next_block = block->next_2;
 
         if (*block->dirty_mask2 & block->page_mask2) {
+            if (codegen_stats_enabled)
+                codegen_stats.blocks_flushed++;
             invalidate_block(block);
         }
 #ifndef RELEASE_BUILD
@@ -559,6 +788,11 @@ codegen_block_start_recompile(codeblock_t *block)
         fatal("Recompile to used block!\n");
 #endif
 
+    /*Any previous code for this block is being replaced*/
+    codegen_block_unlink(block);
+    if (block->head_mem_block)
+        codegen_allocator_free(block->head_mem_block);
+
     block->head_mem_block = codegen_allocator_allocate(NULL, block_current);
     block->data           = codeblock_allocator_get_ptr(block->head_mem_block);
 
@@ -567,7 +801,8 @@ codegen_block_start_recompile(codeblock_t *block)
     block->page_mask = block->page_mask2 = 0;
     block->ins                           = 0;
 
-    cpu_block_end = 0;
+    cpu_block_end      = 0;
+    codegen_trace_dest = BLOCK_PC_INVALID;
 
     last_op32   = -1;
     last_ea_seg = NULL;
@@ -590,7 +825,7 @@ codegen_block_start_recompile(codeblock_t *block)
     cpu_state.seg_ds.checked = cpu_state.seg_es.checked = cpu_state.seg_fs.checked = cpu_state.seg_gs.checked = (cr0 & 1) ? 0 : 1;
 
     block->TOP = cpu_state.TOP & 7;
-    block->flags |= CODEBLOCK_WAS_RECOMPILED;
+    block->flags |= CODEBLOCK_WAS_RECOMPILED | CODEBLOCK_REFERENCED;
 
     codegen_flat_ds = !(cpu_cur_status & CPU_STATUS_NOTFLATDS);
     codegen_flat_ss = !(cpu_cur_status & CPU_STATUS_NOTFLATSS);
@@ -776,13 +1011,28 @@ codegen_block_end_recompile(codeblock_t *block)
         block->flags &= ~CODEBLOCK_STATIC_TOP;
 
     codegen_accumulate_flush(ir_data);
+    codegen_generate_exit(ir_data);
+    codegen_ir_finalise(ir_data);
+
+    if (codegen_async_enabled) {
+        codegen_async_queue(ir_data, block);
+        return;
+    }
+
     codegen_ir_compile(ir_data, block);
+
+    if (codegen_stats_enabled)
+        codegen_stats_block_compiled(block);
+    if (codegen_perf_mode)
+        codegen_allocator_perf_load(block->head_mem_block, block);
 }
 
 void
 codegen_flush(void)
 {
-    return;
+    /*Address translation may have changed, so stop following chained blocks
+      until the dispatcher has revalidated the current one*/
+    codegen_chain_limit = INT32_MAX;
 }
 
 void
@@ -10,8 +10,9 @@
 #include "codegen_ir.h"
 #include "codegen_reg.h"
 
-extern int       has_ea;
-static ir_data_t ir_block;
+extern int        has_ea;
+static ir_data_t  ir_default;
+static ir_data_t *ir_block = &ir_default;
 
 static int codegen_unroll_start;
 static int codegen_unroll_count;
@@ -20,11 +21,17 @@ static int codegen_unroll_first_instruction;
 ir_data_t *
 codegen_ir_init(void)
 {
-    ir_block.wr_pos = 0;
+    ir_block->wr_pos = 0;
 
     codegen_unroll_count = 0;
 
-    return &ir_block;
+    return ir_block;
+}
+
+void
+codegen_ir_set_buffer(ir_data_t *ir)
+{
+    ir_block = ir;
 }
 
 void
@@ -60,9 +67,8 @@ duplicate_uop(ir_data_t *ir, uop_t *uop, int offset)
 }
 
 void
-codegen_ir_compile(ir_data_t *ir, codeblock_t *block)
+codegen_ir_finalise(ir_data_t *ir)
 {
-    int jump_target_at_end = -1;
     int c;
 
     if (codegen_unroll_count) {
@@ -79,10 +85,20 @@ codegen_ir_compile(ir_data_t *ir, codeblock_t *block)
                 duplicate_uop(ir, &ir->uops[c], offset);
             }
         }
+        codegen_unroll_count = 0;
     }
+}
+
+void
+codegen_ir_compile(ir_data_t *ir, codeblock_t *block)
+{
+    int jump_target_at_end = -1;
+    int c;
 
     codegen_reg_mark_as_required();
+    codegen_ir_optimise(ir, block);
     codegen_reg_process_dead_list(ir);
+    codegen_reg_reset_host_regs();
     block_write_data = codeblock_allocator_get_ptr(block->head_mem_block);
     block_pos        = 0;
     codegen_backend_prologue(block);
@@ -136,7 +152,18 @@ codegen_ir_compile(ir_data_t *ir, codeblock_t *block)
                 }
             }
 
-            if (uop->type & UOP_TYPE_ORDER_BARRIER)
+#ifdef CODEGEN_BACKEND_HAS_EXIT_WRITEBACK
+            if (uop->type & UOP_TYPE_EXIT_WRITEBACK) {
+                /*Only volatile host registers are lost across the call. The
+                  remaining dirty registers are written back by the uOP
+                  handler if the access misses the lookup tables or the
+                  block exits*/
+                codegen_reg_flush_volatile(ir, block);
+                if (!ir_reg_is_invalid(uop->dest_reg_a))
+                    codegen_reg_flush_reg(block, uop->dest_reg_a);
+            } else
+#endif
+                if (uop->type & UOP_TYPE_ORDER_BARRIER)
                 codegen_reg_flush(ir, block);
 
             if (uop->type & UOP_TYPE_PARAMS_REGS) {
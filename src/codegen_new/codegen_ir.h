@@ -1,6 +1,13 @@
 #include "codegen_ir_defs.h"
 
 ir_data_t *codegen_ir_init(void);
+/*Translate subsequent blocks into ir, leaving the current buffer to the
+  background compiler*/
+void codegen_ir_set_buffer(ir_data_t *ir);
 
 void codegen_ir_set_unroll(int count, int start, int first_instruction);
+/*Complete the IR for a block. This depends on CPU thread state, so must be
+  called before the IR is handed to codegen_ir_compile()*/
+void codegen_ir_finalise(ir_data_t *ir);
 void codegen_ir_compile(ir_data_t *ir, codeblock_t *block);
+void codegen_ir_optimise(ir_data_t *ir, codeblock_t *block);
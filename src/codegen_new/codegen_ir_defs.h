@@ -31,6 +31,13 @@
 /*uOP is the destination of a jump, and must set the destination offset of the jump
   at compile time.*/
 #define UOP_TYPE_JUMP_DEST      (1 << 25)
+/*uOP is an ORDER_BARRIER that only exits the block on a fault, and does not
+  observe emulated registers otherwise (eg memory load/store functions). On
+  backends that support it, dirty registers stay in host registers across the
+  uOP, and are only written back if the access leaves the lookup table fast
+  path or the block exits. This relies on memory handlers never modifying the
+  emulated registers in cpu_state.*/
+#define UOP_TYPE_EXIT_WRITEBACK (1 << 24)
 
 #define UOP_LOAD_FUNC_ARG_0     (UOP_TYPE_PARAMS_REGS | 0x00)
 #define UOP_LOAD_FUNC_ARG_1     (UOP_TYPE_PARAMS_REGS | 0x01)
@@ -55,6 +62,10 @@
 #define UOP_JMP_DEST       (UOP_TYPE_PARAMS_IMM | UOP_TYPE_PARAMS_POINTER | 0x17 | UOP_TYPE_ORDER_BARRIER | UOP_TYPE_JUMP)
 #define UOP_NOP_BARRIER    (UOP_TYPE_BARRIER | 0x18)
 #define UOP_STORE_P_IMM_16 (UOP_TYPE_PARAMS_IMM | 0x19)
+/*UOP_JMP_CHAIN - exit block via a jump that can be patched to chain directly to the next block. imm_data is the link number from
+  codegen_block_link_alloc(), or -1 if none was available. Links are allocated during translation, as the backend may run on the
+  background compiler thread*/
+#define UOP_JMP_CHAIN (UOP_TYPE_PARAMS_IMM | 0x1a | UOP_TYPE_ORDER_BARRIER)
 
 #ifdef DEBUG_EXTRA
 /*UOP_LOG_INSTR - log non-recompiled instruction in imm_data*/
@@ -109,29 +120,29 @@
 /*UOP_ANDN - dest_reg = ~src_reg_a & src_reg_b*/
 #define UOP_ANDN (UOP_TYPE_PARAMS_REGS | UOP_TYPE_PARAMS_IMM | 0x3b)
 /*UOP_MEM_LOAD_ABS - dest_reg = src_reg_a:[immediate]*/
-#define UOP_MEM_LOAD_ABS (UOP_TYPE_PARAMS_REGS | UOP_TYPE_PARAMS_IMM | 0x40 | UOP_TYPE_ORDER_BARRIER)
+#define UOP_MEM_LOAD_ABS (UOP_TYPE_PARAMS_REGS | UOP_TYPE_PARAMS_IMM | 0x40 | UOP_TYPE_ORDER_BARRIER | UOP_TYPE_EXIT_WRITEBACK)
 /*UOP_MEM_LOAD_REG - dest_reg = src_reg_a:[src_reg_b]*/
-#define UOP_MEM_LOAD_REG (UOP_TYPE_PARAMS_REGS | UOP_TYPE_PARAMS_IMM | 0x41 | UOP_TYPE_ORDER_BARRIER)
+#define UOP_MEM_LOAD_REG (UOP_TYPE_PARAMS_REGS | UOP_TYPE_PARAMS_IMM | 0x41 | UOP_TYPE_ORDER_BARRIER | UOP_TYPE_EXIT_WRITEBACK)
 /*UOP_MEM_STORE_ABS - src_reg_a:[immediate] = src_reg_b*/
-#define UOP_MEM_STORE_ABS (UOP_TYPE_PARAMS_REGS | UOP_TYPE_PARAMS_IMM | 0x42 | UOP_TYPE_ORDER_BARRIER)
+#define UOP_MEM_STORE_ABS (UOP_TYPE_PARAMS_REGS | UOP_TYPE_PARAMS_IMM | 0x42 | UOP_TYPE_ORDER_BARRIER | UOP_TYPE_EXIT_WRITEBACK)
 /*UOP_MEM_STORE_REG - src_reg_a:[src_reg_b] = src_reg_c*/
-#define UOP_MEM_STORE_REG (UOP_TYPE_PARAMS_REGS | 0x43 | UOP_TYPE_ORDER_BARRIER)
+#define UOP_MEM_STORE_REG (UOP_TYPE_PARAMS_REGS | 0x43 | UOP_TYPE_ORDER_BARRIER | UOP_TYPE_EXIT_WRITEBACK)
 /*UOP_MEM_STORE_IMM_8 - byte src_reg_a:[src_reg_b] = imm_data*/
-#define UOP_MEM_STORE_IMM_8 (UOP_TYPE_PARAMS_REGS | UOP_TYPE_PARAMS_IMM | 0x44 | UOP_TYPE_ORDER_BARRIER)
+#define UOP_MEM_STORE_IMM_8 (UOP_TYPE_PARAMS_REGS | UOP_TYPE_PARAMS_IMM | 0x44 | UOP_TYPE_ORDER_BARRIER | UOP_TYPE_EXIT_WRITEBACK)
 /*UOP_MEM_STORE_IMM_16 - word src_reg_a:[src_reg_b] = imm_data*/
-#define UOP_MEM_STORE_IMM_16 (UOP_TYPE_PARAMS_REGS | UOP_TYPE_PARAMS_IMM | 0x45 | UOP_TYPE_ORDER_BARRIER)
+#define UOP_MEM_STORE_IMM_16 (UOP_TYPE_PARAMS_REGS | UOP_TYPE_PARAMS_IMM | 0x45 | UOP_TYPE_ORDER_BARRIER | UOP_TYPE_EXIT_WRITEBACK)
 /*UOP_MEM_STORE_IMM_32 - long src_reg_a:[src_reg_b] = imm_data*/
-#define UOP_MEM_STORE_IMM_32 (UOP_TYPE_PARAMS_REGS | UOP_TYPE_PARAMS_IMM | 0x46 | UOP_TYPE_ORDER_BARRIER)
+#define UOP_MEM_STORE_IMM_32 (UOP_TYPE_PARAMS_REGS | UOP_TYPE_PARAMS_IMM | 0x46 | UOP_TYPE_ORDER_BARRIER | UOP_TYPE_EXIT_WRITEBACK)
 /*UOP_MEM_LOAD_SINGLE - dest_reg = (float)src_reg_a:[src_reg_b]*/
-#define UOP_MEM_LOAD_SINGLE (UOP_TYPE_PARAMS_REGS | UOP_TYPE_PARAMS_IMM | 0x47 | UOP_TYPE_ORDER_BARRIER)
+#define UOP_MEM_LOAD_SINGLE (UOP_TYPE_PARAMS_REGS | UOP_TYPE_PARAMS_IMM | 0x47 | UOP_TYPE_ORDER_BARRIER | UOP_TYPE_EXIT_WRITEBACK)
 /*UOP_CMP_IMM_JZ - if (src_reg_a == imm_data) then jump to ptr*/
 #define UOP_CMP_IMM_JZ (UOP_TYPE_PARAMS_REGS | UOP_TYPE_PARAMS_IMM | UOP_TYPE_PARAMS_POINTER | 0x48 | UOP_TYPE_ORDER_BARRIER)
 /*UOP_MEM_LOAD_DOUBLE - dest_reg = (double)src_reg_a:[src_reg_b]*/
-#define UOP_MEM_LOAD_DOUBLE (UOP_TYPE_PARAMS_REGS | UOP_TYPE_PARAMS_IMM | 0x49 | UOP_TYPE_ORDER_BARRIER)
+#define UOP_MEM_LOAD_DOUBLE (UOP_TYPE_PARAMS_REGS | UOP_TYPE_PARAMS_IMM | 0x49 | UOP_TYPE_ORDER_BARRIER | UOP_TYPE_EXIT_WRITEBACK)
 /*UOP_MEM_STORE_SINGLE - src_reg_a:[src_reg_b] = src_reg_c*/
-#define UOP_MEM_STORE_SINGLE (UOP_TYPE_PARAMS_REGS | 0x4a | UOP_TYPE_ORDER_BARRIER)
+#define UOP_MEM_STORE_SINGLE (UOP_TYPE_PARAMS_REGS | 0x4a | UOP_TYPE_ORDER_BARRIER | UOP_TYPE_EXIT_WRITEBACK)
 /*UOP_MEM_STORE_DOUBLE - src_reg_a:[src_reg_b] = src_reg_c*/
-#define UOP_MEM_STORE_DOUBLE (UOP_TYPE_PARAMS_REGS | 0x4b | UOP_TYPE_ORDER_BARRIER)
+#define UOP_MEM_STORE_DOUBLE (UOP_TYPE_PARAMS_REGS | 0x4b | UOP_TYPE_ORDER_BARRIER | UOP_TYPE_EXIT_WRITEBACK)
 /*UOP_CMP_JB - if (src_reg_a < src_reg_b) then jump to ptr*/
 #define UOP_CMP_JB (UOP_TYPE_PARAMS_REGS | UOP_TYPE_PARAMS_POINTER | 0x4c | UOP_TYPE_ORDER_BARRIER)
 /*UOP_CMP_JNBE - if (src_reg_a > src_reg_b) then jump to ptr*/
@@ -713,6 +724,11 @@ uop_gen_reg_src2_pointer(uint32_t uop_type, ir_data_t *ir, int src_reg_a, int sr
 
 #define uop_JMP(ir, p)                                                   uop_gen_pointer(UOP_JMP, ir, p)
 #define uop_JMP_DEST(ir)                                                 uop_gen(UOP_JMP_DEST, ir)
+#ifdef CODEGEN_BACKEND_HAS_CHAINING
+#    define uop_JMP_CHAIN(ir, pc)                                        uop_gen_imm(UOP_JMP_CHAIN, ir, codegen_block_link_alloc(ir->block, pc))
+#else
+#    define uop_JMP_CHAIN(ir, pc)                                        uop_JMP(ir, codegen_exit_rout)
+#endif
 
 #define uop_LOAD_SEG(ir, p, src_reg)                                     uop_gen_reg_src_pointer(UOP_LOAD_SEG, ir, src_reg, p)
 
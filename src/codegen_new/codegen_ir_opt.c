@@ -0,0 +1,390 @@
+#include <stdint.h>
+#include <string.h>
+#include <86box/86box.h>
+#include "cpu.h"
+#include <86box/mem.h>
+#include <86box/plat_unused.h>
+
+#include "codegen.h"
+#include "codegen_ir.h"
+#include "codegen_reg.h"
+
+/*IR optimisation pass, run once the block has been generated and before
+  dead register elimination.
+
+  Constants are tracked per register version, seeded with the segment bases
+  known from the block status (CS base is part of the block key, DS and SS
+  are zero when flat). Uses of known values are folded into immediate forms,
+  and the source versions released so that dead register elimination can
+  remove them.
+
+  MOV_IMM writes of a value a register is already known to hold are removed,
+  with later reads renamed to the version that stored the value. This mostly
+  catches lazy flag state; flags_op is rewritten with the same FLAGS_* kind
+  by most ALU instructions, and flag writes can not otherwise be removed
+  across memory accesses as they must be correct if the access faults.
+
+  Knowledge is discarded at barriers, as called functions may modify
+  registers without creating a new version, and at jump destinations, as a
+  version written on the skipped path may not hold its value.*/
+typedef struct const_reg_t {
+    int      valid;
+    uint8_t  version; /*Latest version known to hold value*/
+    uint8_t  written; /*Version whose uOP stored value to the register*/
+    uint32_t value;
+} const_reg_t;
+
+static const_reg_t const_regs[IREG_COUNT];
+/*Reads of versions (alias_base, alias_top] are renamed to alias_base*/
+static uint8_t  alias_base[IREG_COUNT];
+static uint8_t  alias_top[IREG_COUNT];
+/*Number of barrier uOPs before each uOP*/
+static uint16_t barrier_count[UOP_NR_MAX + 1];
+static uint8_t  jump_dest[UOP_NR_MAX];
+
+static void
+const_set(int reg, int version, int written, uint32_t value)
+{
+    const_regs[reg].valid   = 1;
+    const_regs[reg].version = version;
+    const_regs[reg].written = written;
+    const_regs[reg].value   = value;
+}
+
+static void
+const_clear(void)
+{
+    for (int c = 0; c < IREG_COUNT; c++)
+        const_regs[c].valid = 0;
+}
+
+static int
+const_get(ir_reg_t ir_reg, uint32_t *value)
+{
+    const const_reg_t *k = &const_regs[IREG_GET_REG(ir_reg.reg)];
+
+    if (ir_reg_is_invalid(ir_reg) || !k->valid || k->version != ir_reg.version)
+        return 0;
+
+    switch (IREG_GET_SIZE(ir_reg.reg)) {
+        case IREG_SIZE_L:
+            *value = k->value;
+            return 1;
+        case IREG_SIZE_W:
+            *value = k->value & 0xffff;
+            return 1;
+        case IREG_SIZE_B:
+            *value = k->value & 0xff;
+            return 1;
+        case IREG_SIZE_BH:
+            *value = (k->value >> 8) & 0xff;
+            return 1;
+
+        default:
+            return 0;
+    }
+}
+
+static int
+reg_is_l(ir_reg_t ir_reg)
+{
+    return !ir_reg_is_invalid(ir_reg) && IREG_GET_SIZE(ir_reg.reg) == IREG_SIZE_L && codegen_reg_native_width(ir_reg.reg) == 32;
+}
+
+/*Whether a barrier between the writes of version and version+1 required
+  version to be written back*/
+static int
+version_is_pinned(int reg, int version)
+{
+    int start = reg_version[reg][version].parent_uop;
+    int end   = reg_version[reg][version + 1].parent_uop;
+
+    if (!codegen_reg_is_permanent(reg))
+        return 0;
+    return barrier_count[end + 1] != barrier_count[start + 1];
+}
+
+static int
+version_is_dead(ir_data_t *ir, int reg, int version)
+{
+    /*Follow the same rules as codegen_reg_write()*/
+    if (!version || reg <= IREG_EBX || (reg_version[reg][version].flags & REG_FLAGS_REQUIRED))
+        return 0;
+    if (version == reg_last_version[reg])
+        return !codegen_reg_is_permanent(reg);
+    /*Non-native size writes read the previous version*/
+    if (!reg_is_native_size(ir->uops[reg_version[reg][version + 1].parent_uop].dest_reg_a))
+        return 0;
+    return !version_is_pinned(reg, version);
+}
+
+static void
+release_src(ir_data_t *ir, ir_reg_t *src)
+{
+    int            reg  = IREG_GET_REG(src->reg);
+    reg_version_t *regv = &reg_version[reg][src->version];
+
+    regv->refcount--;
+    if (!regv->refcount && version_is_dead(ir, reg, src->version))
+        add_to_dead_list(regv, reg, src->version);
+    *src = invalid_ir_reg;
+}
+
+static void
+rename_src(ir_reg_t *src)
+{
+    int reg = IREG_GET_REG(src->reg);
+
+    if (ir_reg_is_invalid(*src) || alias_top[reg] <= alias_base[reg])
+        return;
+    if (src->version > alias_base[reg] && src->version <= alias_top[reg]) {
+        reg_version[reg][src->version].refcount--;
+        reg_version[reg][alias_base[reg]].refcount++;
+        src->version = alias_base[reg];
+    }
+}
+
+static void
+fold_to_mov_imm(ir_data_t *ir, uop_t *uop, uint32_t value)
+{
+    if (!ir_reg_is_invalid(uop->src_reg_a))
+        release_src(ir, &uop->src_reg_a);
+    if (!ir_reg_is_invalid(uop->src_reg_b))
+        release_src(ir, &uop->src_reg_b);
+    if (!ir_reg_is_invalid(uop->src_reg_c))
+        release_src(ir, &uop->src_reg_c);
+    uop->type     = UOP_MOV_IMM;
+    uop->imm_data = value;
+}
+
+static void
+fold_to_imm(ir_data_t *ir, uop_t *uop, uint32_t uop_type, uint32_t value)
+{
+    release_src(ir, &uop->src_reg_b);
+    uop->type     = uop_type;
+    uop->imm_data = value;
+}
+
+static void
+fold_uop(ir_data_t *ir, uop_t *uop)
+{
+    uint32_t uop_type = uop->type & UOP_MASK;
+    uint32_t imm_type;
+    uint32_t a;
+    uint32_t b;
+    int      known_a;
+    int      known_b;
+
+    if (uop_type == (UOP_CMP_IMM_JZ & UOP_MASK)) {
+        /*Segment checks against known bases can never be taken*/
+        if (reg_is_l(uop->src_reg_a) && const_get(uop->src_reg_a, &a) && a != uop->imm_data) {
+            release_src(ir, &uop->src_reg_a);
+            uop->type = UOP_INVALID;
+        }
+        return;
+    }
+
+    if (!reg_is_l(uop->dest_reg_a))
+        return;
+
+    known_a = const_get(uop->src_reg_a, &a);
+    known_b = const_get(uop->src_reg_b, &b);
+
+    switch (uop_type) {
+        case (UOP_MOV & UOP_MASK):
+            if (known_a && reg_is_l(uop->src_reg_a))
+                fold_to_mov_imm(ir, uop, a);
+            return;
+        case (UOP_MOVZX & UOP_MASK):
+            if (known_a)
+                fold_to_mov_imm(ir, uop, a);
+            return;
+        case (UOP_MOVSX & UOP_MASK):
+            if (known_a) {
+                if (IREG_GET_SIZE(uop->src_reg_a.reg) == IREG_SIZE_W)
+                    fold_to_mov_imm(ir, uop, (uint32_t) (int32_t) (int16_t) a);
+                else if (IREG_GET_SIZE(uop->src_reg_a.reg) != IREG_SIZE_L)
+                    fold_to_mov_imm(ir, uop, (uint32_t) (int32_t) (int8_t) a);
+            }
+            return;
+
+        case (UOP_ADD & UOP_MASK):
+            imm_type = UOP_ADD_IMM;
+            break;
+        case (UOP_SUB & UOP_MASK):
+            imm_type = UOP_SUB_IMM;
+            break;
+        case (UOP_AND & UOP_MASK):
+            imm_type = UOP_AND_IMM;
+            break;
+        case (UOP_OR & UOP_MASK):
+            imm_type = UOP_OR_IMM;
+            break;
+        case (UOP_XOR & UOP_MASK):
+            imm_type = UOP_XOR_IMM;
+            break;
+
+        case (UOP_ADD_IMM & UOP_MASK):
+            if (known_a && reg_is_l(uop->src_reg_a))
+                fold_to_mov_imm(ir, uop, a + uop->imm_data);
+            return;
+        case (UOP_SUB_IMM & UOP_MASK):
+            if (known_a && reg_is_l(uop->src_reg_a))
+                fold_to_mov_imm(ir, uop, a - uop->imm_data);
+            return;
+        case (UOP_AND_IMM & UOP_MASK):
+            if (known_a && reg_is_l(uop->src_reg_a))
+                fold_to_mov_imm(ir, uop, a & uop->imm_data);
+            return;
+        case (UOP_OR_IMM & UOP_MASK):
+            if (known_a && reg_is_l(uop->src_reg_a))
+                fold_to_mov_imm(ir, uop, a | uop->imm_data);
+            return;
+        case (UOP_XOR_IMM & UOP_MASK):
+            if (known_a && reg_is_l(uop->src_reg_a))
+                fold_to_mov_imm(ir, uop, a ^ uop->imm_data);
+            return;
+        case (UOP_SHL_IMM & UOP_MASK):
+            if (known_a && reg_is_l(uop->src_reg_a) && uop->imm_data < 32)
+                fold_to_mov_imm(ir, uop, a << uop->imm_data);
+            return;
+        case (UOP_SHR_IMM & UOP_MASK):
+            if (known_a && reg_is_l(uop->src_reg_a) && uop->imm_data < 32)
+                fold_to_mov_imm(ir, uop, a >> uop->imm_data);
+            return;
+        case (UOP_SAR_IMM & UOP_MASK):
+            if (known_a && reg_is_l(uop->src_reg_a) && uop->imm_data < 32)
+                fold_to_mov_imm(ir, uop, (uint32_t) ((int32_t) a >> uop->imm_data));
+            return;
+
+        default:
+            return;
+    }
+
+    /*Register-register ALU operations*/
+    if (!reg_is_l(uop->src_reg_a) || !reg_is_l(uop->src_reg_b))
+        return;
+
+    if (known_a && known_b) {
+        switch (uop_type) {
+            case (UOP_ADD & UOP_MASK):
+                fold_to_mov_imm(ir, uop, a + b);
+                break;
+            case (UOP_SUB & UOP_MASK):
+                fold_to_mov_imm(ir, uop, a - b);
+                break;
+            case (UOP_AND & UOP_MASK):
+                fold_to_mov_imm(ir, uop, a & b);
+                break;
+            case (UOP_OR & UOP_MASK):
+                fold_to_mov_imm(ir, uop, a | b);
+                break;
+            case (UOP_XOR & UOP_MASK):
+                fold_to_mov_imm(ir, uop, a ^ b);
+                break;
+        }
+    } else if (known_b)
+        fold_to_imm(ir, uop, imm_type, b);
+    else if (known_a && uop_type != (UOP_SUB & UOP_MASK)) {
+        ir_reg_t src_reg_a = uop->src_reg_a;
+
+        uop->src_reg_a = uop->src_reg_b;
+        uop->src_reg_b = src_reg_a;
+        fold_to_imm(ir, uop, imm_type, a);
+    }
+}
+
+/*Record the value written by a MOV_IMM, or remove the uOP if the register is
+  known to already hold it*/
+static void
+track_mov_imm(uop_t *uop)
+{
+    int          reg     = IREG_GET_REG(uop->dest_reg_a.reg);
+    int          version = uop->dest_reg_a.version;
+    int          width   = codegen_reg_native_width(reg);
+    const_reg_t *k       = &const_regs[reg];
+    uint32_t     value   = uop->imm_data;
+
+    if (!width || !reg_is_native_size(uop->dest_reg_a))
+        return;
+    if (width < 32)
+        value &= (1u << width) - 1;
+
+    if (k->valid && k->version == version - 1 && k->value == value && reg > IREG_EBX && codegen_reg_is_permanent(reg)) {
+        int written = k->written;
+
+        /*The stored value must survive dead register elimination, and there
+          must be room for the renamed reads*/
+        if ((!written || version_is_pinned(reg, written)) && (reg_version[reg][written].refcount + reg_version[reg][version].refcount) <= REG_REFCOUNT_MAX) {
+            uop->type = UOP_INVALID;
+            if (written)
+                reg_version[reg][written].flags |= REG_FLAGS_REQUIRED;
+            alias_base[reg] = written;
+            alias_top[reg]  = version;
+            k->version      = version;
+            return;
+        }
+    }
+
+    const_set(reg, version, version, value);
+}
+
+void
+codegen_ir_optimise(ir_data_t *ir, codeblock_t *block)
+{
+    int nr_barriers = 0;
+    int c;
+
+    memset(jump_dest, 0, ir->wr_pos);
+    for (c = 0; c < ir->wr_pos; c++) {
+        const uop_t *uop = &ir->uops[c];
+
+        barrier_count[c] = nr_barriers;
+        if (uop->type & (UOP_TYPE_BARRIER | UOP_TYPE_ORDER_BARRIER))
+            nr_barriers++;
+
+        if (uop->type & UOP_TYPE_JUMP) {
+            /*Only forward jumps are expected*/
+            if (uop->jump_dest_uop <= c)
+                return;
+            if (uop->jump_dest_uop < ir->wr_pos)
+                jump_dest[uop->jump_dest_uop] = 1;
+        }
+    }
+    barrier_count[ir->wr_pos] = nr_barriers;
+
+    const_clear();
+    memset(alias_base, 0, sizeof(alias_base));
+    memset(alias_top, 0, sizeof(alias_top));
+
+    /*Segment bases known from the block key*/
+    const_set(IREG_CS_base, 0, 0, block->_cs);
+    if (!(block->status & CPU_STATUS_NOTFLATDS))
+        const_set(IREG_DS_base, 0, 0, 0);
+    if (!(block->status & CPU_STATUS_NOTFLATSS))
+        const_set(IREG_SS_base, 0, 0, 0);
+
+    for (c = 0; c < ir->wr_pos; c++) {
+        uop_t *uop = &ir->uops[c];
+
+        if (jump_dest[c])
+            const_clear();
+
+        if ((uop->type & UOP_MASK) == UOP_INVALID)
+            continue;
+
+        rename_src(&uop->src_reg_a);
+        rename_src(&uop->src_reg_b);
+        rename_src(&uop->src_reg_c);
+
+        if (uop->type & UOP_TYPE_BARRIER) {
+            const_clear();
+            continue;
+        }
+
+        fold_uop(ir, uop);
+
+        if ((uop->type & UOP_MASK) == (UOP_MOV_IMM & UOP_MASK))
+            track_mov_imm(uop);
+    }
+}
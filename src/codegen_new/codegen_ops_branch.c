@@ -61,7 +61,7 @@ ropJO_common(UNUSED(codeblock_t *block), ir_data_t *ir, uint32_t dest_addr, UNUS
             break;
     }
     uop_MOV_IMM(ir, IREG_pc, dest_addr);
-    uop_JMP(ir, codegen_exit_rout);
+    uop_JMP_CHAIN(ir, dest_addr);
     uop_set_jump_dest(ir, jump_uop);
     return 0;
 }
@@ -76,7 +76,7 @@ ropJNO_common(UNUSED(codeblock_t *block), ir_data_t *ir, uint32_t dest_addr, UNU
         case FLAGS_ZN32:
             /*Overflow is always zero*/
             uop_MOV_IMM(ir, IREG_pc, dest_addr);
-            uop_JMP(ir, codegen_exit_rout);
+            uop_JMP_CHAIN(ir, dest_addr);
             return 0;
 
         case FLAGS_SUB8:
@@ -101,7 +101,7 @@ ropJNO_common(UNUSED(codeblock_t *block), ir_data_t *ir, uint32_t dest_addr, UNU
             break;
     }
     uop_MOV_IMM(ir, IREG_pc, dest_addr);
-    uop_JMP(ir, codegen_exit_rout);
+    uop_JMP_CHAIN(ir, dest_addr);
     uop_set_jump_dest(ir, jump_uop);
     return 0;
 }
@@ -110,7 +110,7 @@ static int
 ropJB_common(codeblock_t *block, ir_data_t *ir, uint32_t dest_addr, uint32_t next_pc)
 {
     int jump_uop;
-    int do_unroll = (CF_SET() && codegen_can_unroll(block, ir, next_pc, dest_addr));
+    int follow_taken = (CF_SET() && codegen_follow_branch(block, ir, next_pc, dest_addr));
 
     switch (codegen_flags_changed ? cpu_state.flags_op : FLAGS_UNKNOWN) {
         case FLAGS_ZN8:
@@ -120,21 +120,21 @@ ropJB_common(codeblock_t *block, ir_data_t *ir, uint32_t dest_addr, uint32_t nex
             return 0;
 
         case FLAGS_SUB8:
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_CMP_JB_DEST(ir, IREG_flags_op1_B, IREG_flags_op2_B);
             else
                 jump_uop = uop_CMP_JNB_DEST(ir, IREG_flags_op1_B, IREG_flags_op2_B);
             break;
 
         case FLAGS_SUB16:
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_CMP_JB_DEST(ir, IREG_flags_op1_W, IREG_flags_op2_W);
             else
                 jump_uop = uop_CMP_JNB_DEST(ir, IREG_flags_op1_W, IREG_flags_op2_W);
             break;
 
         case FLAGS_SUB32:
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_CMP_JB_DEST(ir, IREG_flags_op1, IREG_flags_op2);
             else
                 jump_uop = uop_CMP_JNB_DEST(ir, IREG_flags_op1, IREG_flags_op2);
@@ -143,48 +143,50 @@ ropJB_common(codeblock_t *block, ir_data_t *ir, uint32_t dest_addr, uint32_t nex
         case FLAGS_UNKNOWN:
         default:
             uop_CALL_FUNC_RESULT(ir, IREG_temp0, CF_SET);
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_CMP_IMM_JNZ_DEST(ir, IREG_temp0, 0);
             else
                 jump_uop = uop_CMP_IMM_JZ_DEST(ir, IREG_temp0, 0);
             break;
     }
-    uop_MOV_IMM(ir, IREG_pc, do_unroll ? next_pc : dest_addr);
-    uop_JMP(ir, codegen_exit_rout);
+    codegen_trace_side_exit(block, ir, next_pc, dest_addr, follow_taken);
     uop_set_jump_dest(ir, jump_uop);
-    return do_unroll ? 1 : 0;
+    return follow_taken ? 1 : 0;
 }
 static int
 ropJNB_common(codeblock_t *block, ir_data_t *ir, uint32_t dest_addr, uint32_t next_pc)
 {
     int jump_uop;
-    int do_unroll = (!CF_SET() && codegen_can_unroll(block, ir, next_pc, dest_addr));
+    int follow_taken = (!CF_SET() && codegen_follow_branch(block, ir, next_pc, dest_addr));
 
     switch (codegen_flags_changed ? cpu_state.flags_op : FLAGS_UNKNOWN) {
         case FLAGS_ZN8:
         case FLAGS_ZN16:
         case FLAGS_ZN32:
-            /*Carry is always zero*/
+            /*Carry is always zero. When followed as a trace this is no
+              different to an unconditional jump*/
+            if (follow_taken && (codegen_trace_dest != BLOCK_PC_INVALID))
+                return 1;
             uop_MOV_IMM(ir, IREG_pc, dest_addr);
-            uop_JMP(ir, codegen_exit_rout);
+            uop_JMP_CHAIN(ir, dest_addr);
             return 0;
 
         case FLAGS_SUB8:
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_CMP_JNB_DEST(ir, IREG_flags_op1_B, IREG_flags_op2_B);
             else
                 jump_uop = uop_CMP_JB_DEST(ir, IREG_flags_op1_B, IREG_flags_op2_B);
             break;
 
         case FLAGS_SUB16:
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_CMP_JNB_DEST(ir, IREG_flags_op1_W, IREG_flags_op2_W);
             else
                 jump_uop = uop_CMP_JB_DEST(ir, IREG_flags_op1_W, IREG_flags_op2_W);
             break;
 
         case FLAGS_SUB32:
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_CMP_JNB_DEST(ir, IREG_flags_op1, IREG_flags_op2);
             else
                 jump_uop = uop_CMP_JB_DEST(ir, IREG_flags_op1, IREG_flags_op2);
@@ -193,16 +195,15 @@ ropJNB_common(codeblock_t *block, ir_data_t *ir, uint32_t dest_addr, uint32_t ne
         case FLAGS_UNKNOWN:
         default:
             uop_CALL_FUNC_RESULT(ir, IREG_temp0, CF_SET);
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_CMP_IMM_JZ_DEST(ir, IREG_temp0, 0);
             else
                 jump_uop = uop_CMP_IMM_JNZ_DEST(ir, IREG_temp0, 0);
             break;
     }
-    uop_MOV_IMM(ir, IREG_pc, do_unroll ? next_pc : dest_addr);
-    uop_JMP(ir, codegen_exit_rout);
+    codegen_trace_side_exit(block, ir, next_pc, dest_addr, follow_taken);
     uop_set_jump_dest(ir, jump_uop);
-    return do_unroll ? 1 : 0;
+    return follow_taken ? 1 : 0;
 }
 
 static int
@@ -210,15 +211,14 @@ ropJE_common(codeblock_t *block, ir_data_t *ir, uint32_t dest_addr, uint32_t nex
 {
     int jump_uop;
 
-    if (ZF_SET() && codegen_can_unroll(block, ir, next_pc, dest_addr)) {
+    if (ZF_SET() && codegen_follow_branch(block, ir, next_pc, dest_addr)) {
         if (!codegen_flags_changed || !flags_res_valid()) {
             uop_CALL_FUNC_RESULT(ir, IREG_temp0, ZF_SET);
             jump_uop = uop_CMP_IMM_JNZ_DEST(ir, IREG_temp0, 0);
         } else {
             jump_uop = uop_CMP_IMM_JZ_DEST(ir, IREG_flags_res, 0);
         }
-        uop_MOV_IMM(ir, IREG_pc, next_pc);
-        uop_JMP(ir, codegen_exit_rout);
+        codegen_trace_side_exit(block, ir, next_pc, dest_addr, 1);
         uop_set_jump_dest(ir, jump_uop);
         return 1;
     } else {
@@ -228,8 +228,7 @@ ropJE_common(codeblock_t *block, ir_data_t *ir, uint32_t dest_addr, uint32_t nex
         } else {
             jump_uop = uop_CMP_IMM_JNZ_DEST(ir, IREG_flags_res, 0);
         }
-        uop_MOV_IMM(ir, IREG_pc, dest_addr);
-        uop_JMP(ir, codegen_exit_rout);
+        codegen_trace_side_exit(block, ir, next_pc, dest_addr, 0);
         uop_set_jump_dest(ir, jump_uop);
     }
     return 0;
@@ -239,15 +238,14 @@ ropJNE_common(codeblock_t *block, ir_data_t *ir, uint32_t dest_addr, uint32_t ne
 {
     int jump_uop;
 
-    if (!ZF_SET() && codegen_can_unroll(block, ir, next_pc, dest_addr)) {
+    if (!ZF_SET() && codegen_follow_branch(block, ir, next_pc, dest_addr)) {
         if (!codegen_flags_changed || !flags_res_valid()) {
             uop_CALL_FUNC_RESULT(ir, IREG_temp0, ZF_SET);
             jump_uop = uop_CMP_IMM_JZ_DEST(ir, IREG_temp0, 0);
         } else {
             jump_uop = uop_CMP_IMM_JNZ_DEST(ir, IREG_flags_res, 0);
         }
-        uop_MOV_IMM(ir, IREG_pc, next_pc);
-        uop_JMP(ir, codegen_exit_rout);
+        codegen_trace_side_exit(block, ir, next_pc, dest_addr, 1);
         uop_set_jump_dest(ir, jump_uop);
         return 1;
     } else {
@@ -257,8 +255,7 @@ ropJNE_common(codeblock_t *block, ir_data_t *ir, uint32_t dest_addr, uint32_t ne
         } else {
             jump_uop = uop_CMP_IMM_JZ_DEST(ir, IREG_flags_res, 0);
         }
-        uop_MOV_IMM(ir, IREG_pc, dest_addr);
-        uop_JMP(ir, codegen_exit_rout);
+        codegen_trace_side_exit(block, ir, next_pc, dest_addr, 0);
         uop_set_jump_dest(ir, jump_uop);
     }
     return 0;
@@ -268,34 +265,34 @@ static int
 ropJBE_common(codeblock_t *block, ir_data_t *ir, uint32_t dest_addr, uint32_t next_pc)
 {
     int jump_uop;
-    int jump_uop2 = -1;
-    int do_unroll = ((CF_SET() || ZF_SET()) && codegen_can_unroll(block, ir, next_pc, dest_addr));
+    int jump_uop2    = -1;
+    int follow_taken = ((CF_SET() || ZF_SET()) && codegen_follow_branch(block, ir, next_pc, dest_addr));
 
     switch (codegen_flags_changed ? cpu_state.flags_op : FLAGS_UNKNOWN) {
         case FLAGS_ZN8:
         case FLAGS_ZN16:
         case FLAGS_ZN32:
             /*Carry is always zero, so test zero only*/
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_CMP_IMM_JZ_DEST(ir, IREG_flags_res, 0);
             else
                 jump_uop = uop_CMP_IMM_JNZ_DEST(ir, IREG_flags_res, 0);
             break;
 
         case FLAGS_SUB8:
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_CMP_JBE_DEST(ir, IREG_flags_op1_B, IREG_flags_op2_B);
             else
                 jump_uop = uop_CMP_JNBE_DEST(ir, IREG_flags_op1_B, IREG_flags_op2_B);
             break;
         case FLAGS_SUB16:
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_CMP_JBE_DEST(ir, IREG_flags_op1_W, IREG_flags_op2_W);
             else
                 jump_uop = uop_CMP_JNBE_DEST(ir, IREG_flags_op1_W, IREG_flags_op2_W);
             break;
         case FLAGS_SUB32:
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_CMP_JBE_DEST(ir, IREG_flags_op1, IREG_flags_op2);
             else
                 jump_uop = uop_CMP_JNBE_DEST(ir, IREG_flags_op1, IREG_flags_op2);
@@ -303,7 +300,7 @@ ropJBE_common(codeblock_t *block, ir_data_t *ir, uint32_t dest_addr, uint32_t ne
 
         case FLAGS_UNKNOWN:
         default:
-            if (do_unroll) {
+            if (follow_taken) {
                 uop_CALL_FUNC_RESULT(ir, IREG_temp0, CF_SET);
                 jump_uop2 = uop_CMP_IMM_JNZ_DEST(ir, IREG_temp0, 0);
                 uop_CALL_FUNC_RESULT(ir, IREG_temp0, ZF_SET);
@@ -316,9 +313,8 @@ ropJBE_common(codeblock_t *block, ir_data_t *ir, uint32_t dest_addr, uint32_t ne
             }
             break;
     }
-    if (do_unroll) {
-        uop_MOV_IMM(ir, IREG_pc, next_pc);
-        uop_JMP(ir, codegen_exit_rout);
+    if (follow_taken) {
+        codegen_trace_side_exit(block, ir, next_pc, dest_addr, 1);
         uop_set_jump_dest(ir, jump_uop);
         if (jump_uop2 != -1)
             uop_set_jump_dest(ir, jump_uop2);
@@ -326,8 +322,7 @@ ropJBE_common(codeblock_t *block, ir_data_t *ir, uint32_t dest_addr, uint32_t ne
     } else {
         if (jump_uop2 != -1)
             uop_set_jump_dest(ir, jump_uop2);
-        uop_MOV_IMM(ir, IREG_pc, dest_addr);
-        uop_JMP(ir, codegen_exit_rout);
+        codegen_trace_side_exit(block, ir, next_pc, dest_addr, 0);
         uop_set_jump_dest(ir, jump_uop);
         return 0;
     }
@@ -336,34 +331,34 @@ static int
 ropJNBE_common(codeblock_t *block, ir_data_t *ir, uint32_t dest_addr, uint32_t next_pc)
 {
     int jump_uop;
-    int jump_uop2 = -1;
-    int do_unroll = ((!CF_SET() && !ZF_SET()) && codegen_can_unroll(block, ir, next_pc, dest_addr));
+    int jump_uop2    = -1;
+    int follow_taken = ((!CF_SET() && !ZF_SET()) && codegen_follow_branch(block, ir, next_pc, dest_addr));
 
     switch (codegen_flags_changed ? cpu_state.flags_op : FLAGS_UNKNOWN) {
         case FLAGS_ZN8:
         case FLAGS_ZN16:
         case FLAGS_ZN32:
             /*Carry is always zero, so test zero only*/
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_CMP_IMM_JNZ_DEST(ir, IREG_flags_res, 0);
             else
                 jump_uop = uop_CMP_IMM_JZ_DEST(ir, IREG_flags_res, 0);
             break;
 
         case FLAGS_SUB8:
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_CMP_JNBE_DEST(ir, IREG_flags_op1_B, IREG_flags_op2_B);
             else
                 jump_uop = uop_CMP_JBE_DEST(ir, IREG_flags_op1_B, IREG_flags_op2_B);
             break;
         case FLAGS_SUB16:
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_CMP_JNBE_DEST(ir, IREG_flags_op1_W, IREG_flags_op2_W);
             else
                 jump_uop = uop_CMP_JBE_DEST(ir, IREG_flags_op1_W, IREG_flags_op2_W);
             break;
         case FLAGS_SUB32:
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_CMP_JNBE_DEST(ir, IREG_flags_op1, IREG_flags_op2);
             else
                 jump_uop = uop_CMP_JBE_DEST(ir, IREG_flags_op1, IREG_flags_op2);
@@ -371,7 +366,7 @@ ropJNBE_common(codeblock_t *block, ir_data_t *ir, uint32_t dest_addr, uint32_t n
 
         case FLAGS_UNKNOWN:
         default:
-            if (do_unroll) {
+            if (follow_taken) {
                 uop_CALL_FUNC_RESULT(ir, IREG_temp0, CF_SET);
                 jump_uop2 = uop_CMP_IMM_JNZ_DEST(ir, IREG_temp0, 0);
                 uop_CALL_FUNC_RESULT(ir, IREG_temp0, ZF_SET);
@@ -384,16 +379,14 @@ ropJNBE_common(codeblock_t *block, ir_data_t *ir, uint32_t dest_addr, uint32_t n
             }
             break;
     }
-    if (do_unroll) {
+    if (follow_taken) {
         if (jump_uop2 != -1)
             uop_set_jump_dest(ir, jump_uop2);
-        uop_MOV_IMM(ir, IREG_pc, next_pc);
-        uop_JMP(ir, codegen_exit_rout);
+        codegen_trace_side_exit(block, ir, next_pc, dest_addr, 1);
         uop_set_jump_dest(ir, jump_uop);
         return 1;
     } else {
-        uop_MOV_IMM(ir, IREG_pc, dest_addr);
-        uop_JMP(ir, codegen_exit_rout);
+        codegen_trace_side_exit(block, ir, next_pc, dest_addr, 0);
         uop_set_jump_dest(ir, jump_uop);
         if (jump_uop2 != -1)
             uop_set_jump_dest(ir, jump_uop2);
@@ -405,7 +398,7 @@ static int
 ropJS_common(codeblock_t *block, ir_data_t *ir, uint32_t dest_addr, uint32_t next_pc)
 {
     int jump_uop;
-    int do_unroll = (NF_SET() && codegen_can_unroll(block, ir, next_pc, dest_addr));
+    int follow_taken = (NF_SET() && codegen_follow_branch(block, ir, next_pc, dest_addr));
 
     switch (codegen_flags_changed ? cpu_state.flags_op : FLAGS_UNKNOWN) {
         case FLAGS_ZN8:
@@ -416,7 +409,7 @@ ropJS_common(codeblock_t *block, ir_data_t *ir, uint32_t dest_addr, uint32_t nex
         case FLAGS_SAR8:
         case FLAGS_INC8:
         case FLAGS_DEC8:
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_TEST_JS_DEST(ir, IREG_flags_res_B);
             else
                 jump_uop = uop_TEST_JNS_DEST(ir, IREG_flags_res_B);
@@ -430,7 +423,7 @@ ropJS_common(codeblock_t *block, ir_data_t *ir, uint32_t dest_addr, uint32_t nex
         case FLAGS_SAR16:
         case FLAGS_INC16:
         case FLAGS_DEC16:
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_TEST_JS_DEST(ir, IREG_flags_res_W);
             else
                 jump_uop = uop_TEST_JNS_DEST(ir, IREG_flags_res_W);
@@ -444,7 +437,7 @@ ropJS_common(codeblock_t *block, ir_data_t *ir, uint32_t dest_addr, uint32_t nex
         case FLAGS_SAR32:
         case FLAGS_INC32:
         case FLAGS_DEC32:
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_TEST_JS_DEST(ir, IREG_flags_res);
             else
                 jump_uop = uop_TEST_JNS_DEST(ir, IREG_flags_res);
@@ -453,22 +446,21 @@ ropJS_common(codeblock_t *block, ir_data_t *ir, uint32_t dest_addr, uint32_t nex
         case FLAGS_UNKNOWN:
         default:
             uop_CALL_FUNC_RESULT(ir, IREG_temp0, NF_SET);
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_CMP_IMM_JNZ_DEST(ir, IREG_temp0, 0);
             else
                 jump_uop = uop_CMP_IMM_JZ_DEST(ir, IREG_temp0, 0);
             break;
     }
-    uop_MOV_IMM(ir, IREG_pc, do_unroll ? next_pc : dest_addr);
-    uop_JMP(ir, codegen_exit_rout);
+    codegen_trace_side_exit(block, ir, next_pc, dest_addr, follow_taken);
     uop_set_jump_dest(ir, jump_uop);
-    return do_unroll ? 1 : 0;
+    return follow_taken ? 1 : 0;
 }
 static int
 ropJNS_common(codeblock_t *block, ir_data_t *ir, uint32_t dest_addr, uint32_t next_pc)
 {
     int jump_uop;
-    int do_unroll = (!NF_SET() && codegen_can_unroll(block, ir, next_pc, dest_addr));
+    int follow_taken = (!NF_SET() && codegen_follow_branch(block, ir, next_pc, dest_addr));
 
     switch (codegen_flags_changed ? cpu_state.flags_op : FLAGS_UNKNOWN) {
         case FLAGS_ZN8:
@@ -479,7 +471,7 @@ ropJNS_common(codeblock_t *block, ir_data_t *ir, uint32_t dest_addr, uint32_t ne
         case FLAGS_SAR8:
         case FLAGS_INC8:
         case FLAGS_DEC8:
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_TEST_JNS_DEST(ir, IREG_flags_res_B);
             else
                 jump_uop = uop_TEST_JS_DEST(ir, IREG_flags_res_B);
@@ -493,7 +485,7 @@ ropJNS_common(codeblock_t *block, ir_data_t *ir, uint32_t dest_addr, uint32_t ne
         case FLAGS_SAR16:
         case FLAGS_INC16:
         case FLAGS_DEC16:
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_TEST_JNS_DEST(ir, IREG_flags_res_W);
             else
                 jump_uop = uop_TEST_JS_DEST(ir, IREG_flags_res_W);
@@ -507,7 +499,7 @@ ropJNS_common(codeblock_t *block, ir_data_t *ir, uint32_t dest_addr, uint32_t ne
         case FLAGS_SAR32:
         case FLAGS_INC32:
         case FLAGS_DEC32:
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_TEST_JNS_DEST(ir, IREG_flags_res);
             else
                 jump_uop = uop_TEST_JS_DEST(ir, IREG_flags_res);
@@ -516,16 +508,15 @@ ropJNS_common(codeblock_t *block, ir_data_t *ir, uint32_t dest_addr, uint32_t ne
         case FLAGS_UNKNOWN:
         default:
             uop_CALL_FUNC_RESULT(ir, IREG_temp0, NF_SET);
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_CMP_IMM_JZ_DEST(ir, IREG_temp0, 0);
             else
                 jump_uop = uop_CMP_IMM_JNZ_DEST(ir, IREG_temp0, 0);
             break;
     }
-    uop_MOV_IMM(ir, IREG_pc, do_unroll ? next_pc : dest_addr);
-    uop_JMP(ir, codegen_exit_rout);
+    codegen_trace_side_exit(block, ir, next_pc, dest_addr, follow_taken);
     uop_set_jump_dest(ir, jump_uop);
-    return do_unroll ? 1 : 0;
+    return follow_taken ? 1 : 0;
 }
 
 static int
@@ -536,7 +527,7 @@ ropJP_common(UNUSED(codeblock_t *block), ir_data_t *ir, uint32_t dest_addr, UNUS
     uop_CALL_FUNC_RESULT(ir, IREG_temp0, PF_SET);
     jump_uop = uop_CMP_IMM_JZ_DEST(ir, IREG_temp0, 0);
     uop_MOV_IMM(ir, IREG_pc, dest_addr);
-    uop_JMP(ir, codegen_exit_rout);
+    uop_JMP_CHAIN(ir, dest_addr);
     uop_set_jump_dest(ir, jump_uop);
     return 0;
 }
@@ -548,7 +539,7 @@ ropJNP_common(UNUSED(codeblock_t *block), ir_data_t *ir, uint32_t dest_addr, UNU
     uop_CALL_FUNC_RESULT(ir, IREG_temp0, PF_SET);
     jump_uop = uop_CMP_IMM_JNZ_DEST(ir, IREG_temp0, 0);
     uop_MOV_IMM(ir, IREG_pc, dest_addr);
-    uop_JMP(ir, codegen_exit_rout);
+    uop_JMP_CHAIN(ir, dest_addr);
     uop_set_jump_dest(ir, jump_uop);
     return 0;
 }
@@ -557,24 +548,24 @@ static int
 ropJL_common(codeblock_t *block, ir_data_t *ir, uint32_t dest_addr, uint32_t next_pc)
 {
     int jump_uop;
-    int do_unroll = ((NF_SET() ? 1 : 0) != (VF_SET() ? 1 : 0) && codegen_can_unroll(block, ir, next_pc, dest_addr));
+    int follow_taken = ((NF_SET() ? 1 : 0) != (VF_SET() ? 1 : 0) && codegen_follow_branch(block, ir, next_pc, dest_addr));
 
     switch (codegen_flags_changed ? cpu_state.flags_op : FLAGS_UNKNOWN) {
         case FLAGS_ZN8:
             /*V flag is always clear. Condition is true if N is set*/
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_TEST_JS_DEST(ir, IREG_flags_res_B);
             else
                 jump_uop = uop_TEST_JNS_DEST(ir, IREG_flags_res_B);
             break;
         case FLAGS_ZN16:
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_TEST_JS_DEST(ir, IREG_flags_res_W);
             else
                 jump_uop = uop_TEST_JNS_DEST(ir, IREG_flags_res_W);
             break;
         case FLAGS_ZN32:
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_TEST_JS_DEST(ir, IREG_flags_res);
             else
                 jump_uop = uop_TEST_JNS_DEST(ir, IREG_flags_res);
@@ -582,21 +573,21 @@ ropJL_common(codeblock_t *block, ir_data_t *ir, uint32_t dest_addr, uint32_t nex
 
         case FLAGS_SUB8:
         case FLAGS_DEC8:
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_CMP_JL_DEST(ir, IREG_flags_op1_B, IREG_flags_op2_B);
             else
                 jump_uop = uop_CMP_JNL_DEST(ir, IREG_flags_op1_B, IREG_flags_op2_B);
             break;
         case FLAGS_SUB16:
         case FLAGS_DEC16:
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_CMP_JL_DEST(ir, IREG_flags_op1_W, IREG_flags_op2_W);
             else
                 jump_uop = uop_CMP_JNL_DEST(ir, IREG_flags_op1_W, IREG_flags_op2_W);
             break;
         case FLAGS_SUB32:
         case FLAGS_DEC32:
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_CMP_JL_DEST(ir, IREG_flags_op1, IREG_flags_op2);
             else
                 jump_uop = uop_CMP_JNL_DEST(ir, IREG_flags_op1, IREG_flags_op2);
@@ -606,42 +597,38 @@ ropJL_common(codeblock_t *block, ir_data_t *ir, uint32_t dest_addr, uint32_t nex
         default:
             uop_CALL_FUNC_RESULT(ir, IREG_temp0, NF_SET_01);
             uop_CALL_FUNC_RESULT(ir, IREG_temp1, VF_SET_01);
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_CMP_JNZ_DEST(ir, IREG_temp0, IREG_temp1);
             else
                 jump_uop = uop_CMP_JZ_DEST(ir, IREG_temp0, IREG_temp1);
             break;
     }
-    if (do_unroll)
-        uop_MOV_IMM(ir, IREG_pc, next_pc);
-    else
-        uop_MOV_IMM(ir, IREG_pc, dest_addr);
-    uop_JMP(ir, codegen_exit_rout);
+    codegen_trace_side_exit(block, ir, next_pc, dest_addr, follow_taken);
     uop_set_jump_dest(ir, jump_uop);
-    return do_unroll ? 1 : 0;
+    return follow_taken ? 1 : 0;
 }
 static int
 ropJNL_common(codeblock_t *block, ir_data_t *ir, uint32_t dest_addr, uint32_t next_pc)
 {
     int jump_uop;
-    int do_unroll = ((NF_SET() ? 1 : 0) == (VF_SET() ? 1 : 0) && codegen_can_unroll(block, ir, next_pc, dest_addr));
+    int follow_taken = ((NF_SET() ? 1 : 0) == (VF_SET() ? 1 : 0) && codegen_follow_branch(block, ir, next_pc, dest_addr));
 
     switch (codegen_flags_changed ? cpu_state.flags_op : FLAGS_UNKNOWN) {
         case FLAGS_ZN8:
             /*V flag is always clear. Condition is true if N is set*/
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_TEST_JNS_DEST(ir, IREG_flags_res_B);
             else
                 jump_uop = uop_TEST_JS_DEST(ir, IREG_flags_res_B);
             break;
         case FLAGS_ZN16:
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_TEST_JNS_DEST(ir, IREG_flags_res_W);
             else
                 jump_uop = uop_TEST_JS_DEST(ir, IREG_flags_res_W);
             break;
         case FLAGS_ZN32:
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_TEST_JNS_DEST(ir, IREG_flags_res);
             else
                 jump_uop = uop_TEST_JS_DEST(ir, IREG_flags_res);
@@ -649,21 +636,21 @@ ropJNL_common(codeblock_t *block, ir_data_t *ir, uint32_t dest_addr, uint32_t ne
 
         case FLAGS_SUB8:
         case FLAGS_DEC8:
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_CMP_JNL_DEST(ir, IREG_flags_op1_B, IREG_flags_op2_B);
             else
                 jump_uop = uop_CMP_JL_DEST(ir, IREG_flags_op1_B, IREG_flags_op2_B);
             break;
         case FLAGS_SUB16:
         case FLAGS_DEC16:
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_CMP_JNL_DEST(ir, IREG_flags_op1_W, IREG_flags_op2_W);
             else
                 jump_uop = uop_CMP_JL_DEST(ir, IREG_flags_op1_W, IREG_flags_op2_W);
             break;
         case FLAGS_SUB32:
         case FLAGS_DEC32:
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_CMP_JNL_DEST(ir, IREG_flags_op1, IREG_flags_op2);
             else
                 jump_uop = uop_CMP_JL_DEST(ir, IREG_flags_op1, IREG_flags_op2);
@@ -673,46 +660,42 @@ ropJNL_common(codeblock_t *block, ir_data_t *ir, uint32_t dest_addr, uint32_t ne
         default:
             uop_CALL_FUNC_RESULT(ir, IREG_temp0, NF_SET_01);
             uop_CALL_FUNC_RESULT(ir, IREG_temp1, VF_SET_01);
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_CMP_JZ_DEST(ir, IREG_temp0, IREG_temp1);
             else
                 jump_uop = uop_CMP_JNZ_DEST(ir, IREG_temp0, IREG_temp1);
             break;
     }
-    if (do_unroll)
-        uop_MOV_IMM(ir, IREG_pc, next_pc);
-    else
-        uop_MOV_IMM(ir, IREG_pc, dest_addr);
-    uop_JMP(ir, codegen_exit_rout);
+    codegen_trace_side_exit(block, ir, next_pc, dest_addr, follow_taken);
     uop_set_jump_dest(ir, jump_uop);
-    return do_unroll ? 1 : 0;
+    return follow_taken ? 1 : 0;
 }
 
 static int
 ropJLE_common(codeblock_t *block, ir_data_t *ir, uint32_t dest_addr, uint32_t next_pc)
 {
     int jump_uop;
-    int jump_uop2 = -1;
-    int do_unroll = (((NF_SET() ? 1 : 0) != (VF_SET() ? 1 : 0) || ZF_SET()) && codegen_can_unroll(block, ir, next_pc, dest_addr));
+    int jump_uop2    = -1;
+    int follow_taken = (((NF_SET() ? 1 : 0) != (VF_SET() ? 1 : 0) || ZF_SET()) && codegen_follow_branch(block, ir, next_pc, dest_addr));
 
     switch (codegen_flags_changed ? cpu_state.flags_op : FLAGS_UNKNOWN) {
         case FLAGS_SUB8:
         case FLAGS_DEC8:
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_CMP_JLE_DEST(ir, IREG_flags_op1_B, IREG_flags_op2_B);
             else
                 jump_uop = uop_CMP_JNLE_DEST(ir, IREG_flags_op1_B, IREG_flags_op2_B);
             break;
         case FLAGS_SUB16:
         case FLAGS_DEC16:
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_CMP_JLE_DEST(ir, IREG_flags_op1_W, IREG_flags_op2_W);
             else
                 jump_uop = uop_CMP_JNLE_DEST(ir, IREG_flags_op1_W, IREG_flags_op2_W);
             break;
         case FLAGS_SUB32:
         case FLAGS_DEC32:
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_CMP_JLE_DEST(ir, IREG_flags_op1, IREG_flags_op2);
             else
                 jump_uop = uop_CMP_JNLE_DEST(ir, IREG_flags_op1, IREG_flags_op2);
@@ -720,7 +703,7 @@ ropJLE_common(codeblock_t *block, ir_data_t *ir, uint32_t dest_addr, uint32_t ne
 
         case FLAGS_UNKNOWN:
         default:
-            if (do_unroll) {
+            if (follow_taken) {
                 uop_CALL_FUNC_RESULT(ir, IREG_temp0, ZF_SET);
                 jump_uop2 = uop_CMP_IMM_JNZ_DEST(ir, IREG_temp0, 0);
                 uop_CALL_FUNC_RESULT(ir, IREG_temp0, NF_SET_01);
@@ -735,9 +718,8 @@ ropJLE_common(codeblock_t *block, ir_data_t *ir, uint32_t dest_addr, uint32_t ne
             }
             break;
     }
-    if (do_unroll) {
-        uop_MOV_IMM(ir, IREG_pc, next_pc);
-        uop_JMP(ir, codegen_exit_rout);
+    if (follow_taken) {
+        codegen_trace_side_exit(block, ir, next_pc, dest_addr, 1);
         uop_set_jump_dest(ir, jump_uop);
         if (jump_uop2 != -1)
             uop_set_jump_dest(ir, jump_uop2);
@@ -745,8 +727,7 @@ ropJLE_common(codeblock_t *block, ir_data_t *ir, uint32_t dest_addr, uint32_t ne
     } else {
         if (jump_uop2 != -1)
             uop_set_jump_dest(ir, jump_uop2);
-        uop_MOV_IMM(ir, IREG_pc, dest_addr);
-        uop_JMP(ir, codegen_exit_rout);
+        codegen_trace_side_exit(block, ir, next_pc, dest_addr, 0);
         uop_set_jump_dest(ir, jump_uop);
         return 0;
     }
@@ -755,27 +736,27 @@ static int
 ropJNLE_common(codeblock_t *block, ir_data_t *ir, uint32_t dest_addr, uint32_t next_pc)
 {
     int jump_uop;
-    int jump_uop2 = -1;
-    int do_unroll = ((NF_SET() ? 1 : 0) == (VF_SET() ? 1 : 0) && !ZF_SET() && codegen_can_unroll(block, ir, next_pc, dest_addr));
+    int jump_uop2    = -1;
+    int follow_taken = ((NF_SET() ? 1 : 0) == (VF_SET() ? 1 : 0) && !ZF_SET() && codegen_follow_branch(block, ir, next_pc, dest_addr));
 
     switch (codegen_flags_changed ? cpu_state.flags_op : FLAGS_UNKNOWN) {
         case FLAGS_SUB8:
         case FLAGS_DEC8:
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_CMP_JNLE_DEST(ir, IREG_flags_op1_B, IREG_flags_op2_B);
             else
                 jump_uop = uop_CMP_JLE_DEST(ir, IREG_flags_op1_B, IREG_flags_op2_B);
             break;
         case FLAGS_SUB16:
         case FLAGS_DEC16:
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_CMP_JNLE_DEST(ir, IREG_flags_op1_W, IREG_flags_op2_W);
             else
                 jump_uop = uop_CMP_JLE_DEST(ir, IREG_flags_op1_W, IREG_flags_op2_W);
             break;
         case FLAGS_SUB32:
         case FLAGS_DEC32:
-            if (do_unroll)
+            if (follow_taken)
                 jump_uop = uop_CMP_JNLE_DEST(ir, IREG_flags_op1, IREG_flags_op2);
             else
                 jump_uop = uop_CMP_JLE_DEST(ir, IREG_flags_op1, IREG_flags_op2);
@@ -783,7 +764,7 @@ ropJNLE_common(codeblock_t *block, ir_data_t *ir, uint32_t dest_addr, uint32_t n
 
         case FLAGS_UNKNOWN:
         default:
-            if (do_unroll) {
+            if (follow_taken) {
                 uop_CALL_FUNC_RESULT(ir, IREG_temp0, ZF_SET);
                 jump_uop2 = uop_CMP_IMM_JNZ_DEST(ir, IREG_temp0, 0);
                 uop_CALL_FUNC_RESULT(ir, IREG_temp0, NF_SET_01);
@@ -798,16 +779,14 @@ ropJNLE_common(codeblock_t *block, ir_data_t *ir, uint32_t dest_addr, uint32_t n
             }
             break;
     }
-    if (do_unroll) {
+    if (follow_taken) {
         if (jump_uop2 != -1)
             uop_set_jump_dest(ir, jump_uop2);
-        uop_MOV_IMM(ir, IREG_pc, next_pc);
-        uop_JMP(ir, codegen_exit_rout);
+        codegen_trace_side_exit(block, ir, next_pc, dest_addr, 1);
         uop_set_jump_dest(ir, jump_uop);
         return 1;
     } else {
-        uop_MOV_IMM(ir, IREG_pc, dest_addr);
-        uop_JMP(ir, codegen_exit_rout);
+        codegen_trace_side_exit(block, ir, next_pc, dest_addr, 0);
         uop_set_jump_dest(ir, jump_uop);
         if (jump_uop2 != -1)
             uop_set_jump_dest(ir, jump_uop2);
@@ -901,7 +880,7 @@ ropJCXZ(codeblock_t *block, ir_data_t *ir, UNUSED(uint8_t opcode), UNUSED(uint32
     else
         jump_uop = uop_CMP_IMM_JNZ_DEST(ir, IREG_CX, 0);
     uop_MOV_IMM(ir, IREG_pc, dest_addr);
-    uop_JMP(ir, codegen_exit_rout);
+    uop_JMP_CHAIN(ir, dest_addr);
     uop_set_jump_dest(ir, jump_uop);
 
     codegen_mark_code_present(block, cs + op_pc, 1);
@@ -928,6 +907,7 @@ ropLOOP(codeblock_t *block, ir_data_t *ir, UNUSED(uint8_t opcode), UNUSED(uint32
             jump_uop = uop_CMP_IMM_JNZ_DEST(ir, IREG_CX, 0);
         }
         uop_MOV_IMM(ir, IREG_pc, op_pc + 1);
+        uop_JMP_CHAIN(ir, op_pc + 1);
         ret_addr = dest_addr;
         CPU_BLOCK_END();
     } else {
@@ -939,9 +919,9 @@ ropLOOP(codeblock_t *block, ir_data_t *ir, UNUSED(uint8_t opcode), UNUSED(uint32
             jump_uop = uop_CMP_IMM_JZ_DEST(ir, IREG_CX, 0);
         }
         uop_MOV_IMM(ir, IREG_pc, dest_addr);
+        uop_JMP_CHAIN(ir, dest_addr);
         ret_addr = op_pc + 1;
     }
-    uop_JMP(ir, codegen_exit_rout);
     uop_set_jump_dest(ir, jump_uop);
 
     codegen_mark_code_present(block, cs + op_pc, 1);
@@ -973,7 +953,7 @@ ropLOOPE(codeblock_t *block, ir_data_t *ir, UNUSED(uint8_t opcode), UNUSED(uint3
         jump_uop2 = uop_CMP_IMM_JNZ_DEST(ir, IREG_flags_res, 0);
     }
     uop_MOV_IMM(ir, IREG_pc, dest_addr);
-    uop_JMP(ir, codegen_exit_rout);
+    uop_JMP_CHAIN(ir, dest_addr);
     uop_NOP_BARRIER(ir);
     uop_set_jump_dest(ir, jump_uop);
     uop_set_jump_dest(ir, jump_uop2);
@@ -1006,7 +986,7 @@ ropLOOPNE(codeblock_t *block, ir_data_t *ir, UNUSED(uint8_t opcode), UNUSED(uint
         jump_uop2 = uop_CMP_IMM_JZ_DEST(ir, IREG_flags_res, 0);
     }
     uop_MOV_IMM(ir, IREG_pc, dest_addr);
-    uop_JMP(ir, codegen_exit_rout);
+    uop_JMP_CHAIN(ir, dest_addr);
     uop_NOP_BARRIER(ir);
     uop_set_jump_dest(ir, jump_uop);
     uop_set_jump_dest(ir, jump_uop2);
@@ -75,3 +75,129 @@ codegen_can_unroll_full(codeblock_t *block, ir_data_t *ir, UNUSED(uint32_t next_
 
     return 1;
 }
+
+/*Runtime profile of conditional branches followed, or not, as traces. Keyed
+  by the physical address of the instruction after the branch. A branch is
+  retranslated whenever its side exit has been taken TRACE_EXIT_LIMIT times,
+  with the other side as the trace, until TRACE_RECOMPILE_MAX retranslations
+  have happened. After that it is never followed. A slot whose branch has
+  been retranslated is never handed to another branch, so the bound holds
+  across hash collisions; a colliding branch is then just not followed*/
+#define TRACE_BRANCH_NR     4096
+#define TRACE_EXIT_LIMIT    64
+#define TRACE_RECOMPILE_MAX 4
+
+typedef struct trace_branch_t {
+    uint32_t phys;
+    uint8_t  exits;
+    uint8_t  recompiles;
+    uint8_t  no_follow;
+} trace_branch_t;
+
+static trace_branch_t trace_branches[TRACE_BRANCH_NR];
+
+static trace_branch_t *
+trace_branch_get(uint32_t phys)
+{
+    trace_branch_t *branch = &trace_branches[(phys * 0x9e3779b1) >> 20];
+
+    if (branch->phys != phys) {
+        if (branch->recompiles)
+            return NULL;
+        branch->phys       = phys;
+        branch->exits      = 0;
+        branch->recompiles = 0;
+        branch->no_follow  = 0;
+    }
+    return branch;
+}
+
+/*Only forward branches within the block's first page are followed, so the
+  code covered by the block stays within the range tracked by page_mask and
+  page_mask2. Skipped code is not marked, and writes to it do not invalidate
+  the block*/
+static int
+trace_candidate(codeblock_t *block, uint32_t next_pc, uint32_t dest_addr)
+{
+    uint32_t dest     = cs + dest_addr;
+    uint32_t max_size = (block->flags & CODEBLOCK_BYTE_MASK) ? ((128 - 25) - (block->pc & 0x3f)) : 1000;
+
+    if ((block->ins + 1) >= MAX_INSTRUCTION_COUNT)
+        return 0;
+    if (dest < (cs + next_pc) || ((dest ^ block->pc) & ~0xfff))
+        return 0;
+    return (dest - block->pc) < max_size;
+}
+
+static uint32_t
+trace_branch_phys(codeblock_t *block, uint32_t next_pc)
+{
+    uint32_t addr = cs + next_pc;
+
+    if ((addr ^ block->pc) & ~0xfff)
+        return get_phys_noabrt(addr);
+    return (block->phys & ~0xfff) | (addr & 0xfff);
+}
+
+void
+codegen_trace_count_exit(void)
+{
+    uint32_t        data   = cpu_state.trace_exit_data;
+    trace_branch_t *branch = trace_branch_get(cpu_state.trace_exit_phys);
+
+    cpu_state.trace_exit_data = BLOCK_INVALID;
+
+    if (!branch || branch->recompiles >= TRACE_RECOMPILE_MAX)
+        return;
+
+    if (++branch->exits >= TRACE_EXIT_LIMIT) {
+        /*The side exit is the hot path. Flip the branch and have the block
+          translated again*/
+        branch->exits     = 0;
+        branch->no_follow = data >> 16;
+        if (++branch->recompiles >= TRACE_RECOMPILE_MAX)
+            branch->no_follow = 1;
+        codeblock[data & 0xffff].flags &= ~CODEBLOCK_WAS_RECOMPILED;
+    }
+}
+
+int
+codegen_trace_branch(codeblock_t *block, uint32_t next_pc, uint32_t dest_addr)
+{
+    trace_branch_t *branch;
+
+    if (!trace_candidate(block, next_pc, dest_addr))
+        return 0;
+    branch = trace_branch_get(trace_branch_phys(block, next_pc));
+    if (!branch || branch->no_follow)
+        return 0;
+
+    codegen_trace_dest = cs + dest_addr;
+    return 1;
+}
+
+void
+codegen_trace_side_exit(codeblock_t *block, ir_data_t *ir, uint32_t next_pc, uint32_t dest_addr, int follow_taken)
+{
+    uint32_t        exit_pc = follow_taken ? next_pc : dest_addr;
+    uint32_t        phys;
+    trace_branch_t *branch;
+
+    uop_MOV_IMM(ir, IREG_pc, exit_pc);
+
+    if (trace_candidate(block, next_pc, dest_addr)) {
+        phys   = trace_branch_phys(block, next_pc);
+        branch = trace_branch_get(phys);
+        if (branch && (branch->recompiles < TRACE_RECOMPILE_MAX)) {
+            /*Counted by the dispatcher, so the exit is not chained. A helper
+              call here would be a barrier, and leave the rest of the trace
+              with no registers cached*/
+            uop_STORE_PTR_IMM(ir, &cpu_state.trace_exit_data, get_block_nr(block) | (follow_taken << 16));
+            uop_STORE_PTR_IMM(ir, &cpu_state.trace_exit_phys, phys);
+            uop_JMP(ir, codegen_exit_rout);
+            return;
+        }
+    }
+
+    uop_JMP_CHAIN(ir, exit_pc);
+}
@@ -125,3 +125,18 @@ codegen_can_unroll(codeblock_t *block, ir_data_t *ir, uint32_t next_pc, uint32_t
 
     return codegen_can_unroll_full(block, ir, next_pc, dest_addr);
 }
+
+/*Continue translation at the destination of a taken forward branch, forming
+  a trace. Returns 1 if the branch is being followed*/
+int codegen_trace_branch(codeblock_t *block, uint32_t next_pc, uint32_t dest_addr);
+/*Exit from a trace through the side of a conditional branch that was not
+  followed, counting the exit while the branch is being profiled*/
+void codegen_trace_side_exit(codeblock_t *block, ir_data_t *ir, uint32_t next_pc, uint32_t dest_addr, int follow_taken);
+
+/*Should the taken side of a conditional branch be compiled inline, either as
+  an unrolled loop or as a trace?*/
+static inline int
+codegen_follow_branch(codeblock_t *block, ir_data_t *ir, uint32_t next_pc, uint32_t dest_addr)
+{
+    return codegen_can_unroll(block, ir, next_pc, dest_addr) || codegen_trace_branch(block, next_pc, dest_addr);
+}
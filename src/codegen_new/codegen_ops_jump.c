@@ -23,8 +23,10 @@ ropJMP_r8(codeblock_t *block, ir_data_t *ir, UNUSED(uint8_t opcode), UNUSED(uint
     if (!(op_32 & 0x100))
         dest_addr &= 0xffff;
 
-    if (offset < 0)
+    if ((int32_t) offset < 0)
         codegen_can_unroll(block, ir, op_pc + 1, dest_addr);
+    else
+        codegen_trace_branch(block, op_pc + 1, dest_addr);
     codegen_mark_code_present(block, cs + op_pc, 1);
     return dest_addr;
 }
@@ -36,8 +38,10 @@ ropJMP_r16(codeblock_t *block, ir_data_t *ir, UNUSED(uint8_t opcode), UNUSED(uin
 
     dest_addr &= 0xffff;
 
-    if (offset < 0)
+    if ((int32_t) offset < 0)
         codegen_can_unroll(block, ir, op_pc + 1, dest_addr);
+    else
+        codegen_trace_branch(block, op_pc + 2, dest_addr);
     codegen_mark_code_present(block, cs + op_pc, 2);
     return dest_addr;
 }
@@ -47,8 +51,10 @@ ropJMP_r32(codeblock_t *block, ir_data_t *ir, UNUSED(uint8_t opcode), UNUSED(uin
     uint32_t offset    = fastreadl(cs + op_pc);
     uint32_t dest_addr = op_pc + 4 + offset;
 
-    if (offset < 0)
+    if ((int32_t) offset < 0)
         codegen_can_unroll(block, ir, op_pc + 1, dest_addr);
+    else
+        codegen_trace_branch(block, op_pc + 4, dest_addr);
     codegen_mark_code_present(block, cs + op_pc, 4);
     return dest_addr;
 }
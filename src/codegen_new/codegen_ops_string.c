@@ -0,0 +1,191 @@
+#include <stdint.h>
+#include <86box/86box.h>
+#include "cpu.h"
+#include <86box/mem.h>
+#include <86box/plat_unused.h>
+
+#include "x86_ops.h"
+#include "x86.h"
+#include "x86_flags.h"
+#include "x86seg_common.h"
+#include "x86seg.h"
+#include "386_common.h"
+#include "codegen.h"
+#include "codegen_ir.h"
+#include "codegen_ops.h"
+#include "codegen_ops_helpers.h"
+#include "codegen_ops_string.h"
+
+#define STRING_REG(size, b, w, l) (((size) == 1) ? (b) : (((size) == 2) ? (w) : (l)))
+
+/*Address of the element at SI/ESI or DI/EDI*/
+static int
+string_addr(ir_data_t *ir, int reg, uint32_t op_32)
+{
+    if (op_32 & 0x200)
+        return IREG_32(reg);
+
+    uop_MOVZX(ir, IREG_eaaddr, IREG_16(reg));
+    return IREG_eaaddr;
+}
+
+/*Set IREG_temp1 to the negated step, ie size when DF is set and -size when
+  it is clear. DF is not known at compile time, so is picked out of flags*/
+static void
+string_get_step(ir_data_t *ir, int size)
+{
+    int shift = (size == 4) ? 2 : (size - 1);
+
+    uop_MOVZX(ir, IREG_temp1, IREG_flags);
+    uop_AND_IMM(ir, IREG_temp1, IREG_temp1, D_FLAG);
+    uop_SHR_IMM(ir, IREG_temp1, IREG_temp1, 9 - shift);
+    uop_SUB_IMM(ir, IREG_temp1, IREG_temp1, size);
+}
+
+static void
+string_step(ir_data_t *ir, int reg, uint32_t op_32)
+{
+    if (op_32 & 0x200)
+        uop_SUB(ir, IREG_32(reg), IREG_32(reg), IREG_temp1);
+    else
+        uop_SUB(ir, IREG_16(reg), IREG_16(reg), IREG_temp1_W);
+}
+
+static void
+string_cmp(ir_data_t *ir, int size, int src_reg_a, int src_reg_b)
+{
+    if (size == 4) {
+        uop_MOV(ir, IREG_flags_op1, src_reg_a);
+        uop_MOV(ir, IREG_flags_op2, src_reg_b);
+        uop_SUB(ir, IREG_flags_res, src_reg_a, src_reg_b);
+        uop_MOV_IMM(ir, IREG_flags_op, FLAGS_SUB32);
+    } else {
+        uop_MOVZX(ir, IREG_flags_op1, src_reg_a);
+        uop_MOVZX(ir, IREG_flags_op2, src_reg_b);
+        if (size == 2) {
+            uop_SUB(ir, IREG_flags_res_W, src_reg_a, src_reg_b);
+            uop_MOVZX(ir, IREG_flags_res, IREG_flags_res_W);
+            uop_MOV_IMM(ir, IREG_flags_op, FLAGS_SUB16);
+        } else {
+            uop_SUB(ir, IREG_flags_res_B, src_reg_a, src_reg_b);
+            uop_MOVZX(ir, IREG_flags_res, IREG_flags_res_B);
+            uop_MOV_IMM(ir, IREG_flags_op, FLAGS_SUB8);
+        }
+    }
+    codegen_flags_changed = 1;
+}
+
+static uint32_t
+rop_movs(codeblock_t *block, ir_data_t *ir, int size, uint32_t op_32, uint32_t op_pc)
+{
+    int data_reg = STRING_REG(size, IREG_temp0_B, IREG_temp0_W, IREG_temp0);
+    int addr_reg;
+
+    uop_MOV_IMM(ir, IREG_oldpc, cpu_state.oldpc);
+    codegen_check_seg_read(block, ir, op_ea_seg);
+    codegen_check_seg_write(block, ir, &cpu_state.seg_es);
+    addr_reg = string_addr(ir, REG_ESI, op_32);
+    uop_MEM_LOAD_REG(ir, data_reg, ireg_seg_base(op_ea_seg), addr_reg);
+    addr_reg = string_addr(ir, REG_EDI, op_32);
+    uop_MEM_STORE_REG(ir, IREG_ES_base, addr_reg, data_reg);
+
+    string_get_step(ir, size);
+    string_step(ir, REG_ESI, op_32);
+    string_step(ir, REG_EDI, op_32);
+
+    return op_pc;
+}
+static uint32_t
+rop_cmps(codeblock_t *block, ir_data_t *ir, int size, uint32_t op_32, uint32_t op_pc)
+{
+    int src_reg  = STRING_REG(size, IREG_temp0_B, IREG_temp0_W, IREG_temp0);
+    int dest_reg = STRING_REG(size, IREG_temp2_B, IREG_temp2_W, IREG_temp2);
+    int addr_reg;
+
+    uop_MOV_IMM(ir, IREG_oldpc, cpu_state.oldpc);
+    codegen_check_seg_read(block, ir, op_ea_seg);
+    codegen_check_seg_read(block, ir, &cpu_state.seg_es);
+    addr_reg = string_addr(ir, REG_ESI, op_32);
+    uop_MEM_LOAD_REG(ir, src_reg, ireg_seg_base(op_ea_seg), addr_reg);
+    addr_reg = string_addr(ir, REG_EDI, op_32);
+    uop_MEM_LOAD_REG(ir, dest_reg, IREG_ES_base, addr_reg);
+    string_cmp(ir, size, src_reg, dest_reg);
+
+    string_get_step(ir, size);
+    string_step(ir, REG_ESI, op_32);
+    string_step(ir, REG_EDI, op_32);
+
+    return op_pc;
+}
+static uint32_t
+rop_stos(codeblock_t *block, ir_data_t *ir, int size, uint32_t op_32, uint32_t op_pc)
+{
+    int data_reg = STRING_REG(size, IREG_AL, IREG_AX, IREG_EAX);
+    int addr_reg;
+
+    uop_MOV_IMM(ir, IREG_oldpc, cpu_state.oldpc);
+    codegen_check_seg_write(block, ir, &cpu_state.seg_es);
+    addr_reg = string_addr(ir, REG_EDI, op_32);
+    uop_MEM_STORE_REG(ir, IREG_ES_base, addr_reg, data_reg);
+
+    string_get_step(ir, size);
+    string_step(ir, REG_EDI, op_32);
+
+    return op_pc;
+}
+static uint32_t
+rop_lods(codeblock_t *block, ir_data_t *ir, int size, uint32_t op_32, uint32_t op_pc)
+{
+    int data_reg = STRING_REG(size, IREG_AL, IREG_AX, IREG_EAX);
+    int addr_reg;
+
+    uop_MOV_IMM(ir, IREG_oldpc, cpu_state.oldpc);
+    codegen_check_seg_read(block, ir, op_ea_seg);
+    addr_reg = string_addr(ir, REG_ESI, op_32);
+    uop_MEM_LOAD_REG(ir, data_reg, ireg_seg_base(op_ea_seg), addr_reg);
+
+    string_get_step(ir, size);
+    string_step(ir, REG_ESI, op_32);
+
+    return op_pc;
+}
+static uint32_t
+rop_scas(codeblock_t *block, ir_data_t *ir, int size, uint32_t op_32, uint32_t op_pc)
+{
+    int src_reg  = STRING_REG(size, IREG_AL, IREG_AX, IREG_EAX);
+    int dest_reg = STRING_REG(size, IREG_temp0_B, IREG_temp0_W, IREG_temp0);
+    int addr_reg;
+
+    uop_MOV_IMM(ir, IREG_oldpc, cpu_state.oldpc);
+    codegen_check_seg_read(block, ir, &cpu_state.seg_es);
+    addr_reg = string_addr(ir, REG_EDI, op_32);
+    uop_MEM_LOAD_REG(ir, dest_reg, IREG_ES_base, addr_reg);
+    string_cmp(ir, size, src_reg, dest_reg);
+
+    string_get_step(ir, size);
+    string_step(ir, REG_EDI, op_32);
+
+    return op_pc;
+}
+
+#define ROP_STRING(name, func)                                                                                                                    \
+    uint32_t rop##name##B(codeblock_t *block, ir_data_t *ir, UNUSED(uint8_t opcode), UNUSED(uint32_t fetchdat), uint32_t op_32, uint32_t op_pc) \
+    {                                                                                                                                             \
+        return func(block, ir, 1, op_32, op_pc);                                                                                                  \
+    }                                                                                                                                             \
+    uint32_t rop##name##W(codeblock_t *block, ir_data_t *ir, UNUSED(uint8_t opcode), UNUSED(uint32_t fetchdat), uint32_t op_32, uint32_t op_pc) \
+    {                                                                                                                                             \
+        return func(block, ir, 2, op_32, op_pc);                                                                                                  \
+    }                                                                                                                                             \
+    uint32_t rop##name##L(codeblock_t *block, ir_data_t *ir, UNUSED(uint8_t opcode), UNUSED(uint32_t fetchdat), uint32_t op_32, uint32_t op_pc) \
+    {                                                                                                                                             \
+        return func(block, ir, 4, op_32, op_pc);                                                                                                  \
+    }
+
+// clang-format off
+ROP_STRING(MOVS, rop_movs)
+ROP_STRING(CMPS, rop_cmps)
+ROP_STRING(STOS, rop_stos)
+ROP_STRING(LODS, rop_lods)
+ROP_STRING(SCAS, rop_scas)
+// clang-format on
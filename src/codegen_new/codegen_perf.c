@@ -0,0 +1,243 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef __linux__
+#    include <sys/mman.h>
+#    include <sys/syscall.h>
+#    include <time.h>
+#    include <unistd.h>
+#endif
+#include <86box/86box.h>
+#include "cpu.h"
+#include <86box/mem.h>
+#include <86box/plat_unused.h>
+
+#include "codegen.h"
+#include "codegen_allocator.h"
+#include "codegen_perf.h"
+
+int codegen_perf_mode = CODEGEN_PERF_OFF;
+
+#ifdef __linux__
+/*Live code in map mode, one entry per mem_block_t*/
+typedef struct perf_entry_t {
+    uint8_t *addr;
+    uint32_t size;
+    uint32_t _cs;
+    uint32_t pc;
+    uint32_t phys;
+} perf_entry_t;
+
+static FILE         *perf_fp;
+static char          perf_path[64];
+static perf_entry_t *perf_entries;
+static int           perf_live;
+static int           perf_dead;
+static void         *jitdump_marker;
+static uint64_t      jitdump_index;
+
+#    define JITDUMP_MAGIC        0x4a695444
+#    define JITDUMP_VERSION      1
+#    define JITDUMP_CODE_LOAD    0
+#    if defined __aarch64__ || defined _M_ARM64
+#        define JITDUMP_ELF_MACH 183 /*EM_AARCH64*/
+#    elif defined __arm__ || defined _M_ARM
+#        define JITDUMP_ELF_MACH 40 /*EM_ARM*/
+#    elif defined __amd64__ || defined _M_X64
+#        define JITDUMP_ELF_MACH 62 /*EM_X86_64*/
+#    else
+#        define JITDUMP_ELF_MACH 3 /*EM_386*/
+#    endif
+
+typedef struct jitdump_header_t {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t total_size;
+    uint32_t elf_mach;
+    uint32_t pad1;
+    uint32_t pid;
+    uint64_t timestamp;
+    uint64_t flags;
+} jitdump_header_t;
+
+typedef struct jitdump_code_load_t {
+    uint32_t id;
+    uint32_t total_size;
+    uint64_t timestamp;
+    uint32_t pid;
+    uint32_t tid;
+    uint64_t vma;
+    uint64_t code_addr;
+    uint64_t code_size;
+    uint64_t code_index;
+} jitdump_code_load_t;
+
+static uint64_t
+jitdump_timestamp(void)
+{
+    struct timespec ts;
+
+    /*Must match the clock used by perf record -k mono*/
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+}
+
+static void
+perf_entry_name(char *buf, size_t len, uint32_t cs_base, uint32_t pc, uint32_t phys)
+{
+    if (pc == BLOCK_PC_INVALID)
+        snprintf(buf, len, "86box_dynarec_helpers");
+    else
+        snprintf(buf, len, "guest_%08x:%08x_phys_%08x", cs_base, pc - cs_base, phys);
+}
+
+static void
+perf_map_write(const perf_entry_t *entry)
+{
+    char name[64];
+
+    perf_entry_name(name, sizeof(name), entry->_cs, entry->pc, entry->phys);
+    fprintf(perf_fp, "%lx %x %s\n", (unsigned long) (uintptr_t) entry->addr, entry->size, name);
+}
+
+static void
+perf_map_rewrite(void)
+{
+    /*Drop retired entries by writing the file again from the live table*/
+    perf_fp = freopen(perf_path, "w", perf_fp);
+    if (!perf_fp) {
+        codegen_perf_mode = CODEGEN_PERF_OFF;
+        return;
+    }
+
+    for (int c = 0; c < codegen_mem_block_count; c++) {
+        if (perf_entries[c].addr)
+            perf_map_write(&perf_entries[c]);
+    }
+    fflush(perf_fp);
+    perf_dead = 0;
+}
+
+void
+codegen_perf_init(void)
+{
+    codegen_perf_mode = dynarec_perf_map;
+    if ((codegen_perf_mode != CODEGEN_PERF_MAP) && (codegen_perf_mode != CODEGEN_PERF_JITDUMP)) {
+        codegen_perf_mode = CODEGEN_PERF_OFF;
+        return;
+    }
+
+    if (codegen_perf_mode == CODEGEN_PERF_MAP) {
+        snprintf(perf_path, sizeof(perf_path), "/tmp/perf-%d.map", (int) getpid());
+        perf_entries = calloc(codegen_mem_block_count, sizeof(perf_entry_t));
+        perf_fp      = perf_entries ? fopen(perf_path, "w") : NULL;
+    } else {
+        jitdump_header_t header = {
+            .magic      = JITDUMP_MAGIC,
+            .version    = JITDUMP_VERSION,
+            .total_size = sizeof(jitdump_header_t),
+            .elf_mach   = JITDUMP_ELF_MACH,
+            .pid        = getpid(),
+            .timestamp  = jitdump_timestamp()
+        };
+
+        snprintf(perf_path, sizeof(perf_path), "/tmp/jit-%d.dump", (int) getpid());
+        perf_fp = fopen(perf_path, "w+");
+        if (perf_fp) {
+            fwrite(&header, sizeof(header), 1, perf_fp);
+            fflush(perf_fp);
+
+            /*perf record finds the dump through an executable mapping of it*/
+            jitdump_marker = mmap(NULL, sysconf(_SC_PAGESIZE), PROT_READ | PROT_EXEC, MAP_PRIVATE, fileno(perf_fp), 0);
+            if (jitdump_marker == MAP_FAILED) {
+                fclose(perf_fp);
+                perf_fp = NULL;
+            }
+        }
+    }
+
+    if (!perf_fp) {
+        pclog("Dynarec: unable to open %s, profiler symbols disabled\n", perf_path);
+        codegen_perf_mode = CODEGEN_PERF_OFF;
+        return;
+    }
+    pclog("Dynarec: writing profiler symbols to %s\n", perf_path);
+}
+
+void
+codegen_perf_load(uint32_t mem_block_nr, uint8_t *addr, uint32_t size, codeblock_t *block)
+{
+    if (codegen_perf_mode == CODEGEN_PERF_MAP) {
+        perf_entry_t *entry = &perf_entries[mem_block_nr];
+
+        if (entry->addr)
+            perf_live--;
+        entry->addr = addr;
+        entry->size = size;
+        entry->_cs  = block->_cs;
+        entry->pc   = block->pc;
+        entry->phys = block->phys;
+        perf_live++;
+        perf_map_write(entry);
+        fflush(perf_fp);
+    } else if (codegen_perf_mode == CODEGEN_PERF_JITDUMP) {
+        jitdump_code_load_t record;
+        char                name[64];
+        uint32_t            name_len;
+
+        perf_entry_name(name, sizeof(name), block->_cs, block->pc, block->phys);
+        name_len = strlen(name) + 1;
+
+        record.id         = JITDUMP_CODE_LOAD;
+        record.total_size = sizeof(record) + name_len + size;
+        record.timestamp  = jitdump_timestamp();
+        record.pid        = getpid();
+        record.tid        = syscall(SYS_gettid);
+        record.vma        = (uintptr_t) addr;
+        record.code_addr  = (uintptr_t) addr;
+        record.code_size  = size;
+        record.code_index = jitdump_index++;
+
+        fwrite(&record, sizeof(record), 1, perf_fp);
+        fwrite(name, name_len, 1, perf_fp);
+        fwrite(addr, size, 1, perf_fp);
+        fflush(perf_fp);
+    }
+}
+
+void
+codegen_perf_retire(uint32_t mem_block_nr)
+{
+    /*jitdump records are ordered by timestamp, so nothing needs retiring*/
+    if ((codegen_perf_mode != CODEGEN_PERF_MAP) || !perf_entries[mem_block_nr].addr)
+        return;
+
+    perf_entries[mem_block_nr].addr = NULL;
+    perf_live--;
+    perf_dead++;
+
+    /*Amortise rewrites, but never let retired entries outnumber live ones*/
+    if ((perf_dead > 1024) && (perf_dead > perf_live))
+        perf_map_rewrite();
+}
+#else
+void
+codegen_perf_init(void)
+{
+    if (dynarec_perf_map)
+        pclog("Dynarec: profiler symbols are only supported on Linux\n");
+}
+
+void
+codegen_perf_load(UNUSED(uint32_t mem_block_nr), UNUSED(uint8_t *addr), UNUSED(uint32_t size), UNUSED(codeblock_t *block))
+{
+    //
+}
+
+void
+codegen_perf_retire(UNUSED(uint32_t mem_block_nr))
+{
+    //
+}
+#endif
@@ -0,0 +1,29 @@
+#ifndef _CODEGEN_PERF_H_
+#define _CODEGEN_PERF_H_
+
+/*Profiler symbol output for generated code, selected by the dynarec_perf_map
+  setting. Linux only.
+
+  CODEGEN_PERF_MAP writes /tmp/perf-<pid>.map, which perf reads at report time.
+  A map file has no notion of time, so when code is freed its entries are
+  retired and the file is periodically rewritten to only describe live code.
+  Samples in code that has since been freed are then reported as unknown.
+
+  CODEGEN_PERF_JITDUMP writes /tmp/jit-<pid>.dump for `perf record -k mono`
+  followed by `perf inject --jit`. Each record is timestamped, so reused
+  memory is attributed to whichever block occupied it at the time.*/
+enum {
+    CODEGEN_PERF_OFF = 0,
+    CODEGEN_PERF_MAP,
+    CODEGEN_PERF_JITDUMP
+};
+
+extern int codegen_perf_mode;
+
+extern void codegen_perf_init(void);
+/*Describe a chunk of memory now holding code for block*/
+extern void codegen_perf_load(uint32_t mem_block_nr, uint8_t *addr, uint32_t size, codeblock_t *block);
+/*The chunk of memory previously passed to codegen_perf_load() has been freed*/
+extern void codegen_perf_retire(uint32_t mem_block_nr);
+
+#endif
@@ -9,11 +9,10 @@
 #include "codegen_ir_defs.h"
 #include "codegen_reg.h"
 
-int      max_version_refcount;
-uint16_t reg_dead_list = 0;
+int max_version_refcount;
 
-uint8_t       reg_last_version[IREG_COUNT];
-reg_version_t reg_version[IREG_COUNT][256];
+static codegen_reg_state_t    reg_state_default;
+__thread codegen_reg_state_t *codegen_reg_state = &reg_state_default;
 
 ir_reg_t invalid_ir_reg = { IREG_INVALID };
 
@@ -195,6 +194,30 @@ codegen_reg_mark_as_required(void)
     }
 }
 
+int
+codegen_reg_is_permanent(int reg)
+{
+    return ireg_data[IREG_GET_REG(reg)].is_volatile == REG_PERMANENT;
+}
+
+int
+codegen_reg_native_width(int reg)
+{
+    if (ireg_data[IREG_GET_REG(reg)].type != REG_INTEGER)
+        return 0;
+
+    switch (ireg_data[IREG_GET_REG(reg)].native_size) {
+        case REG_BYTE:
+            return 8;
+        case REG_WORD:
+            return 16;
+        case REG_DWORD:
+            return 32;
+        default:
+            return 0;
+    }
+}
+
 int
 reg_is_native_size(ir_reg_t ir_reg)
 {
@@ -242,6 +265,18 @@ codegen_check_regs(void)
 
 void
 codegen_reg_reset(void)
+{
+    for (int c = 0; c < IREG_COUNT; c++) {
+        reg_last_version[c]        = 0;
+        reg_version[c][0].refcount = 0;
+    }
+
+    reg_dead_list        = 0;
+    max_version_refcount = 0;
+}
+
+void
+codegen_reg_reset_host_regs(void)
 {
     int c;
 
@@ -256,10 +291,6 @@ codegen_reg_reset(void)
     host_fp_reg_set.locked   = 0;
     host_fp_reg_set.nr_regs  = CODEGEN_HOST_FP_REGS;
 
-    for (c = 0; c < IREG_COUNT; c++) {
-        reg_last_version[c]        = 0;
-        reg_version[c][0].refcount = 0;
-    }
     for (c = 0; c < CODEGEN_HOST_REGS; c++) {
         host_reg_set.regs[c]  = invalid_ir_reg;
         host_reg_set.dirty[c] = 0;
@@ -268,9 +299,6 @@ codegen_reg_reset(void)
         host_fp_reg_set.regs[c]  = invalid_ir_reg;
         host_fp_reg_set.dirty[c] = 0;
     }
-
-    reg_dead_list        = 0;
-    max_version_refcount = 0;
 }
 
 static inline int
@@ -863,6 +891,94 @@ codegen_reg_flush_invalidate(UNUSED(ir_data_t *ir), codeblock_t *block)
     }
 }
 
+#ifdef CODEGEN_BACKEND_HAS_EXIT_WRITEBACK
+void
+codegen_reg_flush_volatile(UNUSED(ir_data_t *ir), codeblock_t *block)
+{
+    host_reg_set_t *reg_set;
+    int             c;
+
+    reg_set = &host_reg_set;
+    for (c = 0; c < reg_set->nr_regs; c++) {
+        if (reg_set->reg_list[c].flags & HOST_REG_FLAG_VOLATILE) {
+            if (!ir_reg_is_invalid(reg_set->regs[c]) && reg_set->dirty[c])
+                codegen_reg_writeback(reg_set, block, c, 1);
+            reg_set->regs[c]  = invalid_ir_reg;
+            reg_set->dirty[c] = 0;
+        }
+    }
+
+    reg_set = &host_fp_reg_set;
+    for (c = 0; c < reg_set->nr_regs; c++) {
+        if (reg_set->reg_list[c].flags & HOST_REG_FLAG_VOLATILE) {
+            if (!ir_reg_is_invalid(reg_set->regs[c]) && reg_set->dirty[c])
+                codegen_reg_writeback(reg_set, block, c, 1);
+            reg_set->regs[c]  = invalid_ir_reg;
+            reg_set->dirty[c] = 0;
+        }
+    }
+}
+
+void
+codegen_reg_flush_reg(codeblock_t *block, ir_reg_t ir_reg)
+{
+    host_reg_set_t *reg_set = get_reg_set(ir_reg);
+
+    /*The allocator may overwrite the previous version of a register in place
+      when writing a new one, so it must be in memory before an exit path
+      can skip it*/
+    for (int c = 0; c < reg_set->nr_regs; c++) {
+        if (!ir_reg_is_invalid(reg_set->regs[c]) && IREG_GET_REG(reg_set->regs[c].reg) == IREG_GET_REG(ir_reg.reg) && reg_set->dirty[c])
+            codegen_reg_writeback(reg_set, block, c, 0);
+    }
+}
+
+static int
+reg_is_exit_dirty(const host_reg_set_t *reg_set, int c, ir_reg_t skip)
+{
+    if (ir_reg_is_invalid(reg_set->regs[c]) || !reg_set->dirty[c])
+        return 0;
+    return IREG_GET_REG(reg_set->regs[c].reg) != IREG_GET_REG(skip.reg) || reg_set->regs[c].version != skip.version;
+}
+
+int
+codegen_reg_exit_dirty(ir_reg_t skip)
+{
+    for (int c = 0; c < host_reg_set.nr_regs; c++) {
+        if (reg_is_exit_dirty(&host_reg_set, c, skip))
+            return 1;
+    }
+    for (int c = 0; c < host_fp_reg_set.nr_regs; c++) {
+        if (reg_is_exit_dirty(&host_fp_reg_set, c, skip))
+            return 1;
+    }
+    return 0;
+}
+
+void
+codegen_reg_writeback_exit(codeblock_t *block, ir_reg_t skip)
+{
+    host_reg_set_t *reg_set;
+    int             c;
+
+    reg_set = &host_reg_set;
+    for (c = 0; c < reg_set->nr_regs; c++) {
+        if (reg_is_exit_dirty(reg_set, c, skip)) {
+            codegen_reg_writeback(reg_set, block, c, 0);
+            reg_set->dirty[c] = 1;
+        }
+    }
+
+    reg_set = &host_fp_reg_set;
+    for (c = 0; c < reg_set->nr_regs; c++) {
+        if (reg_is_exit_dirty(reg_set, c, skip)) {
+            codegen_reg_writeback(reg_set, block, c, 0);
+            reg_set->dirty[c] = 1;
+        }
+    }
+}
+#endif
+
 /*Process dead register list, and optimise out register versions and uOPs where
   possible*/
 void
@@ -882,19 +998,19 @@ codegen_reg_process_dead_list(ir_data_t *ir)
             if (uop->src_reg_a.reg != IREG_INVALID) {
                 reg_version_t *src_regv = &reg_version[IREG_GET_REG(uop->src_reg_a.reg)][uop->src_reg_a.version];
                 src_regv->refcount--;
-                if (!src_regv->refcount)
+                if (!src_regv->refcount && !(src_regv->flags & REG_FLAGS_REQUIRED))
                     add_to_dead_list(src_regv, IREG_GET_REG(uop->src_reg_a.reg), uop->src_reg_a.version);
             }
             if (uop->src_reg_b.reg != IREG_INVALID) {
                 reg_version_t *src_regv = &reg_version[IREG_GET_REG(uop->src_reg_b.reg)][uop->src_reg_b.version];
                 src_regv->refcount--;
-                if (!src_regv->refcount)
+                if (!src_regv->refcount && !(src_regv->flags & REG_FLAGS_REQUIRED))
                     add_to_dead_list(src_regv, IREG_GET_REG(uop->src_reg_b.reg), uop->src_reg_b.version);
             }
             if (uop->src_reg_c.reg != IREG_INVALID) {
                 reg_version_t *src_regv = &reg_version[IREG_GET_REG(uop->src_reg_c.reg)][uop->src_reg_c.version];
                 src_regv->refcount--;
-                if (!src_regv->refcount)
+                if (!src_regv->refcount && !(src_regv->flags & REG_FLAGS_REQUIRED))
                     add_to_dead_list(src_regv, IREG_GET_REG(uop->src_reg_c.reg), uop->src_reg_c.version);
             }
             regv->flags |= REG_FLAGS_DEAD;
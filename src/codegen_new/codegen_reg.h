@@ -278,8 +278,6 @@ ireg_seg_limit_high(x86seg *seg)
     return 0;
 }
 
-extern uint8_t reg_last_version[IREG_COUNT];
-
 /*This version of the register must be calculated, regardless of whether it is
   apparently required or not. Do not optimise out.*/
 #define REG_FLAGS_REQUIRED (1 << 0)
@@ -297,11 +295,23 @@ typedef struct {
     uint16_t next;
 } reg_version_t;
 
-extern reg_version_t reg_version[IREG_COUNT][256];
+/*Register version state of one block. The CPU thread fills this in while
+  translating a block, and when background compilation is enabled hands it to
+  the compiler thread along with the IR. Each thread accesses the state of the
+  block it is working on through codegen_reg_state*/
+typedef struct codegen_reg_state_t {
+    reg_version_t version[IREG_COUNT][256];
+    uint8_t       last_version[IREG_COUNT];
+    /*Head of dead register list; a list of register versions that are not used
+      and can be optimised out*/
+    uint16_t dead_list;
+} codegen_reg_state_t;
+
+extern __thread codegen_reg_state_t *codegen_reg_state;
 
-/*Head of dead register list; a list of register versions that are not used and
-  can be optimised out*/
-extern uint16_t reg_dead_list;
+#define reg_version      (codegen_reg_state->version)
+#define reg_last_version (codegen_reg_state->last_version)
+#define reg_dead_list    (codegen_reg_state->dead_list)
 
 static inline void
 add_to_dead_list(reg_version_t *regv, int reg, int version)
@@ -355,6 +365,9 @@ codegen_reg_read(int reg)
 }
 
 int reg_is_native_size(ir_reg_t ir_reg);
+int codegen_reg_is_permanent(int reg);
+/*Width in bits of an integer register, or 0 if it is not held as an integer*/
+int codegen_reg_native_width(int reg);
 
 static inline ir_reg_t
 codegen_reg_write(int reg, int uop_nr)
@@ -404,11 +417,25 @@ ir_reg_is_invalid(ir_reg_t ir_reg)
 
 struct ir_data_t;
 
+/*Reset register versions, at the start of translating a block*/
 void codegen_reg_reset(void);
+/*Reset host register allocation, at the start of code generation*/
+void codegen_reg_reset_host_regs(void);
 /*Write back all dirty registers*/
 void codegen_reg_flush(struct ir_data_t *ir, codeblock_t *block);
 /*Write back and evict all registers*/
 void codegen_reg_flush_invalidate(struct ir_data_t *ir, codeblock_t *block);
+#ifdef CODEGEN_BACKEND_HAS_EXIT_WRITEBACK
+/*Write back and evict registers held in volatile host registers*/
+void codegen_reg_flush_volatile(struct ir_data_t *ir, codeblock_t *block);
+/*Write back any dirty host register holding a version of ir_reg*/
+void codegen_reg_flush_reg(codeblock_t *block, ir_reg_t ir_reg);
+/*Returns non-zero if codegen_reg_writeback_exit() would write anything back*/
+int  codegen_reg_exit_dirty(ir_reg_t skip);
+/*Write back all dirty registers other than skip, on a path that exits the
+  block. Register state is left unchanged for the path that continues*/
+void codegen_reg_writeback_exit(codeblock_t *block, ir_reg_t skip);
+#endif
 
 /*Register ir_reg usage for this uOP. This ensures that required registers aren't evicted*/
 void codegen_reg_alloc_register(ir_reg_t dest_reg_a, ir_reg_t src_reg_a, ir_reg_t src_reg_b, ir_reg_t src_reg_c);
@@ -0,0 +1,134 @@
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <86box/86box.h>
+#include "cpu.h"
+#include <86box/mem.h>
+#include "codegen_public.h"
+
+#include "codegen.h"
+#include "codegen_stats.h"
+
+codegen_stats_t codegen_stats;
+int             codegen_stats_enabled      = 0;
+int             codegen_stats_log_interval = 0;
+
+/*One bit per hash of (phys, CS base), set when a block is compiled, so that
+  compiling the same code again (after eviction, invalidation or a change of
+  FPU top-of-stack) can be counted. Collisions make this an upper bound.*/
+#define COMPILED_MAP_BITS 20
+static uint8_t *compiled_map;
+
+static codegen_stats_t log_last;
+static int             log_seconds;
+
+void
+codegen_stats_block_compiled(codeblock_t *block)
+{
+    uint32_t hash = ((block->phys ^ (block->_cs << 4)) * 0x9e3779b1) >> (32 - COMPILED_MAP_BITS);
+
+    codegen_stats.blocks_compiled++;
+    if (!compiled_map)
+        return;
+    if (compiled_map[hash >> 3] & (1 << (hash & 7)))
+        codegen_stats.blocks_recompiled++;
+    else
+        compiled_map[hash >> 3] |= (1 << (hash & 7));
+}
+
+void
+codegen_stats_reset(void)
+{
+    memset(&codegen_stats, 0, sizeof(codegen_stats));
+    memset(&log_last, 0, sizeof(log_last));
+    if (compiled_map)
+        memset(compiled_map, 0, 1 << (COMPILED_MAP_BITS - 3));
+    log_seconds = 0;
+}
+
+void
+codegen_stats_enable(int enable)
+{
+    if (enable && !compiled_map)
+        compiled_map = calloc(1, 1 << (COMPILED_MAP_BITS - 3));
+
+    codegen_stats_enabled = enable;
+}
+
+static int
+fallback_compare(const void *a, const void *b)
+{
+    uint32_t count_a = codegen_stats.fallback[*(const uint16_t *) a];
+    uint32_t count_b = codegen_stats.fallback[*(const uint16_t *) b];
+
+    if (count_a != count_b)
+        return (count_a < count_b) ? 1 : -1;
+    return *(const uint16_t *) a - *(const uint16_t *) b;
+}
+
+void
+codegen_stats_print(FILE *fp, int top_fallbacks)
+{
+    uint64_t total_ns = codegen_stats.compile_ns + codegen_stats.execute_ns;
+    uint16_t *sorted;
+    int       nr_sorted = 0;
+
+    fprintf(fp, "Dynarec statistics (collection %s):\n", codegen_stats_enabled ? "enabled" : "disabled");
+    fprintf(fp, "  Blocks compiled:   %" PRIu64 " (%" PRIu64 " recompiled)\n", codegen_stats.blocks_compiled, codegen_stats.blocks_recompiled);
+    fprintf(fp, "  Blocks evicted:    %" PRIu64 "\n", codegen_stats.blocks_evicted);
+    fprintf(fp, "  Blocks flushed:    %" PRIu64 "\n", codegen_stats.blocks_flushed);
+    fprintf(fp, "  Block pool:        %i blocks\n", codegen_block_count);
+    fprintf(fp, "  Host time:         %.3f s compiling, %.3f s executing (%.1f%% compiling)\n",
+            codegen_stats.compile_ns / 1000000000.0, codegen_stats.execute_ns / 1000000000.0,
+            total_ns ? ((codegen_stats.compile_ns * 100.0) / total_ns) : 0.0);
+
+    if (top_fallbacks <= 0)
+        return;
+
+    sorted = malloc(0x10000 * sizeof(uint16_t));
+    if (!sorted)
+        return;
+    for (uint32_t c = 0; c < 0x10000; c++) {
+        if (codegen_stats.fallback[c])
+            sorted[nr_sorted++] = c;
+    }
+    qsort(sorted, nr_sorted, sizeof(uint16_t), fallback_compare);
+
+    fprintf(fp, "  Interpreter fallbacks (%i opcodes):\n", nr_sorted);
+    for (int c = 0; (c < nr_sorted) && (c < top_fallbacks); c++) {
+        if (sorted[c] & 0xff00)
+            fprintf(fp, "    %02X %02X  %" PRIu32 "\n", sorted[c] >> 8, sorted[c] & 0xff, codegen_stats.fallback[sorted[c]]);
+        else
+            fprintf(fp, "    %02X     %" PRIu32 "\n", sorted[c], codegen_stats.fallback[sorted[c]]);
+    }
+
+    free(sorted);
+}
+
+void
+codegen_stats_onesec(void)
+{
+    if (!codegen_stats_enabled || (codegen_stats_log_interval <= 0))
+        return;
+    if (++log_seconds < codegen_stats_log_interval)
+        return;
+    log_seconds = 0;
+
+    pclog("Dynarec: %" PRIu64 " compiled (%" PRIu64 " recompiled), %" PRIu64 " evicted, %" PRIu64 " flushed, %.1f ms compiling, %.1f ms executing in %i s\n",
+          codegen_stats.blocks_compiled - log_last.blocks_compiled,
+          codegen_stats.blocks_recompiled - log_last.blocks_recompiled,
+          codegen_stats.blocks_evicted - log_last.blocks_evicted,
+          codegen_stats.blocks_flushed - log_last.blocks_flushed,
+          (codegen_stats.compile_ns - log_last.compile_ns) / 1000000.0,
+          (codegen_stats.execute_ns - log_last.execute_ns) / 1000000.0,
+          codegen_stats_log_interval);
+
+    log_last.blocks_compiled   = codegen_stats.blocks_compiled;
+    log_last.blocks_recompiled = codegen_stats.blocks_recompiled;
+    log_last.blocks_evicted    = codegen_stats.blocks_evicted;
+    log_last.blocks_flushed    = codegen_stats.blocks_flushed;
+    log_last.compile_ns        = codegen_stats.compile_ns;
+    log_last.execute_ns        = codegen_stats.execute_ns;
+}
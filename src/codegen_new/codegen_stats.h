@@ -0,0 +1,28 @@
+#ifndef _CODEGEN_STATS_H_
+#define _CODEGEN_STATS_H_
+
+/*Dynarec statistics. Counters are only updated while codegen_stats_enabled is
+  set, so the cost when disabled is a single test at each collection point.
+
+  The fallback histogram is indexed by opcode, with the prefix or escape byte
+  that selected the opcode table (0x0f, 0xd8-0xdf, 0xf2, 0xf3) in the high
+  byte. FPU escapes are indexed by ModR/M byte. It counts instructions compiled
+  as calls to the interpreter, not how often those calls are executed.*/
+typedef struct codegen_stats_t {
+    uint64_t blocks_compiled;
+    uint64_t blocks_recompiled;
+    uint64_t blocks_evicted;
+    uint64_t blocks_flushed;
+    uint64_t compile_ns;
+    uint64_t execute_ns;
+    uint32_t fallback[0x10000];
+} codegen_stats_t;
+
+extern codegen_stats_t codegen_stats;
+extern int             codegen_stats_enabled;
+
+/*Count a block that has just been compiled, and whether the same code has
+  been compiled before*/
+extern void codegen_stats_block_compiled(codeblock_t *block);
+
+#endif
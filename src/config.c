@@ -40,6 +40,7 @@
 #include "cpu.h"
 #include <86box/device.h>
 #include <86box/timer.h>
+#include <86box/pace.h>
 #include <86box/cassette.h>
 #include <86box/cartridge.h>
 #include <86box/nvr.h>
@@ -213,6 +214,23 @@ load_general(void)
 
     do_auto_pause = ini_section_get_int(cat, "do_auto_pause", 0);
 
+    dynarec_blocks     = ini_section_get_int(cat, "dynarec_blocks", 0);
+    dynarec_mem_blocks = ini_section_get_int(cat, "dynarec_mem_blocks", 0);
+    dynarec_perf_map   = ini_section_get_int(cat, "dynarec_perf_map", 0);
+
+    dynarec_async_compile = !!ini_section_get_int(cat, "dynarec_async_compile", 0);
+
+    mem_huge_pages  = ini_section_get_int(cat, "mem_huge_pages", 0);
+    mem_merge_pages = ini_section_get_int(cat, "mem_merge_pages", 0);
+    rom_share       = !!ini_section_get_int(cat, "rom_share", 0);
+    cpu_idle_skip   = !!ini_section_get_int(cat, "cpu_idle_skip", 1);
+
+    pace_slice_ms = ini_section_get_int(cat, "pace_slice_ms", 10);
+    if (pace_slice_ms < PACE_SLICE_MIN)
+        pace_slice_ms = PACE_SLICE_MIN;
+    else if (pace_slice_ms > PACE_SLICE_MAX)
+        pace_slice_ms = PACE_SLICE_MAX;
+
     p = ini_section_get_string(cat, "uuid", NULL);
     if (p != NULL)
         strncpy(uuid, p, sizeof(uuid) - 1);
@@ -2084,6 +2102,51 @@ save_general(void)
     else
         ini_section_delete_var(cat, "do_auto_pause");
 
+    if (dynarec_blocks)
+        ini_section_set_int(cat, "dynarec_blocks", dynarec_blocks);
+    else
+        ini_section_delete_var(cat, "dynarec_blocks");
+
+    if (dynarec_mem_blocks)
+        ini_section_set_int(cat, "dynarec_mem_blocks", dynarec_mem_blocks);
+    else
+        ini_section_delete_var(cat, "dynarec_mem_blocks");
+
+    if (dynarec_perf_map)
+        ini_section_set_int(cat, "dynarec_perf_map", dynarec_perf_map);
+    else
+        ini_section_delete_var(cat, "dynarec_perf_map");
+
+    if (dynarec_async_compile)
+        ini_section_set_int(cat, "dynarec_async_compile", dynarec_async_compile);
+    else
+        ini_section_delete_var(cat, "dynarec_async_compile");
+
+    if (mem_huge_pages)
+        ini_section_set_int(cat, "mem_huge_pages", mem_huge_pages);
+    else
+        ini_section_delete_var(cat, "mem_huge_pages");
+
+    if (mem_merge_pages)
+        ini_section_set_int(cat, "mem_merge_pages", mem_merge_pages);
+    else
+        ini_section_delete_var(cat, "mem_merge_pages");
+
+    if (rom_share)
+        ini_section_set_int(cat, "rom_share", rom_share);
+    else
+        ini_section_delete_var(cat, "rom_share");
+
+    if (cpu_idle_skip)
+        ini_section_delete_var(cat, "cpu_idle_skip");
+    else
+        ini_section_set_int(cat, "cpu_idle_skip", cpu_idle_skip);
+
+    if (pace_slice_ms == 10)
+        ini_section_delete_var(cat, "pace_slice_ms");
+    else
+        ini_section_set_int(cat, "pace_slice_ms", pace_slice_ms);
+
     char cpu_buf[128] = { 0 };
     plat_get_cpu_string(cpu_buf, 128);
     ini_section_set_string(cat, "host_cpu", cpu_buf);
@@ -16,6 +16,7 @@
 #include "x86seg_common.h"
 #include "x87_sf.h"
 #include "x87.h"
+#include <86box/io.h>
 #include <86box/nmi.h>
 #include <86box/mem.h>
 #include <86box/smram.h>
@@ -29,6 +30,7 @@
 #include "x86seg.h"
 #include "386_common.h"
 #include "x86_flags.h"
+#include <86box/plat.h>
 #include <86box/plat_unused.h>
 
 #ifdef USE_DYNAREC
@@ -207,6 +209,8 @@ uint32_t addr64a_2[8];
 static pc_timer_t *cpu_fast_off_timer  = NULL;
 static double      cpu_fast_off_period = 0.0;
 
+cpu_idle_stats_t cpu_idle_stats;
+
 #define AMD_SYSCALL_EIP (msr.amd_star & 0xFFFFFFFF)
 #define AMD_SYSCALL_SB  ((msr.amd_star >> 32) & 0xFFFF)
 #define AMD_SYSRET_SB   ((msr.amd_star >> 48) & 0xFFFF)
@@ -1322,8 +1326,7 @@ enter_smm(int in_hlt)
 
     flags_rebuild();
     in_smm = 1;
-    smram_backup_all();
-    smram_recalc_all(0);
+    mem_smm_switch();
 
     if (is_cxsmm) {
         if (!(cyrix.smhr & SMHR_VALID))
@@ -1544,7 +1547,7 @@ leave_smm(void)
         smram_restore_state_p6(saved_state);
 
     in_smm = 0;
-    smram_recalc_all(1);
+    mem_smm_switch();
 
     cpu_386_flags_extract();
     cpu_cur_status &= ~(CPU_STATUS_PMODE | CPU_STATUS_V86);
@@ -1890,6 +1893,254 @@ cpu_386_check_instruction_fault(void)
     return fault;
 }
 
+/*Number of whole elements at seg:addr that can be accessed in bulk, without
+  leaving the current page, the segment limits or (for 16-bit addressing) the
+  64k offset range*/
+static uint32_t
+rep_bulk_span(x86seg *seg, uint32_t addr, int size, int a32)
+{
+    uint32_t lin = seg->base + addr;
+    uint32_t n   = (0x1000 - (lin & 0xfff)) / size;
+
+    if ((seg->base == 0xffffffff) || (addr < seg->limit_low) || (addr > seg->limit_high))
+        return 0;
+    if ((msw & 1) && !(cpu_state.eflags & VM_FLAG) && !(seg->access & 0x80))
+        return 0;
+
+    n = MIN(n, ((uint64_t) seg->limit_high - addr + 1) / size);
+    if (!a32)
+        n = MIN(n, (0x10000 - addr) / size);
+
+    return n;
+}
+
+static __inline uint32_t
+rep_bulk_count(void)
+{
+    return (cpu_state.op32 & 0x200) ? ECX : CX;
+}
+
+static __inline void
+rep_bulk_advance(uint32_t n, uint32_t bytes, int src, int dst)
+{
+    if (cpu_state.op32 & 0x200) {
+        ECX -= n;
+        if (src)
+            ESI += bytes;
+        if (dst)
+            EDI += bytes;
+    } else {
+        CX -= n;
+        if (src)
+            SI += bytes;
+        if (dst)
+            DI += bytes;
+    }
+}
+
+/*Host pointer for a bulk write to linear address lin, or NULL if the page is
+  not mapped as RAM. page is set for pages holding recompiled code, which
+  need their dirty masks updating afterwards*/
+static uint8_t *
+rep_bulk_write_ptr(uint32_t lin, page_t **page)
+{
+    *page = NULL;
+    if (writelookup2[lin >> 12] != (uintptr_t) LOOKUP_INV)
+        return (uint8_t *) (writelookup2[lin >> 12] + (uintptr_t) lin);
+
+#ifdef USE_DYNAREC
+    if (codegen_in_recompile)
+        return NULL;
+#endif
+    *page = page_lookup[lin >> 12];
+    if (!*page || !(*page)->mem || ((*page)->mem == page_ff) || ((*page)->write_b != mem_write_ramb_page))
+        return NULL;
+
+    return &(*page)->mem[lin & 0xfff];
+}
+
+/*Elements that can be done before cycles drops below cycles_end, as the
+  element loops check after each element*/
+static __inline uint32_t
+rep_bulk_cycle_limit(int cycles_per, int cycles_end)
+{
+    return ((uint32_t) (cycles - cycles_end) / cycles_per) + 1;
+}
+
+/*Bulk REP MOVS. Copies runs of elements between RAM pages that are in the
+  read and write lookup tables, so have already been translated, one page
+  at a time. Stops at anything else - unmapped pages, MMIO, elements
+  straddling pages, segment limits - and leaves the rest to the element
+  loop, which also raises any faults. Only handles DF=0, and does nothing
+  when single stepping or with data breakpoints enabled. Returns the number
+  of elements done*/
+uint32_t
+x86_rep_movs_bulk(int size, int cycles_per, int cycles_end)
+{
+    uint32_t count = rep_bulk_count();
+    uint32_t done  = 0;
+    int      a32   = cpu_state.op32 & 0x200;
+
+    if ((cpu_state.flags & D_FLAG) || trap || (dr[7] & 0xff))
+        return 0;
+
+    while (count && (cycles >= cycles_end)) {
+        uint32_t src     = a32 ? ESI : SI;
+        uint32_t dst     = a32 ? EDI : DI;
+        uint32_t lin_src = cpu_state.ea_seg->base + src;
+        uint32_t lin_dst = es + dst;
+        uint32_t n;
+        uint32_t bytes;
+        page_t  *page;
+        uint8_t *s;
+        uint8_t *d;
+
+        n = MIN(count, rep_bulk_span(cpu_state.ea_seg, src, size, a32));
+        n = MIN(n, rep_bulk_span(&cpu_state.seg_es, dst, size, a32));
+        n = MIN(n, rep_bulk_cycle_limit(cycles_per, cycles_end));
+        if (!n || (readlookup2[lin_src >> 12] == (uintptr_t) LOOKUP_INV))
+            break;
+        d = rep_bulk_write_ptr(lin_dst, &page);
+        if (!d)
+            break;
+
+        s     = (uint8_t *) (readlookup2[lin_src >> 12] + (uintptr_t) lin_src);
+        bytes = n * size;
+        if (page && !memcmp(d, s, bytes))
+            page = NULL; /*Nothing will change*/
+        if ((d > s) && (d < (s + bytes))) {
+            /*Overlapping forward copy, where each element reads what earlier
+              ones wrote*/
+            for (uint32_t c = 0; c < bytes; c += size)
+                memmove(d + c, s + c, size);
+        } else
+            memmove(d, s, bytes);
+        if (page)
+            mem_write_ram_page_dirty(lin_dst, bytes, page);
+
+        rep_bulk_advance(n, bytes, 1, 1);
+        count -= n;
+        done += n;
+        cycles -= n * cycles_per;
+    }
+
+    return done;
+}
+
+/*Bulk REP STOS, with the same restrictions as x86_rep_movs_bulk()*/
+uint32_t
+x86_rep_stos_bulk(int size, int cycles_per, int cycles_end)
+{
+    uint32_t count = rep_bulk_count();
+    uint32_t done  = 0;
+    int      a32   = cpu_state.op32 & 0x200;
+    uint32_t val   = EAX;
+
+    if ((cpu_state.flags & D_FLAG) || trap || (dr[7] & 0xff))
+        return 0;
+
+    while (count && (cycles >= cycles_end)) {
+        uint32_t dst     = a32 ? EDI : DI;
+        uint32_t lin_dst = es + dst;
+        uint32_t n;
+        uint32_t bytes;
+        page_t  *page;
+        uint8_t *d;
+        int      changed = 0;
+
+        n = MIN(count, rep_bulk_span(&cpu_state.seg_es, dst, size, a32));
+        n = MIN(n, rep_bulk_cycle_limit(cycles_per, cycles_end));
+        if (!n)
+            break;
+        d = rep_bulk_write_ptr(lin_dst, &page);
+        if (!d)
+            break;
+
+        bytes = n * size;
+        for (uint32_t c = 0; c < bytes; c += size) {
+            if (page && !changed)
+                changed = memcmp(d + c, &val, size);
+            memcpy(d + c, &val, size);
+        }
+        if (changed)
+            mem_write_ram_page_dirty(lin_dst, bytes, page);
+
+        rep_bulk_advance(n, bytes, 0, 1);
+        count -= n;
+        done += n;
+        cycles -= n * cycles_per;
+    }
+
+    return done;
+}
+
+/*REP INS/OUTS need the I/O permission bitmap checked, which the bulk paths
+  leave to the element code*/
+static __inline int
+rep_bulk_io_allowed(void)
+{
+    return !(msw & 1) || (!(cpu_state.eflags & VM_FLAG) && (CPL <= IOPL));
+}
+
+/*Bulk REP INSW, for ports with a block handler (see io_handler_block()).
+  Does one run within the destination page, as the handler may stop early
+  anyway. Returns the number of words done*/
+uint32_t
+x86_rep_insw_bulk(int cycles_per, int cycles_end)
+{
+    int      a32     = cpu_state.op32 & 0x200;
+    uint32_t dst     = a32 ? EDI : DI;
+    uint32_t lin_dst = es + dst;
+    uint32_t n;
+    page_t  *page;
+    uint8_t *d;
+
+    if ((cpu_state.flags & D_FLAG) || trap || (dr[7] & 0xff) || !rep_bulk_io_allowed() || (cycles < cycles_end))
+        return 0;
+
+    n = MIN(rep_bulk_count(), rep_bulk_span(&cpu_state.seg_es, dst, 2, a32));
+    n = MIN(n, rep_bulk_cycle_limit(cycles_per, cycles_end));
+    if (!n)
+        return 0;
+    d = rep_bulk_write_ptr(lin_dst, &page);
+    if (!d)
+        return 0;
+
+    n = insw_block(DX, d, n);
+    if (n && page)
+        mem_write_ram_page_dirty(lin_dst, n << 1, page);
+
+    rep_bulk_advance(n, n << 1, 0, 1);
+    cycles -= n * cycles_per;
+
+    return n;
+}
+
+/*Bulk REP OUTSW, as x86_rep_insw_bulk()*/
+uint32_t
+x86_rep_outsw_bulk(int cycles_per, int cycles_end)
+{
+    int      a32     = cpu_state.op32 & 0x200;
+    uint32_t src     = a32 ? ESI : SI;
+    uint32_t lin_src = cpu_state.ea_seg->base + src;
+    uint32_t n;
+
+    if ((cpu_state.flags & D_FLAG) || trap || (dr[7] & 0xff) || !rep_bulk_io_allowed() || (cycles < cycles_end))
+        return 0;
+
+    n = MIN(rep_bulk_count(), rep_bulk_span(cpu_state.ea_seg, src, 2, a32));
+    n = MIN(n, rep_bulk_cycle_limit(cycles_per, cycles_end));
+    if (!n || (readlookup2[lin_src >> 12] == (uintptr_t) LOOKUP_INV))
+        return 0;
+
+    n = outsw_block(DX, (uint8_t *) (readlookup2[lin_src >> 12] + (uintptr_t) lin_src), n);
+
+    rep_bulk_advance(n, n << 1, 1, 0);
+    cycles -= n * cycles_per;
+
+    return n;
+}
+
 int
 sysenter(UNUSED(uint32_t fetchdat))
 {
@@ -2201,6 +2452,50 @@ cpu_fast_off_reset(void)
     cpu_fast_off_advance();
 }
 
+/* Guest cycles an idle CPU can skip, up to the next timer event as nothing
+   emulated can raise an interrupt before then. The skip is capped at 1 ms so
+   interrupts from host threads are still taken promptly. */
+int
+cpu_idle(int acpi)
+{
+    int32_t skip = (int32_t) (timer_target - (uint32_t) tsc);
+    int32_t max  = cpu_s->rspeed / 1000;
+
+    if (!cpu_idle_skip || (skip <= 0))
+        return 0;
+    if (skip > max)
+        skip = max;
+
+    if (acpi)
+        cpu_idle_stats.acpi++;
+    else
+        cpu_idle_stats.hlt++;
+    cpu_idle_stats.skipped += skip;
+
+    return skip;
+}
+
+/* Called once a second to update the idle and host CPU use figures. */
+void
+cpu_idle_onesec(void)
+{
+    static uint64_t last_wall    = 0;
+    static uint64_t last_host    = 0;
+    static uint64_t last_skipped = 0;
+    uint64_t        wall         = plat_timer_read_ns();
+    uint64_t        host         = plat_cpu_time_ns();
+    uint64_t        skipped      = cpu_idle_stats.skipped;
+
+    if (last_wall && (wall > last_wall) && (host >= last_host))
+        cpu_idle_stats.host_pct = ((host - last_host) * 1000) / (wall - last_wall);
+    if (cpu_s && (skipped >= last_skipped))
+        cpu_idle_stats.idle_pct = MIN(((skipped - last_skipped) * 1000) / cpu_s->rspeed, 1000);
+
+    last_wall    = wall;
+    last_host    = host;
+    last_skipped = skipped;
+}
+
 void
 smi_raise(void)
 {
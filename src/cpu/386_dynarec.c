@@ -29,13 +29,16 @@
 #include <86box/fdd.h>
 #include <86box/fdc.h>
 #include <86box/machine.h>
+#include <86box/plat.h>
 #include <86box/plat_fallthrough.h>
 #include <86box/plat_unused.h>
 #include <86box/gdbstub.h>
 #ifdef USE_DYNAREC
 #    include "codegen.h"
 #    ifdef USE_NEW_DYNAREC
+#        include "codegen_async.h"
 #        include "codegen_backend.h"
+#        include "codegen_stats.h"
 #    endif
 #endif
 
@@ -388,6 +391,17 @@ exec386_dynarec_dyn(void)
     codeblock_t *block = codeblock_hash[hash];
 #    endif
     int valid_block = 0;
+#    ifdef USE_NEW_DYNAREC
+    int      chain_link  = codegen_chain_exit;
+    uint64_t stats_start = 0;
+
+    codegen_chain_exit = -1;
+
+    if (cpu_state.trace_exit_data)
+        codegen_trace_count_exit();
+    if (codegen_async_done)
+        codegen_async_poll();
+#    endif
 
 #    ifdef USE_NEW_DYNAREC
     if (!cpu_state.abrt)
@@ -507,6 +521,17 @@ exec386_dynarec_dyn(void)
 
 #    ifndef USE_NEW_DYNAREC
         codeblock_hash[hash] = block;
+#    else
+        block->flags |= CODEBLOCK_REFERENCED;
+
+        /* Patch the exit of the previous block to jump straight here next
+           time, and let chained blocks run until the next timer is due. */
+        if (chain_link != -1)
+            codegen_block_link(chain_link, block);
+        codegen_chain_set_limit();
+
+        if (codegen_stats_enabled)
+            stats_start = plat_timer_read_ns();
 #    endif
         inrecomp = 1;
         code();
@@ -514,15 +539,28 @@ exec386_dynarec_dyn(void)
         acycs = 0;
 #    endif
         inrecomp = 0;
+#    ifdef USE_NEW_DYNAREC
+        if (stats_start)
+            codegen_stats.execute_ns += plat_timer_read_ns() - stats_start;
+#    endif
 
 #    ifndef USE_NEW_DYNAREC
         if (!use32)
             cpu_state.pc &= 0xffff;
 #    endif
-    } else if (valid_block && !cpu_state.abrt) {
+    }
+#    ifdef USE_NEW_DYNAREC
+    else if (valid_block && !cpu_state.abrt && !(block->flags & CODEBLOCK_COMPILE_PENDING))
+#    else
+    else if (valid_block && !cpu_state.abrt)
+#    endif
+    {
 #    ifdef USE_NEW_DYNAREC
         start_pc                 = cs + cpu_state.pc;
         const int max_block_size = (block->flags & CODEBLOCK_BYTE_MASK) ? ((128 - 25) - (start_pc & 0x3f)) : 1000;
+
+        if (codegen_stats_enabled)
+            stats_start = plat_timer_read_ns();
 #    else
         start_pc = cpu_state.pc;
 #    endif
@@ -535,8 +573,8 @@ exec386_dynarec_dyn(void)
             pthread_jit_write_protect_np(0);
         }
 #    endif
-        codegen_block_start_recompile(block);
         codegen_in_recompile = 1;
+        codegen_block_start_recompile(block);
 
         while (!cpu_block_end) {
 #    ifndef USE_NEW_DYNAREC
@@ -567,6 +605,16 @@ exec386_dynarec_dyn(void)
 
                 if (x86_was_reset)
                     break;
+
+#    ifdef USE_NEW_DYNAREC
+                /* The recompiler is following a taken branch as a trace, so
+                   carry on translating at its destination. */
+                if (codegen_trace_dest != BLOCK_PC_INVALID) {
+                    if ((cs + cpu_state.pc) == codegen_trace_dest)
+                        cpu_block_end = 0;
+                    codegen_trace_dest = BLOCK_PC_INVALID;
+                }
+#    endif
             }
 
 #    ifndef USE_NEW_DYNAREC
@@ -625,9 +673,15 @@ exec386_dynarec_dyn(void)
         if (__builtin_available(macOS 11.0, *)) {
             pthread_jit_write_protect_np(1);
         }
+#    endif
+#    ifdef USE_NEW_DYNAREC
+        if (stats_start)
+            codegen_stats.compile_ns += plat_timer_read_ns() - stats_start;
 #    endif
     } else if (!cpu_state.abrt) {
-        /* Mark block but do not recompile */
+        /* Mark block but do not recompile. A valid block here is waiting
+           for the background compiler, and is only interpreted */
+        const int mark = !valid_block;
 #    ifdef USE_NEW_DYNAREC
         start_pc                 = cs + cpu_state.pc;
         const int max_block_size = (block->flags & CODEBLOCK_BYTE_MASK) ? ((128 - 25) - (start_pc & 0x3f)) : 1000;
@@ -638,7 +692,8 @@ exec386_dynarec_dyn(void)
         cpu_block_end = 0;
         x86_was_reset = 0;
 
-        codegen_block_init(phys_addr);
+        if (mark)
+            codegen_block_init(phys_addr);
 
         while (!cpu_block_end) {
 #    ifndef USE_NEW_DYNAREC
@@ -708,7 +763,7 @@ exec386_dynarec_dyn(void)
             }
 
             if (cpu_state.abrt) {
-                if (!(cpu_state.abrt & ABRT_EXPECTED))
+                if (mark && !(cpu_state.abrt & ABRT_EXPECTED))
                     codegen_block_remove();
                 CPU_BLOCK_END();
             }
@@ -716,7 +771,7 @@ exec386_dynarec_dyn(void)
 
         cpu_end_block_after_ins = 0;
 
-        if ((!cpu_state.abrt || (cpu_state.abrt & ABRT_EXPECTED)) && !new_ne && !x86_was_reset)
+        if (mark && (!cpu_state.abrt || (cpu_state.abrt & ABRT_EXPECTED)) && !new_ne && !x86_was_reset)
             codegen_block_end();
 
         if (x86_was_reset)
@@ -56,4 +56,14 @@ extern void codegen_flush(void);
 extern uint32_t recomp_page;
 extern int      codegen_in_recompile;
 
+#ifdef USE_NEW_DYNAREC
+/* Dynarec statistics. */
+extern int  codegen_stats_enabled;
+extern int  codegen_stats_log_interval; /* seconds between log lines, 0 = disabled */
+extern void codegen_stats_enable(int enable);
+extern void codegen_stats_reset(void);
+extern void codegen_stats_print(FILE *fp, int top_fallbacks);
+extern void codegen_stats_onesec(void);
+#endif
+
 #endif
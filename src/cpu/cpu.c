@@ -4280,11 +4280,8 @@ cpu_write(uint16_t addr, uint8_t val, UNUSED(void *priv))
             if ((ccr3 & CCR3_SMI_LOCK) && !in_smm)
                 val = (val & ~(CCR1_USE_SMI | CCR1_SMAC | CCR1_SM3)) | (ccr1 & (CCR1_USE_SMI | CCR1_SMAC | CCR1_SM3));
             ccr1 = val;
-            if ((old ^ ccr1) & (CCR1_SMAC)) {
-                if (ccr1 & CCR1_SMAC)
-                    smram_backup_all();
-                smram_recalc_all(!(ccr1 & CCR1_SMAC));
-            }
+            if ((old ^ ccr1) & (CCR1_SMAC))
+                mem_smm_switch();
             break;
         } case 0xc2: /* CCR2 */
             ccr2 = val;
@@ -418,6 +418,12 @@ typedef struct {
     uint32_t _smbase;
 
     uint32_t x87_op;
+
+#ifdef USE_NEW_DYNAREC
+    /*Trace side exit taken by the last block, see codegen_trace_side_exit()*/
+    uint32_t trace_exit_data;
+    uint32_t trace_exit_phys;
+#endif
 } cpu_state_t;
 
 #define in_smm   cpu_state._in_smm
@@ -820,6 +826,19 @@ extern void cpu_fast_off_advance(void);
 extern void cpu_fast_off_period_set(uint16_t vla, double period);
 extern void cpu_fast_off_reset(void);
 
+typedef struct cpu_idle_stats_t {
+    uint64_t hlt;      /* HLTs skipped ahead */
+    uint64_t acpi;     /* ACPI C2/C3 entries skipped ahead */
+    uint64_t skipped;  /* guest cycles skipped */
+    uint32_t idle_pct; /* guest time skipped over the last second, in 0.1% */
+    uint32_t host_pct; /* host CPU time used over the last second, in 0.1% of a core */
+} cpu_idle_stats_t;
+
+extern cpu_idle_stats_t cpu_idle_stats;
+
+extern int  cpu_idle(int acpi);
+extern void cpu_idle_onesec(void);
+
 extern void smi_raise(void);
 extern void nmi_raise(void);
 
@@ -344,6 +344,7 @@ reset_common(int hard)
     in_smm = smi_latched = 0;
     smi_line = smm_in_hlt = 0;
     smi_block             = 0;
+    mem_smm_switch();
 
     if (hard) {
         if (is486)
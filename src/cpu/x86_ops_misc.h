@@ -710,7 +710,9 @@ opHLT(UNUSED(uint32_t fetchdat))
     if (smi_line)
         enter_smm_check(1);
     else if (!((cpu_state.flags & I_FLAG) && pic.int_pending)) {
-        CLOCK_CYCLES_ALWAYS(100);
+        /* Only an interrupt ends the HLT, so skip ahead to the next timer
+           event rather than spinning until then. */
+        CLOCK_CYCLES_ALWAYS((cpu_state.flags & I_FLAG) ? MAX(100, cpu_idle(0)) : 100);
         if (!((cpu_state.flags & I_FLAG) && pic.int_pending))
             cpu_state.pc--;
     } else {
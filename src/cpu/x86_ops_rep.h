@@ -44,6 +44,13 @@
                                                                                                                   \
         addr64a[0] = addr64a[1] = 0x00000000;                                                                     \
                                                                                                                   \
+        if (CNT_REG > 0) {                                                                                        \
+            uint32_t bulk = x86_rep_insw_bulk(15, cycles - ((is386 && cpu_use_dynarec) ? 1000 : 100));            \
+                                                                                                                  \
+            reads += bulk;                                                                                        \
+            writes += bulk;                                                                                       \
+            total_cycles += bulk * 15;                                                                            \
+        }                                                                                                         \
         if (CNT_REG > 0) {                                                                                        \
             uint16_t temp;                                                                                        \
                                                                                                                   \
@@ -152,6 +159,13 @@
     {                                                                                                             \
         int reads = 0, writes = 0, total_cycles = 0;                                                              \
                                                                                                                   \
+        if (CNT_REG > 0) {                                                                                        \
+            uint32_t bulk = x86_rep_outsw_bulk(14, cycles - ((is386 && cpu_use_dynarec) ? 1000 : 100));           \
+                                                                                                                  \
+            reads += bulk;                                                                                        \
+            writes += bulk;                                                                                       \
+            total_cycles += bulk * 14;                                                                            \
+        }                                                                                                         \
         if (CNT_REG > 0) {                                                                                        \
             uint16_t temp;                                                                                        \
             SEG_CHECK_READ(cpu_state.ea_seg);                                                                     \
@@ -224,6 +238,15 @@
         }                                                                                                         \
         while (CNT_REG > 0) {                                                                                     \
             uint8_t temp;                                                                                         \
+            uint32_t bulk = x86_rep_movs_bulk(1, is486 ? 3 : 4, cycles_end);                                      \
+                                                                                                                  \
+            if (bulk) {                                                                                           \
+                reads += bulk;                                                                                    \
+                writes += bulk;                                                                                   \
+                total_cycles += bulk * (is486 ? 3 : 4);                                                           \
+                if (!CNT_REG || (cycles < cycles_end))                                                            \
+                    break;                                                                                        \
+            }                                                                                                     \
                                                                                                                   \
             CHECK_READ_REP(cpu_state.ea_seg, SRC_REG, SRC_REG);                                                   \
             CHECK_WRITE_REP(&cpu_state.seg_es, DEST_REG, DEST_REG);                                               \
@@ -278,6 +301,15 @@
         }                                                                                                         \
         while (CNT_REG > 0) {                                                                                     \
             uint16_t temp;                                                                                        \
+            uint32_t bulk = x86_rep_movs_bulk(2, is486 ? 3 : 4, cycles_end);                                      \
+                                                                                                                  \
+            if (bulk) {                                                                                           \
+                reads += bulk;                                                                                    \
+                writes += bulk;                                                                                   \
+                total_cycles += bulk * (is486 ? 3 : 4);                                                           \
+                if (!CNT_REG || (cycles < cycles_end))                                                            \
+                    break;                                                                                        \
+            }                                                                                                     \
                                                                                                                   \
             CHECK_READ_REP(cpu_state.ea_seg, SRC_REG, SRC_REG + 1UL);                                             \
             CHECK_WRITE_REP(&cpu_state.seg_es, DEST_REG, DEST_REG + 1UL);                                         \
@@ -332,6 +364,15 @@
         }                                                                                                         \
         while (CNT_REG > 0) {                                                                                     \
             uint32_t temp;                                                                                        \
+            uint32_t bulk = x86_rep_movs_bulk(4, is486 ? 3 : 4, cycles_end);                                      \
+                                                                                                                  \
+            if (bulk) {                                                                                           \
+                reads += bulk;                                                                                    \
+                writes += bulk;                                                                                   \
+                total_cycles += bulk * (is486 ? 3 : 4);                                                           \
+                if (!CNT_REG || (cycles < cycles_end))                                                            \
+                    break;                                                                                        \
+            }                                                                                                     \
                                                                                                                   \
             CHECK_READ_REP(cpu_state.ea_seg, SRC_REG, SRC_REG + 3UL);                                             \
             CHECK_WRITE_REP(&cpu_state.seg_es, DEST_REG, DEST_REG + 3UL);                                         \
@@ -382,6 +423,15 @@
         if (CNT_REG > 0)                                                                                          \
             SEG_CHECK_WRITE(&cpu_state.seg_es);                                                                   \
         while (CNT_REG > 0) {                                                                                     \
+            uint32_t bulk = x86_rep_stos_bulk(1, is486 ? 4 : 5, cycles_end);                                      \
+                                                                                                                  \
+            if (bulk) {                                                                                           \
+                writes += bulk;                                                                                   \
+                total_cycles += bulk * (is486 ? 4 : 5);                                                           \
+                if (!CNT_REG || (cycles < cycles_end))                                                            \
+                    break;                                                                                        \
+            }                                                                                                     \
+                                                                                                                  \
             CHECK_WRITE_REP(&cpu_state.seg_es, DEST_REG, DEST_REG);                                               \
             writememb(es, DEST_REG, AL);                                                                          \
             if (cpu_state.abrt)                                                                                   \
@@ -414,6 +464,15 @@
         if (CNT_REG > 0)                                                                                          \
             SEG_CHECK_WRITE(&cpu_state.seg_es);                                                                   \
         while (CNT_REG > 0) {                                                                                     \
+            uint32_t bulk = x86_rep_stos_bulk(2, is486 ? 4 : 5, cycles_end);                                      \
+                                                                                                                  \
+            if (bulk) {                                                                                           \
+                writes += bulk;                                                                                   \
+                total_cycles += bulk * (is486 ? 4 : 5);                                                           \
+                if (!CNT_REG || (cycles < cycles_end))                                                            \
+                    break;                                                                                        \
+            }                                                                                                     \
+                                                                                                                  \
             CHECK_WRITE_REP(&cpu_state.seg_es, DEST_REG, DEST_REG + 1UL);                                         \
             writememw(es, DEST_REG, AX);                                                                          \
             if (cpu_state.abrt)                                                                                   \
@@ -446,6 +505,15 @@
         if (CNT_REG > 0)                                                                                          \
             SEG_CHECK_WRITE(&cpu_state.seg_es);                                                                   \
         while (CNT_REG > 0) {                                                                                     \
+            uint32_t bulk = x86_rep_stos_bulk(4, is486 ? 4 : 5, cycles_end);                                      \
+                                                                                                                  \
+            if (bulk) {                                                                                           \
+                writes += bulk;                                                                                   \
+                total_cycles += bulk * (is486 ? 4 : 5);                                                           \
+                if (!CNT_REG || (cycles < cycles_end))                                                            \
+                    break;                                                                                        \
+            }                                                                                                     \
+                                                                                                                  \
             CHECK_WRITE_REP(&cpu_state.seg_es, DEST_REG, DEST_REG + 3UL);                                         \
             writememl(es, DEST_REG, EAX);                                                                         \
             if (cpu_state.abrt)                                                                                   \
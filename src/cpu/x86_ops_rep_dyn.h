@@ -36,6 +36,8 @@
     {                                                                                                             \
         addr64a[0] = addr64a[1] = 0x00000000;                                                                     \
                                                                                                                   \
+        if (CNT_REG > 0)                                                                                          \
+            x86_rep_insw_bulk(15, cycles - ((is386 && cpu_use_dynarec) ? 1000 : 100));                            \
         if (CNT_REG > 0) {                                                                                        \
             uint16_t temp;                                                                                        \
                                                                                                                   \
@@ -126,6 +128,8 @@
     }                                                                                                             \
     static int opREP_OUTSW_##size(UNUSED(uint32_t fetchdat))                                                      \
     {                                                                                                             \
+        if (CNT_REG > 0)                                                                                          \
+            x86_rep_outsw_bulk(14, cycles - ((is386 && cpu_use_dynarec) ? 1000 : 100));                           \
         if (CNT_REG > 0) {                                                                                        \
             uint16_t temp;                                                                                        \
             SEG_CHECK_READ(cpu_state.ea_seg);                                                                     \
@@ -187,6 +191,12 @@
         }                                                                                                         \
         while (CNT_REG > 0) {                                                                                     \
             uint8_t temp;                                                                                         \
+            uint32_t bulk = x86_rep_movs_bulk(1, is486 ? 3 : 4, cycles_end);                                      \
+                                                                                                                  \
+            if (bulk) {                                                                                           \
+                if (!CNT_REG || (cycles < cycles_end))                                                            \
+                    break;                                                                                        \
+            }                                                                                                     \
                                                                                                                   \
             CHECK_READ_REP(cpu_state.ea_seg, SRC_REG, SRC_REG);                                                   \
             CHECK_WRITE_REP(&cpu_state.seg_es, DEST_REG, DEST_REG);                                               \
@@ -236,6 +246,12 @@
         }                                                                                                         \
         while (CNT_REG > 0) {                                                                                     \
             uint16_t temp;                                                                                        \
+            uint32_t bulk = x86_rep_movs_bulk(2, is486 ? 3 : 4, cycles_end);                                      \
+                                                                                                                  \
+            if (bulk) {                                                                                           \
+                if (!CNT_REG || (cycles < cycles_end))                                                            \
+                    break;                                                                                        \
+            }                                                                                                     \
                                                                                                                   \
             CHECK_READ_REP(cpu_state.ea_seg, SRC_REG, SRC_REG + 1UL);                                             \
             CHECK_WRITE_REP(&cpu_state.seg_es, DEST_REG, DEST_REG + 1UL);                                         \
@@ -285,6 +301,12 @@
         }                                                                                                         \
         while (CNT_REG > 0) {                                                                                     \
             uint32_t temp;                                                                                        \
+            uint32_t bulk = x86_rep_movs_bulk(4, is486 ? 3 : 4, cycles_end);                                      \
+                                                                                                                  \
+            if (bulk) {                                                                                           \
+                if (!CNT_REG || (cycles < cycles_end))                                                            \
+                    break;                                                                                        \
+            }                                                                                                     \
                                                                                                                   \
             CHECK_READ_REP(cpu_state.ea_seg, SRC_REG, SRC_REG + 3UL);                                             \
             CHECK_WRITE_REP(&cpu_state.seg_es, DEST_REG, DEST_REG + 3UL);                                         \
@@ -330,6 +352,13 @@
         if (CNT_REG > 0)                                                                                          \
             SEG_CHECK_WRITE(&cpu_state.seg_es);                                                                   \
         while (CNT_REG > 0) {                                                                                     \
+            uint32_t bulk = x86_rep_stos_bulk(1, is486 ? 4 : 5, cycles_end);                                      \
+                                                                                                                  \
+            if (bulk) {                                                                                           \
+                if (!CNT_REG || (cycles < cycles_end))                                                            \
+                    break;                                                                                        \
+            }                                                                                                     \
+                                                                                                                  \
             CHECK_WRITE_REP(&cpu_state.seg_es, DEST_REG, DEST_REG);                                               \
             writememb(es, DEST_REG, AL);                                                                          \
             if (cpu_state.abrt)                                                                                   \
@@ -358,6 +387,13 @@
         if (CNT_REG > 0)                                                                                          \
             SEG_CHECK_WRITE(&cpu_state.seg_es);                                                                   \
         while (CNT_REG > 0) {                                                                                     \
+            uint32_t bulk = x86_rep_stos_bulk(2, is486 ? 4 : 5, cycles_end);                                      \
+                                                                                                                  \
+            if (bulk) {                                                                                           \
+                if (!CNT_REG || (cycles < cycles_end))                                                            \
+                    break;                                                                                        \
+            }                                                                                                     \
+                                                                                                                  \
             CHECK_WRITE_REP(&cpu_state.seg_es, DEST_REG, DEST_REG + 1UL);                                         \
             writememw(es, DEST_REG, AX);                                                                          \
             if (cpu_state.abrt)                                                                                   \
@@ -386,6 +422,13 @@
         if (CNT_REG > 0)                                                                                          \
             SEG_CHECK_WRITE(&cpu_state.seg_es);                                                                   \
         while (CNT_REG > 0) {                                                                                     \
+            uint32_t bulk = x86_rep_stos_bulk(4, is486 ? 4 : 5, cycles_end);                                      \
+                                                                                                                  \
+            if (bulk) {                                                                                           \
+                if (!CNT_REG || (cycles < cycles_end))                                                            \
+                    break;                                                                                        \
+            }                                                                                                     \
+                                                                                                                  \
             CHECK_WRITE_REP(&cpu_state.seg_es, DEST_REG, DEST_REG + 3UL);                                         \
             writememl(es, DEST_REG, EAX);                                                                         \
             if (cpu_state.abrt)                                                                                   \
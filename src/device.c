@@ -716,6 +716,28 @@ device_get_instance(void)
     return device_current.instance;
 }
 
+/* Name of the device being initialized, or NULL outside of device init. */
+const char *
+device_get_current_name(void)
+{
+    return device_current.dev ? device_current.dev->name : NULL;
+}
+
+/* Name of the device instance whose state is priv, or NULL if none is. */
+const char *
+device_get_priv_name(const void *priv)
+{
+    if (priv == NULL)
+        return NULL;
+
+    for (uint16_t c = 0; c < DEVICE_MAX; c++) {
+        if ((devices[c] != NULL) && (device_priv[c] == priv))
+            return devices[c]->name;
+    }
+
+    return NULL;
+}
+
 const char *
 device_get_config_string(const char *str)
 {
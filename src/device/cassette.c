@@ -633,7 +633,7 @@ pc_cas_advance(pc_cassette_t *cas)
     if (cycles <= cassette_cycles)
         ticks = (cassette_cycles - cycles);
     else
-        ticks = (cassette_cycles + (cpu_s->rspeed / 100) - cycles);
+        ticks = (cassette_cycles + (int32_t) (((uint64_t) cpu_s->rspeed * pace_slice_ms) / 1000) - cycles);
     cassette_cycles = cycles;
 
     pc_cas_clock(cas, ticks);
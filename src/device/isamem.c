@@ -377,6 +377,14 @@ ems_out(uint16_t port, uint8_t val, void *priv)
                 isamem_log("ISAMEM: map port %04X, page %i, starting at %08X: %08X -> %08X\n", port,
                            vpage, *dev->frame_addr,
                            *dev->frame_addr + (EMS_PGSIZE * (vpage & 3)), dev->addr - dev->ram);
+
+                /* Already mapped at this address, so just switch banks. */
+                if (dev->mapping.enable && (dev->mapping.base == (*dev->frame_addr + (EMS_PGSIZE * vpage)))) {
+                    mem_mapping_switch_exec(&dev->mapping, dev->addr);
+                    break;
+                }
+
+                mem_mapping_batch_begin();
                 mem_mapping_set_addr(&dev->mapping, *dev->frame_addr + (EMS_PGSIZE * vpage), EMS_PGSIZE);
 
                 /* Update the EMS RAM address for this page. */
@@ -384,6 +392,7 @@ ems_out(uint16_t port, uint8_t val, void *priv)
 
                 /* Enable this page. */
                 mem_mapping_enable(&dev->mapping);
+                mem_mapping_batch_commit();
             } else {
                 isamem_log("ISAMEM: map port %04X, page %i, starting at %08X: %08X -> N/A\n",
                            port, vpage, *dev->frame_addr, *dev->frame_addr + (EMS_PGSIZE * vpage));
@@ -451,13 +460,21 @@ consecutive_ems_out(uint16_t port, uint8_t val, void *priv)
             dev->ems[vpage].enabled = 0;
         }
 
-        if (dev->ems[vpage].enabled) {
+        if (dev->ems[vpage].enabled && dev->ems[vpage].mapping.enable) {
+            /* Already mapped, so just switch banks. */
+            mem_mapping_switch_exec(&dev->ems[vpage].mapping,
+                                    dev->ems[vpage].addr);
+        } else if (dev->ems[vpage].enabled) {
+            mem_mapping_batch_begin();
+
             /* Update the EMS RAM address for this page. */
             mem_mapping_set_exec(&dev->ems[vpage].mapping,
                                  dev->ems[vpage].addr);
 
             /* Enable this page. */
             mem_mapping_enable(&dev->ems[vpage].mapping);
+
+            mem_mapping_batch_commit();
         } else {
             /* Disable this page. */
             mem_mapping_disable(&dev->ems[vpage].mapping);
@@ -2222,6 +2222,90 @@ ide_readl(uint16_t addr, void *priv)
     return ret;
 }
 
+/*
+   The buffer for a block transfer on the data port, and how many words can be
+   moved before the one that ends the sector or DRQ block, which is left to
+   ide_read_data()/ide_write_data().
+ */
+static uint8_t *
+ide_block_buffer(ide_t *ide, int write, int *words)
+{
+    const scsi_common_t *dev = ide->sc;
+    uint8_t             *buf;
+    int                  avail;
+
+    if ((ide->type == IDE_NONE) || (ide->type & IDE_SHADOW) || (ide->buffer == NULL) || (ide->tf->pos & 1))
+        return NULL;
+
+    if (ide->command == WIN_PACKETCMD) {
+        if ((ide->type != IDE_ATAPI) || (dev == NULL) || (dev->temp_buffer == NULL) ||
+            (dev->packet_status != (write ? PHASE_DATA_OUT : PHASE_DATA_IN)))
+            return NULL;
+
+        buf   = dev->temp_buffer;
+        avail = MIN((int) dev->max_transfer_len - dev->request_pos,
+                    (int) dev->packet_len - (int) ide->tf->pos);
+    } else {
+        buf   = (uint8_t *) ide->buffer;
+        avail = 512 - (int) ide->tf->pos;
+    }
+
+    *words = (avail > 0) ? ((avail - 1) >> 1) : 0;
+    return buf;
+}
+
+static void
+ide_block_advance(ide_t *ide, int words)
+{
+    ide->tf->pos += words << 1;
+    if (ide->command == WIN_PACKETCMD)
+        ide->sc->request_pos += words << 1;
+}
+
+static int
+ide_readw_block(uint16_t addr, void *buf, int count, void *priv)
+{
+    const ide_board_t *dev = (ide_board_t *) priv;
+    ide_t             *ide = ide_drives[dev->cur_dev];
+    const uint8_t     *src;
+    int                words;
+
+    if (addr & 0x7)
+        return 0;
+
+    src = ide_block_buffer(ide, 0, &words);
+    if ((src == NULL) || (words == 0))
+        return 0;
+
+    words = MIN(words, count);
+    memcpy(buf, src + ide->tf->pos, words << 1);
+    ide_block_advance(ide, words);
+
+    return words;
+}
+
+static int
+ide_writew_block(uint16_t addr, const void *buf, int count, void *priv)
+{
+    const ide_board_t *dev = (ide_board_t *) priv;
+    ide_t             *ide = ide_drives[dev->cur_dev];
+    uint8_t           *dst;
+    int                words;
+
+    if (addr & 0x7)
+        return 0;
+
+    dst = ide_block_buffer(ide, 1, &words);
+    if ((dst == NULL) || (words == 0))
+        return 0;
+
+    words = MIN(words, count);
+    memcpy(dst + ide->tf->pos, buf, words << 1);
+    ide_block_advance(ide, words);
+
+    return words;
+}
+
 static void
 ide_board_callback(void *priv)
 {
@@ -2762,10 +2846,11 @@ ide_handlers(uint8_t board, int set)
 {
     if (ide_boards[board] != NULL) {
         if (ide_boards[board]->base[0]) {
-            io_handler(set, ide_boards[board]->base[0], 8,
-                       ide_readb, ide_readw, ide_readl,
-                       ide_writeb, ide_writew, ide_writel,
-                       ide_boards[board]);
+            io_handler_block(set, ide_boards[board]->base[0], 8,
+                             ide_readb, ide_readw, ide_readl,
+                             ide_writeb, ide_writew, ide_writel,
+                             ide_readw_block, ide_writew_block,
+                             ide_boards[board]);
         }
 
         if (ide_boards[board]->base[1]) {
@@ -94,6 +94,7 @@ extern int video_fps; /* (O) render speed in fps */
 #endif
 extern int settings_only;     /* (O) show only the settings dialog */
 extern int confirm_exit_cmdl; /* (O) do not ask for confirmation on quit if set to 0 */
+extern int unthrottled;       /* (O) run as fast as the host allows */
 #ifdef _WIN32
 extern uint64_t unique_id;
 extern uint64_t source_hwnd;
@@ -146,6 +147,15 @@ extern int      cpu;                        /* (C) cpu type */
 extern int      cpu_use_dynarec;            /* (C) cpu uses/needs Dyna */
 extern int      fpu_type;                   /* (C) fpu type */
 extern int      fpu_softfloat;              /* (C) fpu uses softfloat */
+extern int      dynarec_blocks;             /* (C) dynarec code block pool size, 0 = default */
+extern int      dynarec_mem_blocks;         /* (C) dynarec code memory pool size, 0 = default */
+extern int      dynarec_perf_map;           /* (C) write profiler symbols for dynarec code */
+extern int      dynarec_async_compile;      /* (C) compile hot dynarec blocks on a background thread */
+extern int      mem_huge_pages;             /* (C) back guest RAM with huge pages */
+extern int      mem_merge_pages;            /* (C) let KSM merge identical guest RAM pages */
+extern int      rom_share;                  /* (C) map ROM images from their files */
+extern int      cpu_idle_skip;              /* (C) skip ahead when the guest is idle */
+extern int      pace_slice_ms;              /* (C) emulated time run per slice */
 extern int      time_sync;                  /* (C) enable time sync */
 extern int      hdd_format_type;            /* (C) hard disk file format */
 extern int      lba_enhancer_enabled;       /* (C) enable Vision Systems LBA Enhancer */
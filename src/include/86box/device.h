@@ -232,6 +232,8 @@ extern void        device_set_config_hex20(const char *str, int val);
 extern void        device_set_config_mac(const char *str, int val);
 extern const char *device_get_config_string(const char *name);
 extern int         device_get_instance(void);
+extern const char *device_get_current_name(void);
+extern const char *device_get_priv_name(const void *priv);
 #define device_get_config_bios device_get_config_string
 
 extern const char *device_get_internal_name(const device_t *dev);
@@ -134,6 +134,14 @@
 #define MEM_GRANULARITY_PAGE   (MEM_GRANULARITY_MASK & ~0xfff)
 #define MEM_GRANULARITY_BASE   (~MEM_GRANULARITY_MASK)
 
+/* Software TLB: live readlookup2/writelookup2 entries are tracked in
+   TLB_SETS sets of TLB_WAYS, picked by the low bits of the virtual page. */
+#define TLB_SETS   128
+#define TLB_WAYS   8
+#define TLB_SIZE   (TLB_SETS * TLB_WAYS)
+#define TLB_GLOBAL 1 /* Mapped by a global (G) page, kept across CR3 loads with CR4.PGE. */
+#define TLB_LARGE  2 /* Mapped by a 4MB or 2MB page. */
+
 /* Compatibility #defines. */
 #define mem_set_state(smm, mode, base, size, access) \
     mem_set_access((smm ? ACCESS_SMM : ACCESS_NORMAL), mode, base, size, access)
@@ -170,6 +178,30 @@ typedef union mem_state_t {
     state_t  states[4];
 } mem_state_t;
 
+typedef struct tlb_stats_t {
+    uint64_t read_lookups; /* Only counted with USE_TLB_STATS. */
+    uint64_t write_lookups;
+    uint64_t walks;        /* Page table walks. */
+    uint64_t read_fills;
+    uint64_t write_fills;
+    uint64_t evictions;
+    uint64_t flushes;      /* Full flushes. */
+    uint64_t cr3_flushes;
+    uint64_t global_kept;  /* Entries kept by CR3 flushes. */
+    uint64_t invlpgs;
+    uint64_t smm_switches;
+} tlb_stats_t;
+
+typedef struct mem_mapping_stats_t {
+    uint64_t recalcs;
+    uint64_t deferred;     /* Recalculations merged into a batch. */
+    uint64_t batches;
+    uint64_t granules;     /* Granules recalculated. */
+    uint64_t maps_visited; /* Mappings checked by recalculations. */
+    uint64_t ns;           /* Time spent recalculating. */
+    uint64_t switches;     /* Bank switches done without recalculating. */
+} mem_mapping_stats_t;
+
 typedef struct _mem_mapping_ {
     struct _mem_mapping_ *prev;
     struct _mem_mapping_ *next;
@@ -193,6 +225,12 @@ typedef struct _mem_mapping_ {
 
     uint32_t flags;
 
+    /* Position in the mapping list, and the range it is indexed under. */
+    uint32_t seq;
+    uint32_t index_base;
+    uint32_t index_size;
+    uint32_t index_stamp;
+
     /* There is never a needed to pass a pointer to the mapping itself, it is much preferable to
        prepare a structure with the requires data (usually, the base address and mask) instead. */
     void *priv; /* backpointer to device */
@@ -264,14 +302,16 @@ extern uint8_t *rom;
 extern uint32_t biosmask;
 extern uint32_t biosaddr;
 
-extern int        readlookup[256];
-extern uintptr_t *readlookup2;
-extern uintptr_t  old_rl2;
-extern uint8_t    uncached;
-extern int        readlnext;
-extern int        writelookup[256];
-extern uintptr_t *writelookup2;
-extern int        writelnext;
+extern int                 readlookup[TLB_SIZE];
+extern uintptr_t          *readlookup2;
+extern uintptr_t           old_rl2;
+extern uint8_t             uncached;
+extern uint8_t             readlnext[TLB_SETS];
+extern int                 writelookup[TLB_SIZE];
+extern uintptr_t          *writelookup2;
+extern uint8_t             writelnext[TLB_SETS];
+extern tlb_stats_t         tlb_stats;
+extern mem_mapping_stats_t mem_mapping_stats;
 extern uint32_t   ram_mapped_addr[64];
 extern uint8_t    page_ff[4096];
 
@@ -402,10 +442,13 @@ extern void mem_mapping_set_addr(mem_mapping_t *,
                                  uint32_t base, uint32_t size);
 extern void mem_mapping_set_base_ignore(mem_mapping_t *, uint32_t base_ignore);
 extern void mem_mapping_set_exec(mem_mapping_t *, uint8_t *exec);
+extern void mem_mapping_switch_exec(mem_mapping_t *, uint8_t *exec);
 extern void mem_mapping_set_mask(mem_mapping_t *, uint32_t mask);
 extern void mem_mapping_disable(mem_mapping_t *);
 extern void mem_mapping_enable(mem_mapping_t *);
 extern void mem_mapping_recalc(uint64_t base, uint64_t size);
+extern void mem_mapping_batch_begin(void);
+extern void mem_mapping_batch_commit(void);
 
 extern void mem_set_wp(uint64_t base, uint64_t size, uint8_t flags, uint8_t wp);
 extern void mem_set_access(uint8_t bitmap, int mode, uint32_t base, uint32_t size, uint16_t access);
@@ -442,6 +485,7 @@ extern void mem_invalidate_range(uint32_t start_addr, uint32_t end_addr);
 extern void mem_write_ramb_page(uint32_t addr, uint8_t val, page_t *page);
 extern void mem_write_ramw_page(uint32_t addr, uint16_t val, page_t *page);
 extern void mem_write_raml_page(uint32_t addr, uint32_t val, page_t *page);
+extern void mem_write_ram_page_dirty(uint32_t addr, uint32_t len, page_t *page);
 extern void mem_flush_write_page(uint32_t addr, uint32_t virt);
 
 extern void mem_reset_page_blocks(void);
@@ -450,6 +494,13 @@ extern void flushmmucache(void);
 extern void flushmmucache_write(void);
 extern void flushmmucache_pc(void);
 extern void flushmmucache_nopc(void);
+extern void flushmmucache_cr3(void);
+extern void flushmmucache_page(uint32_t addr);
+extern void mem_smm_switch(void);
+
+extern void mem_dtlb_attach(void);
+extern int  mem_dtlb_read(uint64_t *misses);
+extern void mem_host_usage(uint64_t *rss, uint64_t *ram_resident, uint64_t *ram_merged);
 
 extern void mem_debug_check_addr(uint32_t addr, int write);
 
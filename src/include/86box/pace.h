@@ -0,0 +1,48 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Definitions for the emulation thread pacer.
+ */
+#ifndef EMU_PACE_H
+#define EMU_PACE_H
+
+#define PACE_SLICE_MIN 1
+#define PACE_SLICE_MAX 10
+
+typedef struct pace_stats_t {
+    uint64_t slices;      /* slices run in real time */
+    uint64_t overruns;    /* slices that finished after the next one was due */
+    uint64_t late_ns;     /* total time by which overrunning slices were late */
+    uint64_t late_max_ns;
+    uint64_t run_ns;      /* host time spent running slices */
+    uint64_t run_max_ns;
+    uint64_t sleep_ns;    /* host time spent waiting for deadlines */
+    uint64_t wake_ns;     /* total time woken up after the deadline */
+    uint64_t wake_max_ns;
+    uint64_t dropped_ns;  /* emulated time given up when too far behind */
+} pace_stats_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Restart the schedule from now, after a pause or other stall. */
+extern void pace_reset(void);
+/* Wait until the next slice is due. */
+extern void pace_wait(void);
+/* Account for the slice run since pace_wait(). */
+extern void pace_done(void);
+
+extern void pace_get_stats(pace_stats_t *stats);
+extern void pace_clear_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /*EMU_PACE_H*/
@@ -36,6 +36,7 @@ typedef struct rom_t {
     uint8_t      *rom;
     int           sz;
     uint32_t      mask;
+    int           mapped; /* rom is mapped from the image file */
     mem_mapping_t mapping;
 } rom_t;
 
@@ -92,5 +93,6 @@ extern int rom_init_interleaved(rom_t *rom, const char *fn_low,
                                 const char *fn_high, uint32_t address,
                                 int size, int mask, int file_offset,
                                 uint32_t flags);
+extern void rom_close(rom_t *rom);
 
 #endif /*EMU_ROM_H*/
@@ -27,15 +27,8 @@ typedef struct _smram_ {
     uint32_t host_base;
     uint32_t ram_base;
     uint32_t size;
-    uint32_t old_host_base;
-    uint32_t old_size;
 } smram_t;
 
-/* Make a backup copy of host_base and size of all the SMRAM structs, needed so that if
-   the SMRAM mappings change while in SMM, they will be recalculated on return. */
-extern void smram_backup_all(void);
-/* Recalculate any mappings, including the backup if returning from SMM. */
-extern void smram_recalc_all(int ret);
 /* Delete a SMRAM mapping. */
 extern void smram_del(smram_t *smr);
 /* Add a SMRAM mapping. */
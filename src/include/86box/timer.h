@@ -1,6 +1,8 @@
 #ifndef _TIMER_H_
 #define _TIMER_H_
 
+#include <stdio.h>
+
 extern uint64_t tsc;
 
 /* Maximum period, currently 1 second. */
@@ -50,8 +52,12 @@ typedef struct pc_timer_t {
     void (*callback)(void *priv);
     void *priv;
 
-    struct pc_timer_t *prev;
-    struct pc_timer_t *next;
+    uint32_t heap_pos; /* 1-based position in the heap of enabled timers,
+                          0 when not in it. */
+    uint32_t seq;      /* Order the timer was enabled in, to break ties. */
+
+    const char *dev_name; /* Device being initialized when the timer was added. */
+    uint32_t    prof;     /* 1-based profile entry last used, 0 if none. */
 } pc_timer_t;
 
 #ifdef __cplusplus
@@ -188,6 +194,16 @@ extern void timer_on_auto(pc_timer_t *timer, double period);
 /* Change TSC, taking into account the timers. */
 extern void timer_set_new_tsc(uint64_t new_tsc);
 
+/* Run a timer micro-benchmark, returning the host time taken in ns. */
+extern uint64_t timer_bench(uint32_t timers_num, uint32_t fires, uint64_t *arms);
+
+/* Per-callback profiling of fire counts and host time. */
+extern int  timer_prof_enabled;
+extern void timer_prof_enable(int enable);
+extern void timer_prof_reset(void);
+/* Print the top entries by host time, all of them if top <= 0, as CSV if csv is set. */
+extern void timer_prof_print(FILE *fp, int top, int csv);
+
 #ifdef __cplusplus
 }
 #endif
@@ -43,6 +43,9 @@ typedef struct _io_ {
     void (*outw)(uint16_t addr, uint16_t val, void *priv);
     void (*outl)(uint16_t addr, uint32_t val, void *priv);
 
+    int (*insw)(uint16_t addr, void *buf, int count, void *priv);
+    int (*outsw)(uint16_t addr, const void *buf, int count, void *priv);
+
     void *priv;
 
     struct _io_ *prev, *next;
@@ -109,15 +112,17 @@ io_init(void)
     }
 }
 
-void
-io_sethandler_common(uint16_t base, int size,
-                     uint8_t (*inb)(uint16_t addr, void *priv),
-                     uint16_t (*inw)(uint16_t addr, void *priv),
-                     uint32_t (*inl)(uint16_t addr, void *priv),
-                     void (*outb)(uint16_t addr, uint8_t val, void *priv),
-                     void (*outw)(uint16_t addr, uint16_t val, void *priv),
-                     void (*outl)(uint16_t addr, uint32_t val, void *priv),
-                     void *priv, int step)
+static void
+io_sethandler_full(uint16_t base, int size,
+                   uint8_t (*inb)(uint16_t addr, void *priv),
+                   uint16_t (*inw)(uint16_t addr, void *priv),
+                   uint32_t (*inl)(uint16_t addr, void *priv),
+                   void (*outb)(uint16_t addr, uint8_t val, void *priv),
+                   void (*outw)(uint16_t addr, uint16_t val, void *priv),
+                   void (*outl)(uint16_t addr, uint32_t val, void *priv),
+                   int (*insw)(uint16_t addr, void *buf, int count, void *priv),
+                   int (*outsw)(uint16_t addr, const void *buf, int count, void *priv),
+                   void *priv, int step)
 {
     io_t *p;
     io_t *q = NULL;
@@ -142,6 +147,9 @@ io_sethandler_common(uint16_t base, int size,
         q->outw = outw;
         q->outl = outl;
 
+        q->insw  = insw;
+        q->outsw = outsw;
+
         q->priv = priv;
         q->next = NULL;
 
@@ -151,6 +159,19 @@ io_sethandler_common(uint16_t base, int size,
     }
 }
 
+void
+io_sethandler_common(uint16_t base, int size,
+                     uint8_t (*inb)(uint16_t addr, void *priv),
+                     uint16_t (*inw)(uint16_t addr, void *priv),
+                     uint32_t (*inl)(uint16_t addr, void *priv),
+                     void (*outb)(uint16_t addr, uint8_t val, void *priv),
+                     void (*outw)(uint16_t addr, uint16_t val, void *priv),
+                     void (*outl)(uint16_t addr, uint32_t val, void *priv),
+                     void *priv, int step)
+{
+    io_sethandler_full(base, size, inb, inw, inl, outb, outw, outl, NULL, NULL, priv, step);
+}
+
 void
 io_removehandler_common(uint16_t base, int size,
                         uint8_t (*inb)(uint16_t addr, void *priv),
@@ -282,6 +303,29 @@ io_handler_interleaved(int set, uint16_t base, int size,
     io_handler_common(set, base, size, inb, inw, inl, outb, outw, outl, priv, 2);
 }
 
+/* As io_handler(), with block handlers for REP INSW/OUTSW on word ports. They
+   transfer up to count words between the port and buf, and return how many
+   they did. They may stop early, or do nothing, when the next word has side
+   effects (end of a sector, an interrupt, etc.), and leave that to the word
+   handlers. The handlers are removed along with the others by io_handler(). */
+void
+io_handler_block(int set, uint16_t base, int size,
+                 uint8_t (*inb)(uint16_t addr, void *priv),
+                 uint16_t (*inw)(uint16_t addr, void *priv),
+                 uint32_t (*inl)(uint16_t addr, void *priv),
+                 void (*outb)(uint16_t addr, uint8_t val, void *priv),
+                 void (*outw)(uint16_t addr, uint16_t val, void *priv),
+                 void (*outl)(uint16_t addr, uint32_t val, void *priv),
+                 int (*insw)(uint16_t addr, void *buf, int count, void *priv),
+                 int (*outsw)(uint16_t addr, const void *buf, int count, void *priv),
+                 void *priv)
+{
+    if (set)
+        io_sethandler_full(base, size, inb, inw, inl, outb, outw, outl, insw, outsw, priv, 1);
+    else
+        io_removehandler_common(base, size, inb, inw, inl, outb, outw, outl, priv, 1);
+}
+
 #ifdef USE_DEBUG_REGS_486
 extern int trap;
 /* Set trap for I/O address breakpoints. */
@@ -812,6 +856,73 @@ outl(uint16_t port, uint32_t val)
     return;
 }
 
+/* The handler for a block transfer on port, if it is the only one that
+   inw()/outw() would call there. */
+static io_t *
+io_block_handler(uint16_t port)
+{
+    io_t *p = io[port];
+
+    if (!p || p->next || (amstrad_latch & 0x80000000))
+        return NULL;
+
+    if ((pci_flags & FLAG_CONFIG_IO_ON) && (port >= pci_base) && (port < (pci_base + pci_size)))
+        return NULL;
+    if ((pci_flags & FLAG_CONFIG_DEV0_IO_ON) && (port >= 0xc000) && (port < 0xc100))
+        return NULL;
+
+    /* Byte handlers on the next port would see half of each word. */
+    for (const io_t *q = io[(port + 1) & 0xffff]; q; q = q->next) {
+        if ((q->inb && !q->inw) || (q->outb && !q->outw))
+            return NULL;
+    }
+
+    return p;
+}
+
+/* Read up to count words from port into buf, for REP INSW. Returns the number
+   read, which is 0 if the port has no block handler. */
+int
+insw_block(uint16_t port, void *buf, int count)
+{
+    const io_t *p = io_block_handler(port);
+    int         ret;
+
+    if (!p || !p->inw || !p->insw)
+        return 0;
+
+    io_port = port;
+    ret     = p->insw(port, buf, count, p->priv);
+
+    io_log("[%04X:%08X] (%i) insw(%04X, %i) = %i\n", CS, cpu_state.pc, in_smm, port, count, ret);
+
+    return ret;
+}
+
+/* Write up to count words from buf to port, for REP OUTSW. Returns the number
+   written, which is 0 if the port has no block handler. */
+int
+outsw_block(uint16_t port, const void *buf, int count)
+{
+    const io_t *p = io_block_handler(port);
+    uint16_t    last;
+    int         ret;
+
+    if (!p || !p->outw || !p->outsw)
+        return 0;
+
+    io_port = port;
+    ret     = p->outsw(port, buf, count, p->priv);
+    if (ret > 0) {
+        memcpy(&last, (const uint8_t *) buf + ((ret - 1) << 1), 2);
+        io_val = last;
+    }
+
+    io_log("[%04X:%08X] (%i) outsw(%04X, %i) = %i\n", CS, cpu_state.pc, in_smm, port, count, ret);
+
+    return ret;
+}
+
 static uint8_t
 io_trap_readb(uint16_t addr, void *priv)
 {
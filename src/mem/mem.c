@@ -23,6 +23,12 @@
 #include <string.h>
 #include <stdlib.h>
 #include <wchar.h>
+#ifdef __linux__
+#    include <sys/mman.h>
+#    include <sys/syscall.h>
+#    include <unistd.h>
+#    include <linux/perf_event.h>
+#endif
 #define HAVE_STDARG_H
 #include <86box/86box.h>
 #include <86box/version.h>
@@ -83,14 +89,22 @@ uint32_t biosaddr;
 uint32_t pccache;
 uint8_t *pccache2;
 
-int        readlnext;
-int        readlookup[256];
+uint8_t    readlnext[TLB_SETS];
+int        readlookup[TLB_SIZE];
 uintptr_t *readlookup2;
 uintptr_t  old_rl2;
 uint8_t    uncached = 0;
-int        writelnext;
-int        writelookup[256];
+uint8_t    writelnext[TLB_SETS];
+int        writelookup[TLB_SIZE];
 uintptr_t *writelookup2;
+tlb_stats_t tlb_stats;
+
+/* TLB_GLOBAL/TLB_LARGE for each entry in readlookup[]/writelookup[]. */
+static uint8_t readlookup_flags[TLB_SIZE];
+static uint8_t writelookup_flags[TLB_SIZE];
+/* Physical page of each entry in readlookup[]/writelookup[]. */
+static uint32_t readlookup_phys[TLB_SIZE];
+static uint32_t writelookup_phys[TLB_SIZE];
 
 uint32_t mem_logical_addr;
 
@@ -98,7 +112,6 @@ int shadowbios = 0;
 int shadowbios_write;
 int readlnum  = 0;
 int writelnum = 0;
-int cachesize = 256;
 
 uint32_t get_phys_virt;
 uint32_t get_phys_phys;
@@ -134,12 +147,69 @@ static uint8_t        ff_pccache[4] = { 0xff, 0xff, 0xff, 0xff };
 static mem_state_t    _mem_state[MEM_MAPPINGS_NO];
 static uint32_t       remap_start_addr;
 static uint32_t       remap_start_addr2;
+
+/* Granules whose CPU or bus maps differ between SMM and non-SMM, with both
+   variants indexed by SMM state. */
+#define MEM_SMM_CHUNK 256
+
+typedef struct mem_smm_alt_t {
+    uint32_t       page;
+    uint8_t       *exec[2];
+    mem_mapping_t *read[2];
+    mem_mapping_t *write[2];
+    mem_mapping_t *read_bus[2];
+    mem_mapping_t *write_bus[2];
+} mem_smm_alt_t;
+
+static mem_smm_alt_t *smm_alt;
+static uint32_t       smm_alt_num;
+static uint32_t       smm_alt_size;
+static uint32_t       smm_alt_map[MEM_MAPPINGS_NO / 32];
+static int            mem_smm_active;
+
+/* Mappings are indexed by the 64 KB blocks covered by their primary range, with
+   those covering more than MEM_INDEX_LARGE blocks kept on one separate list.
+   Each list is in mapping list order, as later mappings take priority. */
+#define MEM_INDEX_SHIFT 16
+#define MEM_INDEX_NO    (1 << (32 - MEM_INDEX_SHIFT))
+#define MEM_INDEX_LARGE 16
+
+typedef struct mem_index_t {
+    mem_mapping_t **maps;
+    uint32_t        num;
+    uint32_t        size;
+} mem_index_t;
+
+static mem_index_t     mem_index[MEM_INDEX_NO];
+static mem_index_t     mem_index_large;
+static mem_index_t     mem_index_found;
+static uint32_t        mem_mapping_seq;
+static uint32_t        mem_index_stamp;
+
+/* Ranges waiting for mem_mapping_batch_commit(). */
+#define MEM_BATCH_RANGES 8
+
+static int      mem_batch_depth;
+static int      mem_batch_num;
+static uint64_t mem_batch_base[MEM_BATCH_RANGES];
+static uint64_t mem_batch_end[MEM_BATCH_RANGES];
+
+mem_mapping_stats_t mem_mapping_stats;
+
 #if (!(defined __amd64__ || defined _M_X64 || defined __aarch64__ || defined _M_ARM64))
 static size_t ram_size = 0;
 static size_t ram2_size = 0;
+static size_t ram2_alloc_size = 0;
 #else
 static size_t ram_size = 0;
 #endif
+static size_t ram_alloc_size = 0;
+
+#ifdef __linux__
+#    define MEM_HUGE_PAGE_SIZE (2 << 20)
+
+static int mem_dtlb_fd = -2; /* -2 = not opened yet */
+#endif
 
 #ifdef ENABLE_MEM_LOG
 int mem_do_log = ENABLE_MEM_LOG;
@@ -174,8 +244,8 @@ resetreadlookup(void)
     /* Initialize the page lookup table. */
     memset(page_lookup, 0x00, (1 << 20) * sizeof(page_t *));
 
-    /* Initialize the tables for lower (<= 1024K) RAM. */
-    for (uint16_t c = 0; c < 256; c++) {
+    /* Initialize the TLB entry lists. */
+    for (uint16_t c = 0; c < TLB_SIZE; c++) {
         readlookup[c]  = 0xffffffff;
         writelookup[c] = 0xffffffff;
     }
@@ -185,26 +255,69 @@ resetreadlookup(void)
 
     memset(writelookup2, 0xff, (1 << 20) * sizeof(uintptr_t));
 
-    readlnext  = 0;
-    writelnext = 0;
+    memset(readlnext, 0x00, sizeof(readlnext));
+    memset(writelnext, 0x00, sizeof(writelnext));
     pccache    = 0xffffffff;
     high_page  = 0;
 }
 
-void
-flushmmucache(void)
+static __inline void
+tlb_drop_read(int c)
+{
+    readlookup2[readlookup[c]] = LOOKUP_INV;
+    readlookup[c]              = 0xffffffff;
+}
+
+static __inline void
+tlb_drop_write(int c)
+{
+    page_lookup[writelookup[c]]  = NULL;
+    writelookup2[writelookup[c]] = LOOKUP_INV;
+    writelookup[c]               = 0xffffffff;
+}
+
+/* Drop the read and/or write lookups, except global ones if keep_global is set. */
+static void
+tlb_flush(int read, int write, int keep_global)
 {
-    for (uint16_t c = 0; c < 256; c++) {
-        if (readlookup[c] != (int) 0xffffffff) {
-            readlookup2[readlookup[c]] = LOOKUP_INV;
-            readlookup[c]              = 0xffffffff;
+    for (uint16_t c = 0; c < TLB_SIZE; c++) {
+        if (read && (readlookup[c] != (int) 0xffffffff)) {
+            if (keep_global && (readlookup_flags[c] & TLB_GLOBAL))
+                tlb_stats.global_kept++;
+            else
+                tlb_drop_read(c);
         }
-        if (writelookup[c] != (int) 0xffffffff) {
-            page_lookup[writelookup[c]]  = NULL;
-            writelookup2[writelookup[c]] = LOOKUP_INV;
-            writelookup[c]               = 0xffffffff;
+        if (write && (writelookup[c] != (int) 0xffffffff)) {
+            if (keep_global && (writelookup_flags[c] & TLB_GLOBAL))
+                tlb_stats.global_kept++;
+            else
+                tlb_drop_write(c);
         }
     }
+}
+
+void
+flushmmucache(void)
+{
+    tlb_flush(1, 1, 0);
+    tlb_stats.flushes++;
+    mmuflush++;
+
+    pccache  = (uint32_t) 0xffffffff;
+    pccache2 = (uint8_t *) 0xffffffff;
+
+#ifdef USE_DYNAREC
+    codegen_flush();
+#endif
+}
+
+/* For CR3 loads. As flushmmucache(), but global pages are kept when CR4.PGE
+   is set. */
+void
+flushmmucache_cr3(void)
+{
+    tlb_flush(1, 1, !!(cr4 & CR4_PGE));
+    tlb_stats.cr3_flushes++;
     mmuflush++;
 
     pccache  = (uint32_t) 0xffffffff;
@@ -218,13 +331,8 @@ flushmmucache(void)
 void
 flushmmucache_write(void)
 {
-    for (uint16_t c = 0; c < 256; c++) {
-        if (writelookup[c] != (int) 0xffffffff) {
-            page_lookup[writelookup[c]]  = NULL;
-            writelookup2[writelookup[c]] = LOOKUP_INV;
-            writelookup[c]               = 0xffffffff;
-        }
-    }
+    tlb_flush(0, 1, 0);
+    tlb_stats.flushes++;
     mmuflush++;
 }
 
@@ -244,17 +352,79 @@ flushmmucache_pc(void)
 void
 flushmmucache_nopc(void)
 {
-    for (uint16_t c = 0; c < 256; c++) {
-        if (readlookup[c] != (int) 0xffffffff) {
-            readlookup2[readlookup[c]] = LOOKUP_INV;
-            readlookup[c]              = 0xffffffff;
-        }
-        if (writelookup[c] != (int) 0xffffffff) {
-            page_lookup[writelookup[c]]  = NULL;
-            writelookup2[writelookup[c]] = LOOKUP_INV;
-            writelookup[c]               = 0xffffffff;
-        }
+    tlb_flush(1, 1, 0);
+    tlb_stats.flushes++;
+
+#ifdef USE_DYNAREC
+    codegen_flush();
+#endif
+}
+
+/* For INVLPG. Drops the lookups for the page containing addr, including those
+   made from a large page that covers it. */
+void
+flushmmucache_page(uint32_t addr)
+{
+    uint32_t vpage      = addr >> 12;
+    uint32_t large_mask = (cr4 & CR4_PAE) ? ~0x1ff : ~0x3ff;
+
+    for (uint16_t c = 0; c < TLB_SIZE; c++) {
+        if ((readlookup[c] != (int) 0xffffffff) &&
+            ((readlookup[c] == vpage) || ((readlookup_flags[c] & TLB_LARGE) && !((readlookup[c] ^ vpage) & large_mask))))
+            tlb_drop_read(c);
+        if ((writelookup[c] != (int) 0xffffffff) &&
+            ((writelookup[c] == vpage) || ((writelookup_flags[c] & TLB_LARGE) && !((writelookup[c] ^ vpage) & large_mask))))
+            tlb_drop_write(c);
+    }
+    tlb_stats.invlpgs++;
+
+    pccache  = (uint32_t) 0xffffffff;
+    pccache2 = (uint8_t *) 0xffffffff;
+
+#ifdef USE_DYNAREC
+    codegen_flush();
+#endif
+}
+
+/* Switch the CPU and bus maps to those for the current SMM state, dropping
+   only the lookups for granules that differ between the two. */
+void
+mem_smm_switch(void)
+{
+    int n = (!!in_smm) || (is_cxsmm && (ccr1 & CCR1_SMAC));
+
+    if (n == mem_smm_active)
+        return;
+    mem_smm_active = n;
+
+    if (!smm_alt_num)
+        return;
+
+    for (uint32_t i = 0; i < smm_alt_num; i++) {
+        const mem_smm_alt_t *alt = &smm_alt[i];
+
+        _mem_exec[alt->page]         = alt->exec[n];
+        read_mapping[alt->page]      = alt->read[n];
+        write_mapping[alt->page]     = alt->write[n];
+        read_mapping_bus[alt->page]  = alt->read_bus[n];
+        write_mapping_bus[alt->page] = alt->write_bus[n];
+    }
+
+    for (uint16_t c = 0; c < TLB_SIZE; c++) {
+        if ((readlookup[c] != (int) 0xffffffff) && (smm_alt_map[readlookup_phys[c] >> 5] & (1 << (readlookup_phys[c] & 31))))
+            tlb_drop_read(c);
+        if ((writelookup[c] != (int) 0xffffffff) && (smm_alt_map[writelookup_phys[c] >> 5] & (1 << (writelookup_phys[c] & 31))))
+            tlb_drop_write(c);
     }
+    tlb_stats.smm_switches++;
+    mmuflush++;
+
+    pccache  = (uint32_t) 0xffffffff;
+    pccache2 = (uint8_t *) 0xffffffff;
+
+#ifdef USE_DYNAREC
+    codegen_flush();
+#endif
 }
 
 void
@@ -265,7 +435,7 @@ mem_flush_write_page(uint32_t addr, uint32_t virt)
     uint32_t a;
 #endif
 
-    for (uint16_t c = 0; c < 256; c++) {
+    for (uint16_t c = 0; c < TLB_SIZE; c++) {
         if (writelookup[c] != (int) 0xffffffff) {
 #if (defined __amd64__ || defined _M_X64 || defined __aarch64__ || defined _M_ARM64)
             uintptr_t target = (uintptr_t) &ram[(uintptr_t) (addr & ~0xfff) - (virt & ~0xfff)];
@@ -279,11 +449,8 @@ mem_flush_write_page(uint32_t addr, uint32_t virt)
                 target = (uintptr_t) &ram[a];
 #endif
 
-            if (writelookup2[writelookup[c]] == target || page_lookup[writelookup[c]] == page_target) {
-                writelookup2[writelookup[c]] = LOOKUP_INV;
-                page_lookup[writelookup[c]]  = NULL;
-                writelookup[c]               = 0xffffffff;
-            }
+            if (writelookup2[writelookup[c]] == target || page_lookup[writelookup[c]] == page_target)
+                tlb_drop_write(c);
         }
     }
 }
@@ -451,6 +618,8 @@ mmutranslatereal(uint32_t addr, int rw)
     if (cpu_state.abrt)
         return 0xffffffffffffffffULL;
 
+    tlb_stats.walks++;
+
     if (cr4 & CR4_PAE)
         return mmutranslatereal_pae(addr, rw);
     else
@@ -583,12 +752,68 @@ mem_addr_translate(uint32_t addr, uint32_t chunk_start, uint32_t len)
     return chunk_start + (addr & mask);
 }
 
+/* Returns TLB_GLOBAL/TLB_LARGE for the current mapping of virt. Walks the page
+   tables without setting accessed bits or raising faults. */
+static uint8_t
+tlb_page_flags(uint32_t virt)
+{
+    uint8_t flags = 0;
+
+    if (!(cr0 >> 31))
+        return 0;
+
+    if (cr4 & CR4_PAE) {
+        uint64_t addr2 = (cr3 & ~0x1f) + ((virt >> 27) & 0x18);
+        uint64_t pde;
+        uint64_t pte;
+
+        if (!_mem_exec[addr2 >> MEM_GRANULARITY_BITS] || !(rammap64(addr2) & 1))
+            return 0;
+        addr2 = (rammap64(addr2) & 0x000000fffffff000ULL) + ((virt >> 18) & 0xff8);
+        if ((addr2 >= (1ULL << 32)) || !_mem_exec[addr2 >> MEM_GRANULARITY_BITS])
+            return 0;
+        pde = rammap64(addr2);
+        if (!(pde & 1))
+            return 0;
+        if (pde & 0x80)
+            return TLB_LARGE | ((pde & 0x100) ? TLB_GLOBAL : 0);
+        addr2 = (pde & 0x000000fffffff000ULL) + ((virt >> 9) & 0xff8);
+        if ((addr2 >= (1ULL << 32)) || !_mem_exec[addr2 >> MEM_GRANULARITY_BITS])
+            return 0;
+        pte = rammap64(addr2);
+        if (pte & 0x100)
+            flags |= TLB_GLOBAL;
+    } else {
+        uint32_t addr2 = (cr3 & ~0xfff) + ((virt >> 20) & 0xffc);
+        uint32_t pde;
+        uint32_t pte;
+
+        if (!_mem_exec[addr2 >> MEM_GRANULARITY_BITS])
+            return 0;
+        pde = rammap(addr2);
+        if (!(pde & 1))
+            return 0;
+        if ((pde & 0x80) && (cr4 & CR4_PSE))
+            return TLB_LARGE | ((pde & 0x100) ? TLB_GLOBAL : 0);
+        addr2 = (pde & ~0xfff) + ((virt >> 10) & 0xffc);
+        if (!_mem_exec[addr2 >> MEM_GRANULARITY_BITS])
+            return 0;
+        pte = rammap(addr2);
+        if (pte & 0x100)
+            flags |= TLB_GLOBAL;
+    }
+
+    return flags;
+}
+
 void
 addreadlookup(uint32_t virt, uint32_t phys)
 {
 #if (!(defined __amd64__ || defined _M_X64 || defined __aarch64__ || defined _M_ARM64))
     uint32_t a;
 #endif
+    uint32_t set;
+    int      c;
 
     if (virt == 0xffffffff)
         return;
@@ -596,10 +821,14 @@ addreadlookup(uint32_t virt, uint32_t phys)
     if (readlookup2[virt >> 12] != (uintptr_t) LOOKUP_INV)
         return;
 
-    if (readlookup[readlnext] != (int) 0xffffffff) {
-        if ((readlookup[readlnext] == ((es + DI) >> 12)) || (readlookup[readlnext] == ((es + EDI) >> 12)))
+    set = (virt >> 12) & (TLB_SETS - 1);
+    c   = (set * TLB_WAYS) + readlnext[set];
+
+    if (readlookup[c] != (int) 0xffffffff) {
+        if ((readlookup[c] == ((es + DI) >> 12)) || (readlookup[c] == ((es + EDI) >> 12)))
             uncached = 1;
-        readlookup2[readlookup[readlnext]] = LOOKUP_INV;
+        readlookup2[readlookup[c]] = LOOKUP_INV;
+        tlb_stats.evictions++;
     }
 
 #if (defined __amd64__ || defined _M_X64 || defined __aarch64__ || defined _M_ARM64)
@@ -613,8 +842,11 @@ addreadlookup(uint32_t virt, uint32_t phys)
         readlookup2[virt >> 12] = (uintptr_t) &ram[a];
 #endif
 
-    readlookup[readlnext++] = virt >> 12;
-    readlnext &= (cachesize - 1);
+    readlookup[c]       = virt >> 12;
+    readlookup_flags[c] = tlb_page_flags(virt);
+    readlookup_phys[c]  = phys >> 12;
+    readlnext[set]      = (readlnext[set] + 1) & (TLB_WAYS - 1);
+    tlb_stats.read_fills++;
 
     cycles -= 9;
 }
@@ -625,6 +857,8 @@ addwritelookup(uint32_t virt, uint32_t phys)
 #if (!(defined __amd64__ || defined _M_X64 || defined __aarch64__ || defined _M_ARM64))
     uint32_t a;
 #endif
+    uint32_t set;
+    int      c;
 
     if (virt == 0xffffffff)
         return;
@@ -632,9 +866,13 @@ addwritelookup(uint32_t virt, uint32_t phys)
     if (page_lookup[virt >> 12])
         return;
 
-    if (writelookup[writelnext] != -1) {
-        page_lookup[writelookup[writelnext]]  = NULL;
-        writelookup2[writelookup[writelnext]] = LOOKUP_INV;
+    set = (virt >> 12) & (TLB_SETS - 1);
+    c   = (set * TLB_WAYS) + writelnext[set];
+
+    if (writelookup[c] != -1) {
+        page_lookup[writelookup[c]]  = NULL;
+        writelookup2[writelookup[c]] = LOOKUP_INV;
+        tlb_stats.evictions++;
     }
 
 #ifdef USE_NEW_DYNAREC
@@ -664,8 +902,11 @@ addwritelookup(uint32_t virt, uint32_t phys)
 #endif
     }
 
-    writelookup[writelnext++] = virt >> 12;
-    writelnext &= (cachesize - 1);
+    writelookup[c]       = virt >> 12;
+    writelookup_flags[c] = tlb_page_flags(virt);
+    writelookup_phys[c]  = phys >> 12;
+    writelnext[set]      = (writelnext[set] + 1) & (TLB_WAYS - 1);
+    tlb_stats.write_fills++;
 
     cycles -= 9;
 }
@@ -2023,6 +2264,28 @@ mem_write_raml_page(uint32_t addr, uint32_t val, page_t *page)
         }
     }
 }
+
+/*Mark len bytes from addr, already written directly to page->mem, as dirty.
+  The range must not cross the page*/
+void
+mem_write_ram_page_dirty(uint32_t addr, uint32_t len, page_t *page)
+{
+    uint32_t start = addr & 0xfff;
+    uint32_t end   = start + len - 1;
+
+    for (uint32_t c = start >> PAGE_BYTE_MASK_SHIFT; c <= (end >> PAGE_BYTE_MASK_SHIFT); c++) {
+        uint64_t mask        = (uint64_t) 1 << (((c << PAGE_BYTE_MASK_SHIFT) >> PAGE_MASK_SHIFT) & PAGE_MASK_MASK);
+        int      byte_offset = c & PAGE_BYTE_MASK_OFFSET_MASK;
+        uint32_t lo          = (c == (start >> PAGE_BYTE_MASK_SHIFT)) ? (start & PAGE_BYTE_MASK_MASK) : 0;
+        uint32_t hi          = (c == (end >> PAGE_BYTE_MASK_SHIFT)) ? (end & PAGE_BYTE_MASK_MASK) : PAGE_BYTE_MASK_MASK;
+        uint64_t byte_mask   = (~(uint64_t) 0 >> (63 - hi)) & (~(uint64_t) 0 << lo);
+
+        page->dirty_mask |= mask;
+        page->byte_dirty_mask[byte_offset] |= byte_mask;
+        if (!page_in_evict_list(page) && ((page->code_present_mask & mask) || (page->byte_code_present_mask[byte_offset] & byte_mask)))
+            page_add_to_evict_list(page);
+    }
+}
 #else
 void
 mem_write_ramb_page(uint32_t addr, uint8_t val, page_t *page)
@@ -2078,6 +2341,21 @@ mem_write_raml_page(uint32_t addr, uint32_t val, page_t *page)
         *(uint32_t *) &page->mem[addr & 0xfff] = val;
     }
 }
+
+/*Mark len bytes from addr, already written directly to page->mem, as dirty.
+  The range must not cross the page*/
+void
+mem_write_ram_page_dirty(uint32_t addr, uint32_t len, page_t *page)
+{
+    uint32_t start = addr & 0xfff;
+    uint32_t end   = start + len - 1;
+
+    for (uint32_t c = start >> PAGE_MASK_SHIFT; c <= (end >> PAGE_MASK_SHIFT); c++) {
+        uint32_t granule = c << PAGE_MASK_SHIFT;
+
+        page->dirty_mask[(granule >> PAGE_MASK_INDEX_SHIFT) & PAGE_MASK_INDEX_MASK] |= (uint64_t) 1 << (c & PAGE_MASK_MASK);
+    }
+}
 #endif
 
 void
@@ -2320,18 +2598,129 @@ mem_mapping_access_allowed(uint32_t flags, uint16_t access)
     return ret;
 }
 
-void
-mem_mapping_recalc(uint64_t base, uint64_t size)
+static void
+mem_index_insert(mem_index_t *index, mem_mapping_t *map)
 {
-    mem_mapping_t *map;
-    int            n;
-    uint64_t       c;
-    uint8_t        wp;
+    uint32_t i;
 
-    if (!size || (base_mapping == NULL))
+    if (index->num == index->size) {
+        index->size = index->size ? (index->size * 2) : 4;
+        index->maps = realloc(index->maps, index->size * sizeof(mem_mapping_t *));
+        if (index->maps == NULL)
+            fatal("mem_index_insert(): out of memory\n");
+    }
+
+    /* Usually appended, as mappings are moved less often than added. */
+    for (i = index->num; (i > 0) && (index->maps[i - 1]->seq > map->seq); i--)
+        index->maps[i] = index->maps[i - 1];
+    index->maps[i] = map;
+    index->num++;
+}
+
+static void
+mem_index_remove(mem_index_t *index, const mem_mapping_t *map)
+{
+    for (uint32_t i = 0; i < index->num; i++) {
+        if (index->maps[i] == map) {
+            memmove(&index->maps[i], &index->maps[i + 1], (index->num - i - 1) * sizeof(mem_mapping_t *));
+            index->num--;
+            return;
+        }
+    }
+}
+
+static void
+mem_index_blocks(uint32_t base, uint32_t size, uint32_t *first, uint32_t *last)
+{
+    uint64_t end = MIN((uint64_t) base + size, 0x100000000ULL);
+
+    *first = base >> MEM_INDEX_SHIFT;
+    *last  = (end - 1) >> MEM_INDEX_SHIFT;
+}
+
+/* Move the mapping to its current range in the index, if it has changed. */
+static void
+mem_mapping_reindex(mem_mapping_t *map)
+{
+    uint32_t first;
+    uint32_t last;
+
+    if ((map->index_base == map->base) && (map->index_size == map->size))
+        return;
+
+    if (map->index_size) {
+        mem_index_blocks(map->index_base, map->index_size, &first, &last);
+        if ((last - first) >= MEM_INDEX_LARGE)
+            mem_index_remove(&mem_index_large, map);
+        else for (uint32_t b = first; b <= last; b++)
+            mem_index_remove(&mem_index[b], map);
+    }
+
+    map->index_base = map->base;
+    map->index_size = map->size;
+
+    if (map->size) {
+        mem_index_blocks(map->base, map->size, &first, &last);
+        if ((last - first) >= MEM_INDEX_LARGE)
+            mem_index_insert(&mem_index_large, map);
+        else for (uint32_t b = first; b <= last; b++)
+            mem_index_insert(&mem_index[b], map);
+    }
+}
+
+static void
+mem_index_reset(void)
+{
+    for (uint32_t b = 0; b < MEM_INDEX_NO; b++)
+        mem_index[b].num = 0;
+    mem_index_large.num = 0;
+    mem_mapping_seq     = 0;
+}
+
+static void
+mem_index_found_add(mem_mapping_t *map)
+{
+    if (map->index_stamp == mem_index_stamp)
         return;
+    map->index_stamp = mem_index_stamp;
+
+    mem_index_insert(&mem_index_found, map);
+}
+
+/* Collect the mappings that may cover the range into mem_index_found, in
+   mapping list order. Ranges spanning many blocks walk the whole list. */
+static void
+mem_mapping_find(uint64_t base, uint64_t size)
+{
+    uint32_t first = base >> MEM_INDEX_SHIFT;
+    uint32_t last  = (MIN(base + size, 0x100000000ULL) - 1) >> MEM_INDEX_SHIFT;
+
+    mem_index_found.num = 0;
+    mem_index_stamp++;
+
+    if ((base >= 0x100000000ULL) || ((last - first) >= MEM_INDEX_LARGE)) {
+        for (mem_mapping_t *map = base_mapping; map != NULL; map = map->next)
+            mem_index_found_add(map);
+    } else {
+        for (uint32_t b = first; b <= last; b++) {
+            for (uint32_t i = 0; i < mem_index[b].num; i++)
+                mem_index_found_add(mem_index[b].maps[i]);
+        }
+        for (uint32_t i = 0; i < mem_index_large.num; i++)
+            mem_index_found_add(mem_index_large.maps[i]);
+    }
 
-    map = base_mapping;
+    mem_mapping_stats.maps_visited += mem_index_found.num;
+}
+
+/* Walk the mappings found for the range, filling in the CPU and bus maps as
+   seen with the given SMM state. */
+static void
+mem_mapping_recalc_state(uint64_t base, uint64_t size, int n)
+{
+    mem_mapping_t *map;
+    uint64_t       c;
+    uint8_t        wp;
 
     /* Clear out old mappings. */
     for (c = base; c < base + size; c += MEM_GRANULARITY_SIZE) {
@@ -2343,7 +2732,9 @@ mem_mapping_recalc(uint64_t base, uint64_t size)
     }
 
     /* Walk mapping list. */
-    while (map != NULL) {
+    for (uint32_t i = 0; i < mem_index_found.num; i++) {
+        map = mem_index_found.maps[i];
+
         /* In range? */
         if (map->enable && (uint64_t) map->base < ((uint64_t) base + (uint64_t) size) &&
             ((uint64_t) map->base + (uint64_t) map->size) > (uint64_t) base) {
@@ -2360,7 +2751,6 @@ mem_mapping_recalc(uint64_t base, uint64_t size)
             for (i_c = i_s; i_c <= i_e; i_c += i_a) {
                 for (c = (start + i_c); c < (end + i_c); c += MEM_GRANULARITY_SIZE) {
                     /* CPU */
-                    n = (!!in_smm) || (is_cxsmm && (ccr1 & CCR1_SMAC));
                     wp = _mem_wp[c >> MEM_GRANULARITY_BITS];
 
                     if (map->exec && mem_mapping_access_allowed(map->flags,
@@ -2376,29 +2766,238 @@ mem_mapping_recalc(uint64_t base, uint64_t size)
                         read_mapping[c >> MEM_GRANULARITY_BITS] = map;
 
                     /* Bus */
-                    n |= STATE_BUS;
                     wp = _mem_wp_bus[c >> MEM_GRANULARITY_BITS];
 
                     if (!wp && (map->write_b || map->write_w || map->write_l) &&
                         mem_mapping_access_allowed(map->flags,
-                                                   _mem_state[c >> MEM_GRANULARITY_BITS].states[n].w))
+                                                   _mem_state[c >> MEM_GRANULARITY_BITS].states[n | STATE_BUS].w))
                         write_mapping_bus[c >> MEM_GRANULARITY_BITS] = map;
                     if ((map->read_b || map->read_w || map->read_l) &&
                         mem_mapping_access_allowed(map->flags,
-                                                   _mem_state[c >> MEM_GRANULARITY_BITS].states[n].r))
+                                                   _mem_state[c >> MEM_GRANULARITY_BITS].states[n | STATE_BUS].r))
                         read_mapping_bus[c >> MEM_GRANULARITY_BITS] = map;
                 }
             }
         }
-        map = map->next;
     }
+}
+
+/* Drop the SMM variants of the granules in the range. */
+static void
+mem_smm_alt_remove(uint64_t base, uint64_t size)
+{
+    uint32_t start = base >> MEM_GRANULARITY_BITS;
+    uint32_t end   = (base + size - 1) >> MEM_GRANULARITY_BITS;
+    uint32_t d     = 0;
+
+    for (uint32_t i = 0; i < smm_alt_num; i++) {
+        uint32_t page = smm_alt[i].page;
+
+        if ((page >= start) && (page <= end))
+            smm_alt_map[page >> 5] &= ~(1 << (page & 31));
+        else
+            smm_alt[d++] = smm_alt[i];
+    }
+    smm_alt_num = d;
+}
+
+static void
+mem_smm_alt_add(uint32_t page, int n, const mem_smm_alt_t *other)
+{
+    mem_smm_alt_t *alt;
+
+    if (smm_alt_num == smm_alt_size) {
+        smm_alt_size = smm_alt_size ? (smm_alt_size * 2) : 256;
+        smm_alt      = realloc(smm_alt, smm_alt_size * sizeof(mem_smm_alt_t));
+        if (smm_alt == NULL)
+            fatal("mem_smm_alt_add(): out of memory\n");
+    }
+
+    alt       = &smm_alt[smm_alt_num++];
+    *alt      = *other;
+    alt->page = page;
+
+    alt->exec[n]      = _mem_exec[page];
+    alt->read[n]      = read_mapping[page];
+    alt->write[n]     = write_mapping[page];
+    alt->read_bus[n]  = read_mapping_bus[page];
+    alt->write_bus[n] = write_mapping_bus[page];
+
+    smm_alt_map[page >> 5] |= (1 << (page & 31));
+}
+
+/* Resolve one granule with the given SMM state from the whole mapping list,
+   aliases included, as a recalculation covering it would. */
+static void
+mem_smm_alt_resolve(uint32_t page, int n, mem_smm_alt_t *alt)
+{
+    uint64_t c = (uint64_t) page << MEM_GRANULARITY_BITS;
+
+    alt->exec[n]      = NULL;
+    alt->read[n]      = NULL;
+    alt->write[n]     = NULL;
+    alt->read_bus[n]  = NULL;
+    alt->write_bus[n] = NULL;
+
+    for (mem_mapping_t *map = base_mapping; map != NULL; map = map->next) {
+        uint64_t i_a = ((~map->base_ignore) & 0xffffffffULL) + 0x00000001ULL;
+        uint64_t i_c;
+
+        if (!map->enable)
+            continue;
+
+        for (i_c = 0x00000000ULL; i_c <= map->base_ignore; i_c += i_a) {
+            if ((c >= ((uint64_t) map->base + i_c)) && (c < ((uint64_t) map->base + map->size + i_c)))
+                break;
+        }
+        if (i_c > map->base_ignore)
+            continue;
+
+        if (map->exec && mem_mapping_access_allowed(map->flags, _mem_state[page].states[n].x))
+            alt->exec[n] = map->exec + (c - map->base);
+        if (!_mem_wp[page] && (map->write_b || map->write_w || map->write_l) &&
+            mem_mapping_access_allowed(map->flags, _mem_state[page].states[n].w))
+            alt->write[n] = map;
+        if ((map->read_b || map->read_w || map->read_l) &&
+            mem_mapping_access_allowed(map->flags, _mem_state[page].states[n].r))
+            alt->read[n] = map;
+
+        if (!_mem_wp_bus[page] && (map->write_b || map->write_w || map->write_l) &&
+            mem_mapping_access_allowed(map->flags, _mem_state[page].states[n | STATE_BUS].w))
+            alt->write_bus[n] = map;
+        if ((map->read_b || map->read_w || map->read_l) &&
+            mem_mapping_access_allowed(map->flags, _mem_state[page].states[n | STATE_BUS].r))
+            alt->read_bus[n] = map;
+    }
+}
+
+/* Mappings with base_ignore also write their aliases, outside the range
+   recalculated. Where an alias granule depends on SMM, the passes for both
+   states have touched it, so resolve it again for the active state and
+   refresh its SMM variant. */
+static void
+mem_smm_alt_aliases(uint64_t base, uint64_t size, int n)
+{
+    mem_smm_alt_t  alt;
+    mem_mapping_t *map;
+    uint32_t       page;
+
+    for (uint32_t i = 0; i < mem_index_found.num; i++) {
+        map = mem_index_found.maps[i];
+
+        if (!map->enable || !map->base_ignore || ((uint64_t) map->base >= (base + size)) ||
+            (((uint64_t) map->base + (uint64_t) map->size) <= base))
+            continue;
+
+        uint64_t i_a   = ((~map->base_ignore) & 0xffffffffULL) + 0x00000001ULL;
+        uint64_t start = MAX((uint64_t) map->base, base);
+        uint64_t end   = MIN((uint64_t) map->base + (uint64_t) map->size, base + size);
+
+        for (uint64_t i_c = i_a; i_c <= map->base_ignore; i_c += i_a) {
+            for (uint64_t c = (start + i_c); c < (end + i_c); c += MEM_GRANULARITY_SIZE) {
+                if (c >= 0x100000000ULL)
+                    break;
+                if ((c >= base) && (c < (base + size)))
+                    continue;
+                page = c >> MEM_GRANULARITY_BITS;
+
+                if (smm_alt_map[page >> 5] & (1 << (page & 31)))
+                    mem_smm_alt_remove(c, MEM_GRANULARITY_SIZE);
+                if ((_mem_state[page].vals[STATE_CPU] == _mem_state[page].vals[STATE_CPU + 1]) &&
+                    (_mem_state[page].vals[STATE_BUS] == _mem_state[page].vals[STATE_BUS + 1]))
+                    continue;
+
+                mem_smm_alt_resolve(page, n, &alt);
+                _mem_exec[page]         = alt.exec[n];
+                read_mapping[page]      = alt.read[n];
+                write_mapping[page]     = alt.write[n];
+                read_mapping_bus[page]  = alt.read_bus[n];
+                write_mapping_bus[page] = alt.write_bus[n];
+
+                mem_smm_alt_resolve(page, !n, &alt);
+                if ((alt.exec[!n] != alt.exec[n]) || (alt.read[!n] != alt.read[n]) || (alt.write[!n] != alt.write[n]) ||
+                    (alt.read_bus[!n] != alt.read_bus[n]) || (alt.write_bus[!n] != alt.write_bus[n]))
+                    mem_smm_alt_add(page, n, &alt);
+            }
+        }
+    }
+}
+
+static void
+mem_mapping_recalc_range(uint64_t base, uint64_t size)
+{
+    static mem_smm_alt_t other[MEM_SMM_CHUNK];
+    uint64_t             start      = plat_timer_read_ns();
+    uint64_t             range_base = base;
+    uint64_t             range_size = size;
+    uint64_t             chunk_size;
+    uint32_t             page;
+    uint32_t             c;
+    int                  n = mem_smm_active;
+    int                  differs;
+
+    mem_mapping_stats.recalcs++;
+    mem_mapping_stats.granules += size >> MEM_GRANULARITY_BITS;
+
+    mem_mapping_find(base, size);
+    mem_smm_alt_remove(base, size);
+
+    /* Both the SMM and non-SMM maps are built, in chunks, for any granules
+       whose state depends on SMM. The active one is left in place, the other
+       is kept for mem_smm_switch(). */
+    for (; size > 0; base += chunk_size, size -= chunk_size) {
+        chunk_size = MIN(size, (uint64_t) MEM_SMM_CHUNK << MEM_GRANULARITY_BITS);
+        page       = base >> MEM_GRANULARITY_BITS;
+
+        differs = 0;
+        for (c = 0; c < (chunk_size >> MEM_GRANULARITY_BITS); c++) {
+            if ((_mem_state[page + c].vals[STATE_CPU] != _mem_state[page + c].vals[STATE_CPU + 1]) ||
+                (_mem_state[page + c].vals[STATE_BUS] != _mem_state[page + c].vals[STATE_BUS + 1])) {
+                differs = 1;
+                break;
+            }
+        }
+
+        if (differs) {
+            mem_mapping_recalc_state(base, chunk_size, !n);
+            for (c = 0; c < (chunk_size >> MEM_GRANULARITY_BITS); c++) {
+                other[c].exec[!n]      = _mem_exec[page + c];
+                other[c].read[!n]      = read_mapping[page + c];
+                other[c].write[!n]     = write_mapping[page + c];
+                other[c].read_bus[!n]  = read_mapping_bus[page + c];
+                other[c].write_bus[!n] = write_mapping_bus[page + c];
+            }
+        }
+
+        mem_mapping_recalc_state(base, chunk_size, n);
+
+        if (differs) {
+            for (c = 0; c < (chunk_size >> MEM_GRANULARITY_BITS); c++) {
+                if ((other[c].exec[!n] != _mem_exec[page + c]) || (other[c].read[!n] != read_mapping[page + c]) ||
+                    (other[c].write[!n] != write_mapping[page + c]) || (other[c].read_bus[!n] != read_mapping_bus[page + c]) ||
+                    (other[c].write_bus[!n] != write_mapping_bus[page + c]))
+                    mem_smm_alt_add(page + c, n, &other[c]);
+            }
+        }
+    }
+
+    mem_smm_alt_aliases(range_base, range_size, n);
+
+    mem_mapping_stats.ns += plat_timer_read_ns() - start;
+}
+
+static void
+mem_mapping_recalc_done(void)
+{
+    /* Catch up with any SMM state change made without a switch. */
+    mem_smm_switch();
 
     flushmmucache_nopc();
 
 #ifdef ENABLE_MEM_LOG
     pclog("\nMemory map:\n");
     mem_mapping_t *write = (mem_mapping_t *) -1, *read = (mem_mapping_t *) -1, *write_bus = (mem_mapping_t *) -1, *read_bus = (mem_mapping_t *) -1;
-    for (c = 0; c < (sizeof(write_mapping) / sizeof(write_mapping[0])); c++) {
+    for (uint32_t c = 0; c < (sizeof(write_mapping) / sizeof(write_mapping[0])); c++) {
         if ((write_mapping[c] == write) && (read_mapping[c] == read) && (write_mapping_bus[c] == write_bus) && (read_mapping_bus[c] == read_bus))
             continue;
         write = write_mapping[c];
@@ -2446,6 +3045,62 @@ mem_mapping_recalc(uint64_t base, uint64_t size)
 #endif
 }
 
+void
+mem_mapping_recalc(uint64_t base, uint64_t size)
+{
+    int i;
+
+    if (!size || (base_mapping == NULL))
+        return;
+
+    if (!mem_batch_depth) {
+        mem_mapping_recalc_range(base, size);
+        mem_mapping_recalc_done();
+        return;
+    }
+
+    /* Merge into an overlapping or adjacent pending range, or the last one if
+       there is no room for another. */
+    mem_mapping_stats.deferred++;
+    for (i = 0; i < mem_batch_num; i++) {
+        if ((base <= mem_batch_end[i]) && ((base + size) >= mem_batch_base[i]))
+            break;
+    }
+    if (i == mem_batch_num) {
+        if (mem_batch_num < MEM_BATCH_RANGES) {
+            mem_batch_base[mem_batch_num]  = base;
+            mem_batch_end[mem_batch_num++] = base + size;
+            return;
+        }
+        i = MEM_BATCH_RANGES - 1;
+    }
+    mem_batch_base[i] = MIN(mem_batch_base[i], base);
+    mem_batch_end[i]  = MAX(mem_batch_end[i], base + size);
+}
+
+/* Defer mapping recalculation until the matching mem_mapping_batch_commit(), so
+   that a chipset reprogramming several ranges recalculates them once. Nothing
+   may access memory through the changed ranges in between. Batches nest. */
+void
+mem_mapping_batch_begin(void)
+{
+    mem_batch_depth++;
+}
+
+void
+mem_mapping_batch_commit(void)
+{
+    if (--mem_batch_depth || !mem_batch_num)
+        return;
+
+    for (int i = 0; i < mem_batch_num; i++)
+        mem_mapping_recalc_range(mem_batch_base[i], mem_batch_end[i] - mem_batch_base[i]);
+    mem_batch_num = 0;
+    mem_mapping_stats.batches++;
+
+    mem_mapping_recalc_done();
+}
+
 void
 mem_set_wp(uint64_t base, uint64_t size, uint8_t flags, uint8_t wp)
 {
@@ -2495,6 +3150,8 @@ mem_mapping_set(mem_mapping_t *map,
     map->next    = NULL;
     mem_log("mem_mapping_add(): Linked list structure: %08X -> %08X -> %08X\n", map->prev, map, map->next);
 
+    mem_mapping_reindex(map);
+
     /* If the mapping is disabled, there is no need to recalc anything. */
     if (size != 0x00000000)
         mem_mapping_recalc(map->base, map->size);
@@ -2542,6 +3199,10 @@ mem_mapping_add(mem_mapping_t *map,
     }
     last_mapping = map;
 
+    map->seq        = mem_mapping_seq++;
+    map->index_base = 0x00000000;
+    map->index_size = 0x00000000;
+
     mem_mapping_set(map, base, size, read_b, read_w, read_l,
                     write_b, write_w, write_l, exec, fl, priv);
 }
@@ -2549,6 +3210,7 @@ mem_mapping_add(mem_mapping_t *map,
 void
 mem_mapping_do_recalc(mem_mapping_t *map)
 {
+    mem_mapping_reindex(map);
     mem_mapping_recalc(map->base, map->size);
 }
 
@@ -2568,6 +3230,7 @@ mem_mapping_set_handler(mem_mapping_t *map,
     map->write_w = write_w;
     map->write_l = write_l;
 
+    mem_mapping_reindex(map);
     mem_mapping_recalc(map->base, map->size);
 }
 
@@ -2581,12 +3244,15 @@ mem_mapping_set_write_handler(mem_mapping_t *map,
     map->write_w = write_w;
     map->write_l = write_l;
 
+    mem_mapping_reindex(map);
     mem_mapping_recalc(map->base, map->size);
 }
 
 void
 mem_mapping_set_addr(mem_mapping_t *map, uint32_t base, uint32_t size)
 {
+    mem_mapping_batch_begin();
+
     /* Remove old mapping. */
     map->enable = 0;
     mem_mapping_recalc(map->base, map->size);
@@ -2595,13 +3261,18 @@ mem_mapping_set_addr(mem_mapping_t *map, uint32_t base, uint32_t size)
     map->enable = 1;
     map->base   = base;
     map->size   = size;
+    mem_mapping_reindex(map);
 
     mem_mapping_recalc(map->base, map->size);
+
+    mem_mapping_batch_commit();
 }
 
 void
 mem_mapping_set_base_ignore(mem_mapping_t *map, uint32_t base_ignore)
 {
+    mem_mapping_reindex(map);
+
     /* Remove old mapping. */
     map->enable      = 0;
     mem_mapping_recalc(map->base, map->size);
@@ -2618,14 +3289,66 @@ mem_mapping_set_exec(mem_mapping_t *map, uint8_t *exec)
 {
     map->exec = exec;
 
+    mem_mapping_reindex(map);
     mem_mapping_recalc(map->base, map->size);
 }
 
+/* Bank switch: point an enabled mapping at new memory, as mem_mapping_set_exec()
+   does, but patch the maps in place rather than recalculating. Only the
+   lookups for the mapping's own pages are dropped. Falls back to a full
+   recalculation if the mapping has moved, is aliased, or covers SMRAM. */
+void
+mem_mapping_switch_exec(mem_mapping_t *map, uint8_t *exec)
+{
+    uint32_t first = map->base >> MEM_GRANULARITY_BITS;
+    uint32_t num   = map->size >> MEM_GRANULARITY_BITS;
+    uint32_t page;
+
+    if (!map->enable || !map->exec || !exec || map->base_ignore || mem_batch_depth ||
+        ((map->base | map->size) & MEM_GRANULARITY_MASK) || ((uint64_t) map->base + map->size) > 0x100000000ULL ||
+        (map->index_base != map->base) || (map->index_size != map->size)) {
+        mem_mapping_set_exec(map, exec);
+        return;
+    }
+
+    for (page = first; page < (first + num); page++) {
+        if (smm_alt_map[page >> 5] & (1 << (page & 31))) {
+            mem_mapping_set_exec(map, exec);
+            return;
+        }
+    }
+
+    /* Only the granules where this mapping's memory is in effect change. */
+    for (page = first; page < (first + num); page++) {
+        uint32_t offset = (page - first) << MEM_GRANULARITY_BITS;
+
+        if (_mem_exec[page] == (map->exec + offset))
+            _mem_exec[page] = exec + offset;
+    }
+    map->exec = exec;
+
+    for (uint16_t c = 0; c < TLB_SIZE; c++) {
+        if ((readlookup[c] != (int) 0xffffffff) && ((readlookup_phys[c] - first) < num))
+            tlb_drop_read(c);
+        if ((writelookup[c] != (int) 0xffffffff) && ((writelookup_phys[c] - first) < num))
+            tlb_drop_write(c);
+    }
+    mem_mapping_stats.switches++;
+
+    pccache  = (uint32_t) 0xffffffff;
+    pccache2 = (uint8_t *) 0xffffffff;
+
+#ifdef USE_DYNAREC
+    codegen_flush();
+#endif
+}
+
 void
 mem_mapping_set_mask(mem_mapping_t *map, uint32_t mask)
 {
     map->mask = mask;
 
+    mem_mapping_reindex(map);
     mem_mapping_recalc(map->base, map->size);
 }
 
@@ -2640,6 +3363,7 @@ mem_mapping_disable(mem_mapping_t *map)
 {
     map->enable = 0;
 
+    mem_mapping_reindex(map);
     mem_mapping_recalc(map->base, map->size);
 }
 
@@ -2648,6 +3372,7 @@ mem_mapping_enable(mem_mapping_t *map)
 {
     map->enable = 1;
 
+    mem_mapping_reindex(map);
     mem_mapping_recalc(map->base, map->size);
 }
 
@@ -2731,6 +3456,7 @@ mem_close(void)
     }
 
     base_mapping = last_mapping = 0;
+    mem_index_reset();
 }
 
 static void
@@ -2749,15 +3475,190 @@ mem_init_ram_mapping(mem_mapping_t *mapping, uint32_t base, uint32_t size)
     mem_add_ram_mapping(mapping, base, size);
 }
 
+static void mem_clear_large(void *ptr, size_t size, size_t alloc_size);
+
 void
 mem_zero(void)
 {
 #if (!(defined __amd64__ || defined _M_X64 || defined __aarch64__ || defined _M_ARM64))
     if (mem_size > 1048576)
-        memset(ram2, 0x00, ram2_size + 16);
+        mem_clear_large(ram2, ram2_size + 16, ram2_alloc_size);
+#endif
+
+    mem_clear_large(ram, ram_size + 16, ram_alloc_size);
+}
+
+/* Allocate a zeroed block for guest RAM or a lookup table. With mem_huge_pages
+   set, it is backed by huge pages where the host allows: 1 = transparent huge
+   pages, 2 = hugetlbfs pages, falling back to transparent ones. On Linux,
+   guest RAM is not reserved up front, so only the pages the guest touches are
+   committed, and with mem_merge_pages it is offered to KSM for merging. */
+static void *
+mem_alloc_large(size_t size, size_t *alloc_size, int is_ram, const char *name)
+{
+#ifdef __linux__
+    int      flags = MAP_PRIVATE | MAP_ANONYMOUS | (is_ram ? MAP_NORESERVE : 0);
+    size_t   hsize = size;
+    uint8_t *ptr;
+    uint8_t *aligned;
+
+    if (mem_huge_pages) {
+        hsize = (size + MEM_HUGE_PAGE_SIZE - 1) & ~((size_t) MEM_HUGE_PAGE_SIZE - 1);
+
+        if (mem_huge_pages == 2) {
+            /* hugetlbfs pages are reserved, so a short pool fails here rather
+               than on a guest access. */
+            ptr = mmap(NULL, hsize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (ptr != MAP_FAILED) {
+                pclog("Memory: %s backed by %zu MB of hugetlbfs pages\n", name, hsize >> 20);
+                *alloc_size = hsize;
+                return ptr;
+            }
+            pclog("Memory: no hugetlbfs pages for %s, using transparent huge pages\n", name);
+        }
+
+        /* Over-allocate so the block can start on a huge page boundary. */
+        ptr = mmap(NULL, hsize + MEM_HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (ptr == MAP_FAILED)
+            return NULL;
+        aligned = (uint8_t *) (((uintptr_t) ptr + MEM_HUGE_PAGE_SIZE - 1) & ~((uintptr_t) MEM_HUGE_PAGE_SIZE - 1));
+        if (aligned != ptr)
+            munmap(ptr, aligned - ptr);
+        munmap(aligned + hsize, (ptr + MEM_HUGE_PAGE_SIZE) - aligned);
+        ptr = aligned;
+
+        if (madvise(ptr, hsize, MADV_HUGEPAGE))
+            pclog("Memory: transparent huge pages unavailable for %s\n", name);
+    } else {
+        ptr = mmap(NULL, hsize, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (ptr == MAP_FAILED)
+            return NULL;
+    }
+
+    if (is_ram && mem_merge_pages && madvise(ptr, hsize, MADV_MERGEABLE))
+        pclog("Memory: KSM unavailable for %s\n", name);
+
+    *alloc_size = hsize;
+    return ptr;
+#else
+    *alloc_size = size;
+    return plat_mmap(size, 0);
+#endif
+}
+
+static void
+mem_free_large(void *ptr, size_t alloc_size)
+{
+#ifdef __linux__
+    munmap(ptr, alloc_size);
+#else
+    plat_munmap(ptr, alloc_size);
+#endif
+}
+
+/* Zero a block from mem_alloc_large(). On Linux the pages are dropped instead,
+   so they read back as zero without staying committed. */
+static void
+mem_clear_large(void *ptr, size_t size, size_t alloc_size)
+{
+#ifdef __linux__
+    if (!madvise(ptr, alloc_size, MADV_DONTNEED))
+        return;
+#endif
+
+    memset(ptr, 0x00, size);
+}
+
+#ifdef __linux__
+static uint64_t
+mem_resident(void *ptr, size_t size, size_t page_size)
+{
+    size_t         pages_no = (size + page_size - 1) / page_size;
+    unsigned char *vec;
+    uint64_t       ret = 0;
+
+    if ((ptr == NULL) || !(vec = malloc(pages_no)))
+        return 0;
+
+    if (!mincore(ptr, size, vec)) {
+        for (size_t c = 0; c < pages_no; c++)
+            ret += (vec[c] & 1) ? page_size : 0;
+    }
+    free(vec);
+
+    return ret;
+}
+#endif
+
+/* Host memory used by this instance, in bytes: the resident set of the whole
+   process, how much of guest RAM is resident, and how much of it KSM has
+   merged. Each is 0 if the host does not say. */
+void
+mem_host_usage(uint64_t *rss, uint64_t *ram_resident, uint64_t *ram_merged)
+{
+    *rss = *ram_resident = *ram_merged = 0;
+
+#ifdef __linux__
+    size_t             page_size = sysconf(_SC_PAGESIZE);
+    unsigned long long val;
+    FILE              *fp;
+
+    fp = fopen("/proc/self/statm", "r");
+    if (fp) {
+        if (fscanf(fp, "%*s %llu", &val) == 1)
+            *rss = val * page_size;
+        fclose(fp);
+    }
+
+    fp = fopen("/proc/self/ksm_merging_pages", "r");
+    if (fp) {
+        if (fscanf(fp, "%llu", &val) == 1)
+            *ram_merged = val * page_size;
+        fclose(fp);
+    }
+
+    *ram_resident = mem_resident(ram, ram_alloc_size, page_size);
+#    if (!(defined __amd64__ || defined _M_X64 || defined __aarch64__ || defined _M_ARM64))
+    if (mem_size > 1048576)
+        *ram_resident += mem_resident(ram2, ram2_alloc_size, page_size);
+#    endif
+#endif
+}
+
+/* Count host data TLB misses on the calling thread, which should be the one
+   running the emulation. */
+void
+mem_dtlb_attach(void)
+{
+#ifdef __linux__
+    struct perf_event_attr attr;
+
+    if (mem_dtlb_fd != -2)
+        return;
+
+    memset(&attr, 0x00, sizeof(attr));
+    attr.type           = PERF_TYPE_HW_CACHE;
+    attr.size           = sizeof(attr);
+    attr.config         = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+
+    mem_dtlb_fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    if (mem_dtlb_fd < 0)
+        mem_dtlb_fd = -1;
 #endif
+}
 
-    memset(ram, 0x00, ram_size + 16);
+/* Returns 0 if host data TLB misses are not being counted. */
+int
+mem_dtlb_read(uint64_t *misses)
+{
+#ifdef __linux__
+    if ((mem_dtlb_fd >= 0) && (read(mem_dtlb_fd, misses, sizeof(uint64_t)) == sizeof(uint64_t)))
+        return 1;
+#endif
+
+    return 0;
 }
 
 /* Reset the memory state. */
@@ -2787,13 +3688,13 @@ mem_reset(void)
     }
 
     if (ram != NULL) {
-        plat_munmap(ram, ram_size);
+        mem_free_large(ram, ram_alloc_size);
         ram      = NULL;
         ram_size = 0;
     }
 #if (!(defined __amd64__ || defined _M_X64 || defined __aarch64__ || defined _M_ARM64))
     if (ram2 != NULL) {
-        plat_munmap(ram2, ram2_size);
+        mem_free_large(ram2, ram2_alloc_size);
         ram2      = NULL;
         ram2_size = 0;
     }
@@ -2807,15 +3708,14 @@ mem_reset(void)
 #if (!(defined __amd64__ || defined _M_X64 || defined __aarch64__ || defined _M_ARM64))
     if (mem_size > 1048576) {
         ram_size = 1 << 30;
-        ram      = (uint8_t *) plat_mmap(ram_size, 0); /* allocate and clear the RAM block of the first 1 GB */
+        ram      = (uint8_t *) mem_alloc_large(ram_size, &ram_alloc_size, 1, "RAM"); /* allocate and clear the RAM block of the first 1 GB */
         if (ram == NULL) {
             fatal("Failed to allocate primary RAM block. Make sure you have enough RAM available.\n");
             return;
         }
-        memset(ram, 0x00, ram_size);
         ram2_size = m - (1 << 30);
         /* Allocate 16 extra bytes of RAM to mitigate some dynarec recompiler memory access quirks. */
-        ram2      = (uint8_t *) plat_mmap(ram2_size + 16, 0); /* allocate and clear the RAM block above 1 GB */
+        ram2      = (uint8_t *) mem_alloc_large(ram2_size + 16, &ram2_alloc_size, 1, "RAM above 1 GB"); /* allocate and clear the RAM block above 1 GB */
         if (ram2 == NULL) {
             if (config_changed == 2)
                 fatal(EMU_NAME " must be restarted for the memory amount change to be applied.\n");
@@ -2823,18 +3723,18 @@ mem_reset(void)
                 fatal("Failed to allocate secondary RAM block. Make sure you have enough RAM available.\n");
             return;
         }
-        memset(ram2, 0x00, ram2_size + 16);
     } else
 #endif
     {
         ram_size = m;
+        /* Fresh mappings read as zero, so RAM is not cleared here; writing it
+           would commit every page. */
         /* Allocate 16 extra bytes of RAM to mitigate some dynarec recompiler memory access quirks. */
-        ram      = (uint8_t *) plat_mmap(ram_size + 16, 0); /* allocate and clear the RAM block */
+        ram      = (uint8_t *) mem_alloc_large(ram_size + 16, &ram_alloc_size, 1, "RAM"); /* allocate and clear the RAM block */
         if (ram == NULL) {
             fatal("Failed to allocate RAM block. Make sure you have enough RAM available.\n");
             return;
         }
-        memset(ram, 0x00, ram_size + 16);
 #if (!(defined __amd64__ || defined _M_X64 || defined __aarch64__ || defined _M_ARM64))
         if (mem_size > 1048576)
             ram2 = &(ram[1 << 30]);
@@ -2917,8 +3817,12 @@ mem_reset(void)
     memset(read_mapping, 0x00, sizeof(read_mapping));
     memset(write_mapping_bus, 0x00, sizeof(write_mapping_bus));
     memset(read_mapping_bus, 0x00, sizeof(read_mapping_bus));
+    memset(smm_alt_map, 0x00, sizeof(smm_alt_map));
+    smm_alt_num    = 0;
+    mem_smm_active = 0;
 
     base_mapping = last_mapping = NULL;
+    mem_index_reset();
 
     /* Set the entire memory space as external. */
     memset(_mem_state, 0x00, sizeof(_mem_state));
@@ -2982,15 +3886,19 @@ mem_reset(void)
 void
 mem_init(void)
 {
+    size_t size;
+
     /* Perform a one-time init. */
     ram = rom = NULL;
     ram2      = NULL;
     pages     = NULL;
 
-    /* Allocate the lookup tables. */
-    page_lookup  = (page_t **) malloc((1 << 20) * sizeof(page_t *));
-    readlookup2  = malloc((1 << 20) * sizeof(uintptr_t));
-    writelookup2 = malloc((1 << 20) * sizeof(uintptr_t));
+    /* Allocate the lookup tables. These live for the whole session. */
+    page_lookup  = (page_t **) mem_alloc_large((1 << 20) * sizeof(page_t *), &size, 0, "page lookup table");
+    readlookup2  = mem_alloc_large((1 << 20) * sizeof(uintptr_t), &size, 0, "read lookup table");
+    writelookup2 = mem_alloc_large((1 << 20) * sizeof(uintptr_t), &size, 0, "write lookup table");
+    if (!page_lookup || !readlookup2 || !writelookup2)
+        fatal("Failed to allocate the memory lookup tables.\n");
 }
 
 static void
@@ -28,6 +28,11 @@
 #include <string.h>
 #include <stdlib.h>
 #include <wchar.h>
+#ifndef _WIN32
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
 #define HAVE_STDARG_H
 #include <86box/86box.h>
 #include "cpu.h"
@@ -56,6 +61,58 @@ rom_log(const char *fmt, ...)
 #    define rom_log(fmt, ...)
 #endif
 
+static int bios_mapped = 0;
+
+/* Map sz bytes of an image from off straight from its file, private and
+   writable, so identical images are shared through the host page cache by
+   all instances and only pages the machine writes get a private copy.
+   Returns NULL if rom_share is off or the image can not be used as is. */
+static uint8_t *
+rom_map(const char *fn, int sz, int off)
+{
+#ifndef _WIN32
+    struct stat st;
+    size_t      delta;
+    uint8_t    *ptr;
+    FILE       *fp;
+
+    if (!rom_share || (sz <= 0) || (off < 0))
+        return NULL;
+
+    fp = rom_fopen(fn, "rb");
+    if (fp == NULL)
+        return NULL;
+
+    /* Bytes past the end of the file would fault rather than read as FF. */
+    if (fstat(fileno(fp), &st) || (st.st_size < ((off_t) off + sz))) {
+        (void) fclose(fp);
+        return NULL;
+    }
+
+    delta = off & (sysconf(_SC_PAGESIZE) - 1);
+    ptr   = mmap(NULL, sz + delta, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno(fp), off - delta);
+    (void) fclose(fp);
+    if (ptr == MAP_FAILED)
+        return NULL;
+
+    rom_log("ROM: image '%s' mapped from its file\n", fn);
+
+    return ptr + delta;
+#else
+    return NULL;
+#endif
+}
+
+static void
+rom_unmap(uint8_t *ptr, int sz)
+{
+#ifndef _WIN32
+    size_t delta = (uintptr_t) ptr & (sysconf(_SC_PAGESIZE) - 1);
+
+    munmap(ptr - delta, sz + delta);
+#endif
+}
+
 void
 rom_add_path(const char *path)
 {
@@ -457,8 +514,10 @@ bios_normalize(int n, int up)
     return temp_n;
 }
 
+/* Set up the BIOS ROM buffer. If fn is given and the image fills the buffer
+   as is, it is mapped from its file and *mapped is set. */
 static uint8_t *
-rom_reset(uint32_t addr, int sz)
+rom_reset(uint32_t addr, int sz, const char *fn, int off, int *mapped)
 {
     biosaddr = bios_normalize(addr, 0);
     biosmask = bios_normalize(sz, 1) - 1;
@@ -470,9 +529,21 @@ rom_reset(uint32_t addr, int sz)
     /* If not done yet, allocate a 128KB buffer for the BIOS ROM. */
     if (rom != NULL) {
         rom_log("ROM allocated, freeing...\n");
-        free(rom);
-        rom = NULL;
+        if (bios_mapped)
+            rom_unmap(rom, bios_mapped);
+        else
+            free(rom);
+        rom         = NULL;
+        bios_mapped = 0;
     }
+
+    *mapped = 0;
+    if ((fn != NULL) && (addr == biosaddr) && (sz == (biosmask + 1)) && ((rom = rom_map(fn, sz, off)) != NULL)) {
+        bios_mapped = sz;
+        *mapped     = 1;
+        return rom;
+    }
+
     rom_log("Allocating ROM...\n");
     rom = (uint8_t *) malloc(biosmask + 1);
     rom_log("Filling ROM with FF's...\n");
@@ -580,6 +651,7 @@ bios_load(const char *fn1, const char *fn2, uint32_t addr, int sz, int off, int
     uint8_t  ret = 0;
     uint8_t *ptr = NULL;
     int      old_sz = sz;
+    int      mapped = 0;
 
     /*
         f0000, 65536 = prepare 64k rom starting at f0000, load 64k bios at 0000
@@ -587,8 +659,12 @@ bios_load(const char *fn1, const char *fn2, uint32_t addr, int sz, int off, int
         fe000, 49152 = prepare 48k rom starting at f4000, load 8k bios at a000
         fe000, 8192 = prepare 16k rom starting at fc000, load 8k bios at 2000
      */
-    if (!bios_only)
-        ptr = (flags & FLAG_AUX) ? rom : rom_reset(addr, sz);
+    if (!bios_only) {
+        if (flags & FLAG_AUX)
+            ptr = rom;
+        else
+            ptr = rom_reset(addr, sz, (flags & (FLAG_INT | FLAG_INV)) ? NULL : fn1, off, &mapped);
+    }
 
     if (!(flags & FLAG_AUX) && ((addr + sz) > 0x00100000))
         sz = 0x00100000 - addr;
@@ -598,7 +674,9 @@ bios_load(const char *fn1, const char *fn2, uint32_t addr, int sz, int off, int
         rom_log("%sing %i bytes of %sBIOS starting with ptr[%08X] (ptr = %08X)\n", (bios_only) ? "Check" : "Load", sz, (flags & FLAG_AUX) ? "auxiliary " : "", addr - biosaddr, ptr);
 #endif
 
-    if (flags & FLAG_INT)
+    if (mapped)
+        ret = 1;
+    else if (flags & FLAG_INT)
         ret = rom_load_interleaved(fn1, fn2, addr - biosaddr, sz, off, ptr);
     else {
         if (flags & FLAG_INV)
@@ -667,16 +745,23 @@ rom_init(rom_t *rom, const char *fn, uint32_t addr, int sz, int mask, int off, u
 {
     rom_log("rom_init(%08X, %s, %08X, %08X, %08X, %08X, %08X)\n", rom, fn, addr, sz, mask, off, flags);
 
-    /* Allocate a buffer for the image. */
-    rom->rom = malloc(sz);
-    memset(rom->rom, 0xff, sz);
-
-    /* Load the image file into the buffer. */
-    if (!rom_load_linear(fn, addr, sz, off, rom->rom)) {
-        /* Nope.. clean up. */
-        free(rom->rom);
-        rom->rom = NULL;
-        return (-1);
+    /* Map the image from its file if it can be used as is, rom_load_linear()
+       only loads at an offset for addresses below 256K. */
+    rom->mapped = 0;
+    if ((addr >= 0x40000) && ((rom->rom = rom_map(fn, sz, off)) != NULL))
+        rom->mapped = 1;
+    else {
+        /* Allocate a buffer for the image. */
+        rom->rom = malloc(sz);
+        memset(rom->rom, 0xff, sz);
+
+        /* Load the image file into the buffer. */
+        if (!rom_load_linear(fn, addr, sz, off, rom->rom)) {
+            /* Nope.. clean up. */
+            free(rom->rom);
+            rom->rom = NULL;
+            return (-1);
+        }
     }
 
     rom->sz   = sz;
@@ -697,7 +782,8 @@ rom_init_oddeven(rom_t *rom, const char *fn, uint32_t addr, int sz, int mask, in
     rom_log("rom_init(%08X, %08X, %08X, %08X, %08X, %08X, %08X)\n", rom, fn, addr, sz, mask, off, flags);
 
     /* Allocate a buffer for the image. */
-    rom->rom = malloc(sz);
+    rom->rom    = malloc(sz);
+    rom->mapped = 0;
     memset(rom->rom, 0xff, sz);
 
     /* Load the image file into the buffer. */
@@ -724,7 +810,8 @@ int
 rom_init_interleaved(rom_t *rom, const char *fnl, const char *fnh, uint32_t addr, int sz, int mask, int off, uint32_t flags)
 {
     /* Allocate a buffer for the image. */
-    rom->rom = malloc(sz);
+    rom->rom    = malloc(sz);
+    rom->mapped = 0;
     memset(rom->rom, 0xff, sz);
 
     /* Load the image file into the buffer. */
@@ -746,3 +833,17 @@ rom_init_interleaved(rom_t *rom, const char *fnl, const char *fnh, uint32_t addr
 
     return 0;
 }
+
+void
+rom_close(rom_t *rom)
+{
+    if (rom->rom == NULL)
+        return;
+
+    if (rom->mapped)
+        rom_unmap(rom->rom, rom->sz);
+    else
+        free(rom->rom);
+    rom->rom    = NULL;
+    rom->mapped = 0;
+}
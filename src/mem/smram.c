@@ -140,57 +140,6 @@ smram_writel(uint32_t addr, uint32_t val, void *priv)
         *(uint32_t *) &(dev->mapping.exec[addr - dev->host_base]) = val;
 }
 
-/* Make a backup copy of host_base and size of all the SMRAM structs, needed so that if
-   the SMRAM mappings change while in SMM, they will be recalculated on return. */
-void
-smram_backup_all(void)
-{
-    smram_t *temp_smram = base_smram;
-    smram_t *next;
-
-    while (temp_smram != NULL) {
-        temp_smram->old_host_base = temp_smram->host_base;
-        temp_smram->old_size      = temp_smram->size;
-
-        next       = temp_smram->next;
-        temp_smram = next;
-    }
-}
-
-/* Recalculate any mappings, including the backup if returning from SMM. */
-void
-smram_recalc_all(int ret)
-{
-    smram_t *temp_smram = base_smram;
-    smram_t *next;
-
-    if (base_smram == NULL)
-        return;
-
-    if (ret) {
-        while (temp_smram != NULL) {
-            if (temp_smram->old_size != 0x00000000)
-                mem_mapping_recalc(temp_smram->old_host_base, temp_smram->old_size);
-            temp_smram->old_host_base = temp_smram->old_size = 0x00000000;
-
-            next       = temp_smram->next;
-            temp_smram = next;
-        }
-    }
-
-    temp_smram = base_smram;
-
-    while (temp_smram != NULL) {
-        if (temp_smram->size != 0x00000000)
-            mem_mapping_recalc(temp_smram->host_base, temp_smram->size);
-
-        next       = temp_smram->next;
-        temp_smram = next;
-    }
-
-    flushmmucache();
-}
-
 /* Delete a SMRAM mapping. */
 void
 smram_del(smram_t *smr)
@@ -432,6 +432,63 @@ nic_readl(uint16_t addr, void *priv)
     return (nic_read((nic_t *) priv, addr, 4));
 }
 
+/*
+ * Block transfers for REP INSW/OUTSW on the data port, in word mode.
+ * Only words that neither wrap the ring nor end the remote DMA are
+ * moved here, the rest go through asic_read()/asic_write().
+ */
+static int
+nic_block_words(nic_t *dev, uint16_t addr, int count)
+{
+    const dp8390_t *dp = dev->dp8390;
+    uint32_t        end;
+
+    if (((int) addr - (int) dev->base_address != 0x10) || !dp->DCR.wdsize || (dp->remote_dma & 1) ||
+        (dp->remote_dma < dp->mem_start) || (dp->remote_dma >= dp->mem_end))
+        return 0;
+
+    end = dp->mem_end;
+    if ((dp->remote_dma < (dp->page_stop << 8)) && ((dp->page_stop << 8) < end))
+        end = dp->page_stop << 8;
+
+    count = MIN(count, (int) (end - dp->remote_dma - 1) >> 1);
+    return MIN(count, (dp->remote_bytes - 1) >> 1);
+}
+
+static int
+nic_readw_block(uint16_t addr, void *buf, int count, void *priv)
+{
+    nic_t    *dev   = (nic_t *) priv;
+    dp8390_t *dp    = dev->dp8390;
+    int       words = nic_block_words(dev, addr, count);
+
+    if (words <= 0)
+        return 0;
+
+    memcpy(buf, &dp->mem[dp->remote_dma - dp->mem_start], words << 1);
+    dp->remote_dma += words << 1;
+    dp->remote_bytes -= words << 1;
+
+    return words;
+}
+
+static int
+nic_writew_block(uint16_t addr, const void *buf, int count, void *priv)
+{
+    nic_t    *dev   = (nic_t *) priv;
+    dp8390_t *dp    = dev->dp8390;
+    int       words = nic_block_words(dev, addr, count);
+
+    if (words <= 0)
+        return 0;
+
+    memcpy(&dp->mem[dp->remote_dma - dp->mem_start], buf, words << 1);
+    dp->remote_dma += words << 1;
+    dp->remote_bytes -= words << 1;
+
+    return words;
+}
+
 static void
 nic_write(nic_t *dev, uint32_t addr, uint32_t val, unsigned len)
 {
@@ -561,9 +618,10 @@ static void
 nic_ioset(nic_t *dev, uint16_t addr)
 {
     if (dev->is_pci) {
-        io_sethandler(addr, 32,
-                      nic_readb, nic_readw, nic_readl,
-                      nic_writeb, nic_writew, nic_writel, dev);
+        io_handler_block(1, addr, 32,
+                         nic_readb, nic_readw, nic_readl,
+                         nic_writeb, nic_writew, nic_writel,
+                         nic_readw_block, nic_writew_block, dev);
     } else {
         io_sethandler(addr, 16,
                       nic_readb, NULL, NULL,
@@ -573,9 +631,10 @@ nic_ioset(nic_t *dev, uint16_t addr)
                           nic_readb, NULL, NULL,
                           nic_writeb, NULL, NULL, dev);
         } else {
-            io_sethandler(addr + 16, 16,
-                          nic_readb, nic_readw, NULL,
-                          nic_writeb, nic_writew, NULL, dev);
+            io_handler_block(1, addr + 16, 16,
+                             nic_readb, nic_readw, NULL,
+                             nic_writeb, nic_writew, NULL,
+                             nic_readw_block, nic_writew_block, dev);
         }
     }
 }
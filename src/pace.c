@@ -0,0 +1,195 @@
+/*
+ * 86Box    A hypervisor and IBM PC system emulator that specializes in
+ *          running old operating systems and software designed for IBM
+ *          PC systems and compatibles from 1981 through fairly recent
+ *          system designs based on the PCI bus.
+ *
+ *          This file is part of the 86Box distribution.
+ *
+ *          Pacing of the emulation thread to real time.
+ *
+ *          Each slice of pace_slice_ms emulated milliseconds is due at an
+ *          absolute host time, one slice length after the previous one, and
+ *          the thread sleeps until that time rather than polling. Slices
+ *          that fall behind are run back to back until the schedule is met
+ *          again, and only the part of a backlog beyond PACE_MAX_BEHIND_NS
+ *          is given up.
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#ifdef _WIN32
+#    define WIN32_LEAN_AND_MEAN
+#    include <windows.h>
+#else
+#    include <errno.h>
+#    include <time.h>
+#endif
+#include <86box/86box.h>
+#include <86box/pace.h>
+
+#ifdef _WIN32
+#    ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#        define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#    endif
+#endif
+
+/* Largest backlog caught up on, beyond this emulated time is dropped. */
+#define PACE_MAX_BEHIND_NS 100000000ULL
+
+static uint64_t     pace_deadline;
+static uint64_t     pace_slice_ns;
+static uint64_t     pace_start;
+static int          pace_resync = 1;
+static volatile int pace_clear  = 0;
+static pace_stats_t pace_stats;
+#ifdef _WIN32
+static HANDLE   pace_timer;
+static uint64_t pace_freq;
+#endif
+
+static uint64_t
+pace_now_ns(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER count;
+
+    if (!pace_freq) {
+        LARGE_INTEGER freq;
+
+        QueryPerformanceFrequency(&freq);
+        pace_freq = freq.QuadPart;
+    }
+    QueryPerformanceCounter(&count);
+
+    return ((count.QuadPart / pace_freq) * 1000000000ULL) + (((count.QuadPart % pace_freq) * 1000000000ULL) / pace_freq);
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((uint64_t) ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+#endif
+}
+
+static void
+pace_sleep_until(uint64_t deadline)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER due;
+    uint64_t      now = pace_now_ns();
+
+    if (deadline <= now)
+        return;
+
+    /* High resolution timers need Windows 10 1803, fall back to a plain one. */
+    if (pace_timer == NULL) {
+        pace_timer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+        if (pace_timer == NULL)
+            pace_timer = CreateWaitableTimerW(NULL, TRUE, NULL);
+    }
+
+    /* Negative due times are relative, in 100 ns units. */
+    due.QuadPart = -(LONGLONG) ((deadline - now + 99) / 100);
+    if ((pace_timer != NULL) && SetWaitableTimer(pace_timer, &due, 0, NULL, NULL, FALSE))
+        WaitForSingleObject(pace_timer, INFINITE);
+    else
+        Sleep((DWORD) ((deadline - now + 999999) / 1000000));
+#elif defined(__APPLE__)
+    /* There is no clock_nanosleep(), so sleep for the time left instead. */
+    struct timespec ts;
+    uint64_t        now = pace_now_ns();
+
+    if (deadline <= now)
+        return;
+
+    ts.tv_sec  = (deadline - now) / 1000000000ULL;
+    ts.tv_nsec = (deadline - now) % 1000000000ULL;
+    nanosleep(&ts, NULL);
+#else
+    struct timespec ts;
+
+    ts.tv_sec  = deadline / 1000000000ULL;
+    ts.tv_nsec = deadline % 1000000000ULL;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+        ;
+#endif
+}
+
+void
+pace_reset(void)
+{
+    pace_resync = 1;
+}
+
+void
+pace_wait(void)
+{
+    uint64_t now = pace_now_ns();
+
+    if (pace_clear) {
+        memset(&pace_stats, 0, sizeof(pace_stats_t));
+        pace_clear = 0;
+    }
+
+    pace_slice_ns = (uint64_t) pace_slice_ms * 1000000ULL;
+
+    if (pace_resync || unthrottled) {
+        pace_deadline = now;
+        pace_resync   = 0;
+    } else if (now < pace_deadline) {
+        pace_sleep_until(pace_deadline);
+
+        pace_start = pace_now_ns();
+        pace_stats.sleep_ns += pace_start - now;
+        if (pace_start > pace_deadline) {
+            pace_stats.wake_ns += pace_start - pace_deadline;
+            if ((pace_start - pace_deadline) > pace_stats.wake_max_ns)
+                pace_stats.wake_max_ns = pace_start - pace_deadline;
+        }
+        return;
+    } else if ((now - pace_deadline) > PACE_MAX_BEHIND_NS) {
+        pace_stats.dropped_ns += now - pace_deadline - PACE_MAX_BEHIND_NS;
+        pace_deadline = now - PACE_MAX_BEHIND_NS;
+    }
+
+    pace_start = now;
+}
+
+void
+pace_done(void)
+{
+    uint64_t now = pace_now_ns();
+    uint64_t run = now - pace_start;
+
+    pace_deadline += pace_slice_ns;
+
+    /* Unthrottled slices have no deadline to be measured against. */
+    if (unthrottled)
+        return;
+
+    pace_stats.slices++;
+    pace_stats.run_ns += run;
+    if (run > pace_stats.run_max_ns)
+        pace_stats.run_max_ns = run;
+
+    if (now > pace_deadline) {
+        pace_stats.overruns++;
+        pace_stats.late_ns += now - pace_deadline;
+        if ((now - pace_deadline) > pace_stats.late_max_ns)
+            pace_stats.late_max_ns = now - pace_deadline;
+    }
+}
+
+void
+pace_get_stats(pace_stats_t *stats)
+{
+    memcpy(stats, &pace_stats, sizeof(pace_stats_t));
+}
+
+/* Cleared by the emulation thread, at the start of the next slice. */
+void
+pace_clear_stats(void)
+{
+    pace_clear = 1;
+}
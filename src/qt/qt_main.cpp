@@ -88,6 +88,7 @@ extern "C" {
 #include <86box/keyboard.h>
 #include "cpu.h"
 #include <86box/timer.h>
+#include <86box/pace.h>
 #include <86box/nvr.h>
 extern int qt_nvr_save(void);
 
@@ -435,30 +436,24 @@ main_thread_fn()
     plat_set_thread_name(nullptr, "main_thread_fn");
     framecountx = 0;
     // title_update = 1;
-    uint64_t old_time = elapsed_timer.elapsed();
-    int drawits = frames = 0;
+    frames = 0;
     is_cpu_thread = 1;
+    pace_reset();
     while (!is_quit && cpu_thread_run) {
-        /* See if it is time to run a frame of code. */
-        const uint64_t new_time = elapsed_timer.elapsed();
+        if (!dopause) {
 #ifdef USE_GDBSTUB
-        if (gdbstub_next_asap && (drawits <= 0))
-            drawits = 10;
-        else
+            if (gdbstub_next_asap)
+                pace_reset();
 #endif
-            drawits += static_cast<int>(new_time - old_time);
-        old_time = new_time;
-        if (drawits > 0 && !dopause) {
-            /* Yes, so do one frame now. */
-            drawits -= 10;
-            if (drawits > 50)
-                drawits = 0;
+            /* Wait until it is time to run a frame of code. */
+            pace_wait();
 
 #ifdef USE_INSTRUMENT
             uint64_t start_time = elapsed_timer.nsecsElapsed();
 #endif
             /* Run a block of code. */
             pc_run();
+            pace_done();
 
 #ifdef USE_INSTRUMENT
             if (instru_enabled) {
@@ -469,8 +464,9 @@ main_thread_fn()
                     break;
             }
 #endif
-            /* Every 200 frames we save the machine status. */
-            if (++frames >= 200 && nvr_dosave) {
+            /* Every 2 seconds we save the machine status. */
+            frames += pace_slice_ms;
+            if (frames >= 2000 && nvr_dosave) {
                 qt_nvr_save();
                 nvr_dosave = 0;
                 frames     = 0;
@@ -485,10 +481,10 @@ main_thread_fn()
                 pc_reset_hard_init();
             }
 
-            if (dopause)
-                ack_pause();
+            ack_pause();
 
             plat_delay_ms(1);
+            pace_reset();
         }
     }
 
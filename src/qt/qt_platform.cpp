@@ -62,6 +62,7 @@
 #ifdef Q_OS_UNIX
 #    include <pthread.h>
 #    include <sys/mman.h>
+#    include <time.h>
 #endif
 
 #ifdef Q_OS_OPENBSD
@@ -199,6 +200,36 @@ plat_timer_read(void)
     return elapsed_timer.elapsed();
 }
 
+uint64_t
+plat_timer_read_ns(void)
+{
+    return elapsed_timer.nsecsElapsed();
+}
+
+/* CPU time used by all threads of the process. */
+uint64_t
+plat_cpu_time_ns(void)
+{
+#ifdef Q_OS_WINDOWS
+    FILETIME creation_time;
+    FILETIME exit_time;
+    FILETIME kernel_time;
+    FILETIME user_time;
+
+    if (!GetProcessTimes(GetCurrentProcess(), &creation_time, &exit_time, &kernel_time, &user_time))
+        return 0;
+
+    /* FILETIMEs count 100 ns intervals. */
+    return ((((uint64_t) kernel_time.dwHighDateTime << 32) | kernel_time.dwLowDateTime) +
+            (((uint64_t) user_time.dwHighDateTime << 32) | user_time.dwLowDateTime)) * 100;
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ((uint64_t) ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+#endif
+}
+
 FILE *
 plat_fopen(const char *path, const char *mode)
 {
@@ -423,7 +454,8 @@ plat_pause(int p)
         return;
     }
 
-    if ((p == 0) && (time_sync & TIME_SYNC_ENABLED))
+    /* When unthrottled, the clock follows emulated time only. */
+    if ((p == 0) && (time_sync & TIME_SYNC_ENABLED) && !unthrottled)
         nvr_time_sync();
 
     do_pause(p);
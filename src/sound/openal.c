@@ -267,7 +267,8 @@ givealbuffer_common(const void *buf, const uint8_t src, const int size, const in
     int    state;
     ALuint buffer;
 
-    if (!initialized)
+    /* Output would run ahead of real time when unthrottled, so drop it. */
+    if (!initialized || unthrottled)
         return;
 
     alGetSourcei(source[src], AL_SOURCE_STATE, &state);
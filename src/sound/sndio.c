@@ -81,7 +81,8 @@ void givealbuffer_common(const void *buf, const uint8_t src, const int size){
 	int i;
         double gain;
 	int target_rate;
-	if(audio[src] == NULL) return;
+	/* Output would run ahead of real time when unthrottled, so drop it. */
+	if(audio[src] == NULL || unthrottled) return;
 
 	gain = sound_muted ? 0.0 : pow(10.0, (double) sound_gain / 20.0);
 
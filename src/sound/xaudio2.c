@@ -242,7 +242,8 @@ closeal(void)
 void
 givealbuffer_common(const void *buf, IXAudio2SourceVoice *sourcevoice, const size_t buflen)
 {
-    if (!initialized)
+    /* Output would run ahead of real time when unthrottled, so drop it. */
+    if (!initialized || unthrottled)
         return;
 
     (void) IXAudio2MasteringVoice_SetVolume(mastervoice, sound_muted ? 0.0 : pow(10.0, (double) sound_gain / 20.0),
@@ -1,90 +1,148 @@
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #include <wchar.h>
 #include <86box/86box.h>
 #include "cpu.h"
 #include <86box/timer.h>
+#include <86box/device.h>
+#include <86box/plat.h>
 #include <86box/nv/vid_nv_rivatimer.h>
 
 uint64_t TIMER_USEC;
 uint32_t timer_target;
 
-/*Enabled timers are stored in a linked list, with the first timer to expire at
-  the head.*/
-pc_timer_t *timer_head = NULL;
+/*Enabled timers are stored in a binary min-heap, with the first timer to expire
+  at the root. Each timer holds its 1-based position in the heap, so it can be
+  removed without a search. Timers with equal timestamps expire most recently
+  enabled first, the same order the sorted list this replaces gave them.*/
+static pc_timer_t **timer_heap      = NULL;
+static uint32_t     timer_heap_num  = 0;
+static uint32_t     timer_heap_size = 0;
+static uint32_t     timer_seq       = 0;
 
 /* Are we initialized? */
 int timer_inited = 0;
 
+/*Profile entries, one per callback and private data pair. Host time includes
+  any timers processed from within the callback*/
+typedef struct timer_prof_t {
+    void      (*callback)(void *priv);
+    void       *priv;
+    const char *name;
+    uint64_t    fires;
+    uint64_t    ns;
+} timer_prof_t;
+
+int                  timer_prof_enabled = 0;
+static timer_prof_t *timer_prof         = NULL;
+static uint32_t      timer_prof_num     = 0;
+static uint32_t      timer_prof_size    = 0;
+
 static void timer_advance_ex(pc_timer_t *timer, int start);
 
+/*True if timer a should expire before timer b*/
+static __inline int
+timer_heap_before(pc_timer_t *a, pc_timer_t *b)
+{
+    int64_t diff = (int64_t) (a->ts.ts64 - b->ts.ts64);
+
+    if (diff)
+        return diff < 0;
+
+    return (int32_t) (a->seq - b->seq) > 0;
+}
+
+static __inline void
+timer_heap_set(uint32_t pos, pc_timer_t *timer)
+{
+    timer_heap[pos - 1] = timer;
+    timer->heap_pos     = pos;
+}
+
+static void
+timer_heap_up(pc_timer_t *timer)
+{
+    uint32_t pos = timer->heap_pos;
+
+    while (pos > 1) {
+        pc_timer_t *parent = timer_heap[(pos >> 1) - 1];
+
+        if (!timer_heap_before(timer, parent))
+            break;
+        timer_heap_set(pos, parent);
+        pos >>= 1;
+    }
+    timer_heap_set(pos, timer);
+}
+
+static void
+timer_heap_down(pc_timer_t *timer)
+{
+    uint32_t pos = timer->heap_pos;
+
+    while ((pos << 1) <= timer_heap_num) {
+        uint32_t    child_pos = pos << 1;
+        pc_timer_t *child     = timer_heap[child_pos - 1];
+
+        if ((child_pos < timer_heap_num) && timer_heap_before(timer_heap[child_pos], child))
+            child = timer_heap[child_pos++];
+        if (!timer_heap_before(child, timer))
+            break;
+        timer_heap_set(pos, child);
+        pos = child_pos;
+    }
+    timer_heap_set(pos, timer);
+}
+
+static void
+timer_heap_remove(pc_timer_t *timer)
+{
+    uint32_t    pos  = timer->heap_pos;
+    pc_timer_t *last = timer_heap[--timer_heap_num];
+
+    timer->heap_pos = 0;
+    if (last == timer)
+        return;
+
+    /*Move the last timer into the hole, then restore the heap order around it*/
+    timer_heap_set(pos, last);
+    if ((pos > 1) && timer_heap_before(last, timer_heap[(pos >> 1) - 1]))
+        timer_heap_up(last);
+    else
+        timer_heap_down(last);
+}
+
 void
 timer_enable(pc_timer_t *timer)
 {
-    pc_timer_t *timer_node = timer_head;
-    int ret = 0;
-
     if (!timer_inited || (timer == NULL))
         return;
 
     if (timer->flags & TIMER_ENABLED)
         timer_disable(timer);
 
-    if (timer->next || timer->prev)
-        fatal("timer_disable(): Attempting to enable a non-isolated "
+    if (timer->heap_pos)
+        fatal("timer_enable(): Attempting to enable a queued "
               "timer incorrectly marked as disabled\n");
 
-    /*List currently empty - add to head*/
-    if (!timer_head) {
-        timer_head  = timer;
-        timer->next = timer->prev = NULL;
-        timer_target              = timer_head->ts.ts32.integer;
-        ret = 1;
-    } else if (TIMER_LESS_THAN(timer, timer_head)) {
-        timer->next      = timer_head;
-        timer->prev      = NULL;
-        timer_head->prev = timer;
-        timer_head       = timer;
-        timer_target     = timer_head->ts.ts32.integer;
-        ret = 1;
-    } else if (!timer_head->next) {
-        timer_head->next = timer;
-        timer->prev      = timer_head;
-        ret = 1;
+    if (timer_heap_num == timer_heap_size) {
+        timer_heap_size = timer_heap_size ? (timer_heap_size << 1) : 256;
+        timer_heap      = realloc(timer_heap, timer_heap_size * sizeof(pc_timer_t *));
+        if (timer_heap == NULL)
+            fatal("timer_enable(): Out of memory\n");
     }
 
-    if (ret == 0) {
-        pc_timer_t *prev = timer_head;
-        timer_node       = timer_head->next;
-
-        while (1) {
-            /*Timer expires before timer_node. Add to list in front of timer_node*/
-            if (TIMER_LESS_THAN(timer, timer_node)) {
-                timer->next      = timer_node;
-                timer->prev      = prev;
-                timer_node->prev = timer;
-                prev->next       = timer;
-                ret = 1;
-                break;
-            }
-
-            /*timer_node is last in the list. Add timer to end of list*/
-            if (!timer_node->next) {
-                timer_node->next = timer;
-                timer->prev      = timer_node;
-                ret = 1;
-                break;
-            }
-
-            prev       = timer_node;
-            timer_node = timer_node->next;
-        }
-    }
+    timer->seq = timer_seq++;
+    timer_heap_set(++timer_heap_num, timer);
+    timer_heap_up(timer);
+
+    if (timer->heap_pos == 1)
+        timer_target = timer->ts.ts32.integer;
 
-    /* Do not mark it as enabled if it has failed every single condition. */
-    if (ret == 1)
-        timer->flags |= TIMER_ENABLED;
+    timer->flags |= TIMER_ENABLED;
 }
 
 void
@@ -93,20 +151,136 @@ timer_disable(pc_timer_t *timer)
     if (!timer_inited || (timer == NULL) || !(timer->flags & TIMER_ENABLED))
         return;
 
-    if (!timer->next && !timer->prev && timer != timer_head)
-        fatal("timer_disable(): Attempting to disable an isolated "
-              "non-head timer incorrectly marked as enabled\n");
+    if (!timer->heap_pos || (timer->heap_pos > timer_heap_num) || (timer_heap[timer->heap_pos - 1] != timer))
+        fatal("timer_disable(): Attempting to disable an unqueued "
+              "timer incorrectly marked as enabled\n");
 
     timer->flags &= ~TIMER_ENABLED;
     timer->in_callback = 0;
 
-    if (timer->prev)
-        timer->prev->next = timer->next;
+    timer_heap_remove(timer);
+}
+
+static timer_prof_t *
+timer_prof_get(pc_timer_t *timer)
+{
+    timer_prof_t *entry;
+    uint32_t      c;
+
+    if (timer->prof && (timer->prof <= timer_prof_num)) {
+        entry = &timer_prof[timer->prof - 1];
+        if ((entry->callback == timer->callback) && (entry->priv == timer->priv))
+            return entry;
+    }
+
+    for (c = 0; c < timer_prof_num; c++) {
+        if ((timer_prof[c].callback == timer->callback) && (timer_prof[c].priv == timer->priv))
+            break;
+    }
+
+    if (c == timer_prof_num) {
+        if (timer_prof_num == timer_prof_size) {
+            timer_prof_size = timer_prof_size ? (timer_prof_size << 1) : 64;
+            timer_prof      = realloc(timer_prof, timer_prof_size * sizeof(timer_prof_t));
+            if (timer_prof == NULL)
+                fatal("timer_prof_get(): Out of memory\n");
+        }
+
+        entry           = &timer_prof[timer_prof_num++];
+        entry->callback = timer->callback;
+        entry->priv     = timer->priv;
+        entry->name     = device_get_priv_name(timer->priv);
+        if (entry->name == NULL)
+            entry->name = timer->dev_name;
+        entry->fires = 0;
+        entry->ns    = 0;
+    }
+
+    timer->prof = c + 1;
+    return &timer_prof[c];
+}
+
+static void
+timer_prof_call(pc_timer_t *timer)
+{
+    /*Use the index, as the callback may grow the table*/
+    uint32_t c     = timer_prof_get(timer) - timer_prof;
+    uint64_t start = plat_timer_read_ns();
+
+    timer->callback(timer->priv);
+
+    timer_prof[c].ns += plat_timer_read_ns() - start;
+    timer_prof[c].fires++;
+}
+
+void
+timer_prof_enable(int enable)
+{
+    timer_prof_enabled = !!enable;
+}
+
+void
+timer_prof_reset(void)
+{
+    /*Timers still holding an index revalidate it against the entry*/
+    timer_prof_num = 0;
+}
+
+static int
+timer_prof_compare(const void *a, const void *b)
+{
+    const timer_prof_t *entry_a = *(const timer_prof_t **) a;
+    const timer_prof_t *entry_b = *(const timer_prof_t **) b;
+
+    if (entry_a->ns != entry_b->ns)
+        return (entry_a->ns > entry_b->ns) ? -1 : 1;
+    return 0;
+}
+
+void
+timer_prof_print(FILE *fp, int top, int csv)
+{
+    timer_prof_t **sorted;
+    uint64_t       total_ns = 0;
+    uint32_t       num      = timer_prof_num;
+
+    if (csv)
+        fprintf(fp, "device,callback,priv,fires,ns,ns_per_fire\n");
     else
-        timer_head = timer->next;
-    if (timer->next)
-        timer->next->prev = timer->prev;
-    timer->prev = timer->next = NULL;
+        fprintf(fp, "Timer profile (collection %s, %u callbacks):\n", timer_prof_enabled ? "enabled" : "disabled", num);
+
+    if (!num)
+        return;
+
+    sorted = malloc(num * sizeof(timer_prof_t *));
+    if (!sorted)
+        return;
+    for (uint32_t c = 0; c < num; c++) {
+        sorted[c] = &timer_prof[c];
+        total_ns += timer_prof[c].ns;
+    }
+    qsort(sorted, num, sizeof(timer_prof_t *), timer_prof_compare);
+
+    if ((top <= 0) || ((uint32_t) top > num))
+        top = num;
+
+    if (!csv)
+        fprintf(fp, "  %-32s %-18s %12s %12s %10s %6s\n", "Device", "Callback", "Fires", "Host ms", "ns/fire", "Share");
+    for (int c = 0; c < top; c++) {
+        const timer_prof_t *entry = sorted[c];
+        double              per   = entry->fires ? ((double) entry->ns / entry->fires) : 0.0;
+
+        if (csv) {
+            fprintf(fp, "\"%s\",%p,%p,%" PRIu64 ",%" PRIu64 ",%.1f\n", entry->name ? entry->name : "",
+                    (void *) (uintptr_t) entry->callback, entry->priv, entry->fires, entry->ns, per);
+        } else {
+            fprintf(fp, "  %-32.32s %-18p %12" PRIu64 " %12.3f %10.1f %5.1f%%\n", entry->name ? entry->name : "?",
+                    (void *) (uintptr_t) entry->callback, entry->fires, entry->ns / 1000000.0, per,
+                    total_ns ? ((entry->ns * 100.0) / total_ns) : 0.0);
+        }
+    }
+
+    free(sorted);
 }
 
 void
@@ -114,20 +288,16 @@ timer_process(void)
 {
     pc_timer_t *timer;
 
-    if (!timer_head)
+    if (!timer_heap_num)
         return;
 
-    while (1) {
-        timer = timer_head;
+    while (timer_heap_num) {
+        timer = timer_heap[0];
 
         if (!TIMER_LESS_THAN_VAL(timer, (uint32_t) tsc))
             break;
 
-        timer_head = timer->next;
-        if (timer_head)
-            timer_head->prev = NULL;
-
-        timer->next = timer->prev = NULL;
+        timer_heap_remove(timer);
         timer->flags &= ~TIMER_ENABLED;
 
         if (timer->flags & TIMER_SPLIT)
@@ -138,30 +308,27 @@ timer_process(void)
                have a NULL callback when no operation
                is needed. */
             timer->in_callback = 1;
-            timer->callback(timer->priv);
+            if (timer_prof_enabled)
+                timer_prof_call(timer);
+            else
+                timer->callback(timer->priv);
             timer->in_callback = 0;
         }
     }
 
-    timer_target = timer_head->ts.ts32.integer;
+    if (timer_heap_num)
+        timer_target = timer_heap[0]->ts.ts32.integer;
 }
 
 void
 timer_close(void)
 {
-    pc_timer_t *t = timer_head;
-    pc_timer_t *r;
-
-    /* Set all timers' prev and next to NULL so it is assured that
-       timers that are not in malloc'd structs don't keep pointing
-       to timers that may be in malloc'd structs. */
-    while (t != NULL) {
-        r       = t;
-        r->prev = r->next = NULL;
-        t                 = r->next;
-    }
+    /* Mark all timers as not queued, so that timers that are not in
+       malloc'd structs don't keep pointing into the heap. */
+    for (uint32_t c = 0; c < timer_heap_num; c++)
+        timer_heap[c]->heap_pos = 0;
 
-    timer_head = NULL;
+    timer_heap_num = 0;
 
     timer_inited = 0;
 }
@@ -187,7 +354,8 @@ timer_add(pc_timer_t *timer, void (*callback)(void *priv), void *priv, int start
     timer->in_callback = 0;
     timer->priv        = priv;
     timer->flags       = 0;
-    timer->prev        = timer->next = NULL;
+    timer->heap_pos    = 0;
+    timer->dev_name    = device_get_current_name();
     if (start_timer)
         timer_set_delay_u64(timer, 0);
 }
@@ -264,27 +432,115 @@ timer_on_auto(pc_timer_t *timer, double period)
 void
 timer_set_new_tsc(uint64_t new_tsc)
 {
-    pc_timer_t *timer = NULL;
     /* Run timers already expired. */
 #ifdef USE_DYNAREC
     if (cpu_use_dynarec)
         update_tsc();
 #endif
 
-    if (!timer_head) {
+    if (!timer_heap_num) {
         tsc = new_tsc;
         return;
     }
 
-    timer = timer_head;
-    timer_target = new_tsc + (int32_t)(timer_get_ts_int(timer_head) - (uint32_t)tsc);
+    timer_target = new_tsc + (int32_t)(timer_get_ts_int(timer_heap[0]) - (uint32_t)tsc);
 
-    while (timer) {
+    /* Every timer moves by the same amount, so the heap order still holds. */
+    for (uint32_t c = 0; c < timer_heap_num; c++) {
+        pc_timer_t *timer = timer_heap[c];
         int32_t offset_from_current_tsc = (int32_t)(timer_get_ts_int(timer) - (uint32_t)tsc);
         timer->ts.ts32.integer = new_tsc + offset_from_current_tsc;
-
-        timer = timer->next;
     }
 
     tsc = new_tsc;
 }
+
+static pc_timer_t *bench_timers;
+static uint32_t    bench_timers_num;
+static uint32_t    bench_fires;
+static uint64_t    bench_arms;
+static uint32_t    bench_seed;
+
+static uint64_t
+timer_bench_delay(void)
+{
+    bench_seed = (bench_seed * 1103515245) + 12345;
+
+    /*Between 1 and 4096 cycles, with a fractional part*/
+    return ((uint64_t) ((bench_seed >> 8) & 0xfff) << 20) + (1ULL << 32);
+}
+
+static void
+timer_bench_callback(void *priv)
+{
+    pc_timer_t *timer = (pc_timer_t *) priv;
+
+    bench_fires++;
+
+    /*Re-arm the expired timer, as a periodic device would, and move another
+      one that is still pending, as a device being reprogrammed would*/
+    timer_advance_u64(timer, timer_bench_delay());
+    timer_set_delay_u64(&bench_timers[bench_seed % bench_timers_num], timer_bench_delay());
+    bench_arms += 2;
+}
+
+/*Fire timers_num private timers until fires callbacks have run, and return the
+  host time taken. The live timers are set aside meanwhile, so the emulation
+  must not be running.*/
+uint64_t
+timer_bench(uint32_t timers_num, uint32_t fires, uint64_t *arms)
+{
+    pc_timer_t **heap      = timer_heap;
+    uint32_t     heap_num  = timer_heap_num;
+    uint32_t     heap_size = timer_heap_size;
+    uint32_t     target    = timer_target;
+    uint64_t     old_tsc   = tsc;
+    int          inited    = timer_inited;
+    uint64_t     start;
+    uint64_t     ns;
+
+    bench_timers = calloc(timers_num, sizeof(pc_timer_t));
+    if ((bench_timers == NULL) || !timers_num) {
+        free(bench_timers);
+        *arms = 0;
+        return 0;
+    }
+    bench_timers_num = timers_num;
+    bench_fires      = 0;
+    bench_arms       = 0;
+    bench_seed       = 1;
+
+    timer_heap      = NULL;
+    timer_heap_num  = 0;
+    timer_heap_size = 0;
+    timer_inited    = 1;
+
+    start = plat_timer_read_ns();
+
+    for (uint32_t c = 0; c < timers_num; c++) {
+        timer_add(&bench_timers[c], timer_bench_callback, &bench_timers[c], 0);
+        timer_set_delay_u64(&bench_timers[c], timer_bench_delay());
+        bench_arms++;
+    }
+
+    while (bench_fires < fires) {
+        tsc += (int32_t) (timer_target - (uint32_t) tsc);
+        timer_process();
+    }
+
+    ns = plat_timer_read_ns() - start;
+
+    free(timer_heap);
+    free(bench_timers);
+    bench_timers = NULL;
+
+    timer_heap      = heap;
+    timer_heap_num  = heap_num;
+    timer_heap_size = heap_size;
+    timer_target    = target;
+    tsc             = old_tsc;
+    timer_inited    = inited;
+
+    *arms = bench_arms;
+    return ns;
+}
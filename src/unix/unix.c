@@ -43,6 +43,7 @@
 #include <86box/unix_sdl.h>
 #include "cpu.h"
 #include <86box/timer.h>
+#include <86box/pace.h>
 #include <86box/nvr.h>
 #include <86box/version.h>
 #include <86box/video.h>
@@ -430,6 +431,26 @@ plat_timer_read(void)
     return SDL_GetPerformanceCounter();
 }
 
+/* Monotonic host time in nanoseconds, for profiling. */
+uint64_t
+plat_timer_read_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+}
+
+/* CPU time used by all threads of the process. */
+uint64_t
+plat_cpu_time_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ((uint64_t) ts.tv_sec * 1000000000ULL) + ts.tv_nsec;
+}
+
 static uint64_t
 plat_get_ticks_common(void)
 {
@@ -543,43 +564,38 @@ strnicmp(const char *s1, const char *s2, size_t n)
 void
 main_thread(UNUSED(void *param))
 {
-    uint32_t old_time;
-    uint32_t new_time;
-    int      drawits;
-    int      frames;
+    int frames;
 
     SDL_SetThreadPriority(SDL_THREAD_PRIORITY_HIGH);
     framecountx = 0;
     // title_update = 1;
-    old_time = SDL_GetTicks();
-    drawits = frames = 0;
+    frames = 0;
+    pace_reset();
     while (!is_quit && cpu_thread_run) {
-        /* See if it is time to run a frame of code. */
-        new_time = SDL_GetTicks();
+        if (!dopause) {
 #ifdef USE_GDBSTUB
-        if (gdbstub_next_asap && (drawits <= 0))
-            drawits = 10;
-        else
+            if (gdbstub_next_asap)
+                pace_reset();
 #endif
-            drawits += (new_time - old_time);
-        old_time = new_time;
-        if (drawits > 0 && !dopause) {
-            /* Yes, so do one frame now. */
-            drawits -= 10;
-            if (drawits > 50)
-                drawits = 0;
+            /* Wait until it is time to run a frame of code. */
+            pace_wait();
 
             /* Run a block of code. */
             pc_run();
+            pace_done();
 
-            /* Every 200 frames we save the machine status. */
-            if (++frames >= 200 && nvr_dosave) {
+            /* Every 2 seconds we save the machine status. */
+            frames += pace_slice_ms;
+            if (frames >= 2000 && nvr_dosave) {
                 nvr_save();
                 nvr_dosave = 0;
                 frames     = 0;
             }
-        } else /* Just so we dont overload the host OS. */
+        } else {
+            /* Just so we dont overload the host OS. */
             SDL_Delay(1);
+            pace_reset();
+        }
 
         /* If needed, handle a screen resize. */
         if (atomic_load(&doresize_monitors[0]) && !video_fullscreen && !is_quit) {
@@ -769,7 +785,8 @@ plat_pause(int p)
     if ((!!p) == dopause)
         return;
 
-    if ((p == 0) && (time_sync & TIME_SYNC_ENABLED))
+    /* When unthrottled, the clock follows emulated time only. */
+    if ((p == 0) && (time_sync & TIME_SYNC_ENABLED) && !unthrottled)
         nvr_time_sync();
 
     do_pause(p);